@@ -8,7 +8,7 @@ public class FishingGame : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "NavigationSystem", "AIModule" });
-        PrivateDependencyModuleNames.AddRange(new string[] { "CableComponent" });
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "NavigationSystem", "AIModule", "CableComponent" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "RenderCore", "RHI", "UMG", "Slate", "SlateCore", "ReplicationGraph" });
     }
 }
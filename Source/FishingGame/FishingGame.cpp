@@ -6,4 +6,34 @@
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FishingGame, "FishingGame" );
 
 DEFINE_LOG_CATEGORY(LogFishingGame)
+
+DEFINE_STAT(STAT_FishingActorsTicked);
+DEFINE_STAT(STAT_FishSchoolMemory);
+DEFINE_STAT(STAT_FishingJournalMemory);
+
+DEFINE_STAT(STAT_FishingReadyThrowCast);
+DEFINE_STAT(STAT_FishingThrowCast);
+DEFINE_STAT(STAT_FishingLaunchHook);
+DEFINE_STAT(STAT_FishingHookFlight);
+DEFINE_STAT(STAT_FishingHookLanding);
+DEFINE_STAT(STAT_FishingStartFishing);
+DEFINE_STAT(STAT_FishingFishBite);
+DEFINE_STAT(STAT_FishingReelHook);
+DEFINE_STAT(STAT_FishingPhaseChange);
+DEFINE_STAT(STAT_FishingCursorTrace);
+DEFINE_STAT(STAT_FishingRecordCatch);
+DEFINE_STAT(STAT_FishingSignificance);
+DEFINE_STAT(STAT_FishingCrowdDecisions);
+DEFINE_STAT(STAT_FishingMoveTo);
+DEFINE_STAT(STAT_FishingStreaming);
+DEFINE_STAT(STAT_FishingScalability);
+DEFINE_STAT(STAT_FishingReplication);
+
+CSV_DEFINE_CATEGORY_MODULE(FISHINGGAME_API, Fishing, true);
+
+UE_TRACE_CHANNEL_DEFINE(FishingChannel);
+
+int32 GFishingActorsTicked = 0;
+
+bool GFishingSyncAssetLoads = false;
  
\ No newline at end of file
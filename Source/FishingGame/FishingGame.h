@@ -3,5 +3,76 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Trace/Trace.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogFishingGame, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Fishing"), STATGROUP_Fishing, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Fishing actors ticked"), STAT_FishingActorsTicked, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Fish school memory"), STAT_FishSchoolMemory, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Catch journal pending memory"), STAT_FishingJournalMemory, STATGROUP_Fishing, FISHINGGAME_API);
+
+// Entry points of the cast loop, see FISHING_SCOPE
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ReadyThrowCast"), STAT_FishingReadyThrowCast, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ThrowCast"), STAT_FishingThrowCast, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("LaunchHook"), STAT_FishingLaunchHook, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HookFlight"), STAT_FishingHookFlight, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HookLanding"), STAT_FishingHookLanding, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("StartFishing"), STAT_FishingStartFishing, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FishBite"), STAT_FishingFishBite, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ReelHook"), STAT_FishingReelHook, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PhaseChange"), STAT_FishingPhaseChange, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CursorTrace"), STAT_FishingCursorTrace, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RecordCatch"), STAT_FishingRecordCatch, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Significance"), STAT_FishingSignificance, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CrowdDecisions"), STAT_FishingCrowdDecisions, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MoveTo"), STAT_FishingMoveTo, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Streaming"), STAT_FishingStreaming, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scalability"), STAT_FishingScalability, STATGROUP_Fishing, FISHINGGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replication"), STAT_FishingReplication, STATGROUP_Fishing, FISHINGGAME_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(FISHINGGAME_API, Fishing);
+
+/** Insights channel for the cast loop: enable with -trace=cpu,bookmark,fishing. */
+UE_TRACE_CHANNEL_EXTERN(FishingChannel, FISHINGGAME_API);
+
+/**
+ * Times the rest of the scope as STAT_Fishing<Name> in "stat Fishing", as Fishing/<Name> in CSV profiles
+ * and as a Fishing<Name> CPU event on the Fishing trace channel.
+ */
+#define FISHING_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Fishing##Name); \
+	CSV_SCOPED_TIMING_STAT(Fishing, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Fishing##Name, FishingChannel)
+
+#if CSV_PROFILER
+#define FISHING_CSV_CAPTURING() FCsvProfiler::Get()->IsCapturing()
+#else
+#define FISHING_CSV_CAPTURING() false
+#endif
+
+/**
+ * Marks a moment of the cast loop as a CSV event and, when the Fishing channel is on, an Insights bookmark. Format must be a literal.
+ * The arguments are only evaluated while a CSV capture runs or the Fishing channel is on, so they can format names freely.
+ */
+#define FISHING_EVENT(Format, ...) \
+	do \
+	{ \
+		if (FISHING_CSV_CAPTURING()) \
+		{ \
+			CSV_EVENT(Fishing, Format, ##__VA_ARGS__); \
+		} \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(FishingChannel)) \
+		{ \
+			TRACE_BOOKMARK(Format, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+/** Fishing actors (anglers and their controllers) that ticked since the soak run last read and reset it. Mirrors STAT_FishingActorsTicked outside stat builds. */
+extern FISHINGGAME_API int32 GFishingActorsTicked;
+
+/** Loads the player pawn class and angler equipment synchronously during map load, as the hard references did. Set by "Fishing.MapLoadBench sync". */
+extern FISHINGGAME_API bool GFishingSyncAssetLoads;
@@ -0,0 +1,361 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishSchoolRenderer.h"
+#include "FishSchoolSubsystem.h"
+#include "FishingGameCharacter.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+
+namespace FishSchoolRenderer
+{
+	static constexpr int32 NumCustomData = 5;
+}
+
+AFishSchoolRenderer::AFishSchoolRenderer()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void AFishSchoolRenderer::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>();
+	if (GetNetMode() == NM_DedicatedServer || !FishSchools || SpeciesMeshes.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	FishSchools->SetRenderer(this);
+
+	for (int32 Mesh = 0; Mesh < SpeciesMeshes.Num(); ++Mesh)
+	{
+		SchoolInstances.Add(CreateInstances());
+		HeldInstances.Add(CreateInstances());
+	}
+	SpeciesTransforms.SetNum(SpeciesMeshes.Num());
+	SpeciesCustomData.SetNum(SpeciesMeshes.Num());
+	MeshHandles.SetNum(SpeciesMeshes.Num());
+}
+
+void AFishSchoolRenderer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>())
+	{
+		if (FishSchools->GetRenderer() == this)
+		{
+			FishSchools->SetRenderer(nullptr);
+		}
+	}
+
+	for (TSharedPtr<FStreamableHandle>& Handle : MeshHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->CancelHandle();
+		}
+	}
+	MeshHandles.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+UHierarchicalInstancedStaticMeshComponent* AFishSchoolRenderer::CreateInstances()
+{
+	UHierarchicalInstancedStaticMeshComponent* Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+	Instances->SetupAttachment(RootComponent);
+	Instances->SetUsingAbsoluteLocation(true);
+	Instances->SetUsingAbsoluteRotation(true);
+	Instances->SetUsingAbsoluteScale(true);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCanEverAffectNavigation(false);
+	Instances->SetCastShadow(false);
+	Instances->SetMobility(EComponentMobility::Movable);
+	Instances->SetCullDistances(0, FMath::RoundToInt(FishCullDistance));
+	Instances->NumCustomDataFloats = FishSchoolRenderer::NumCustomData;
+	Instances->RegisterComponent();
+	return Instances;
+}
+
+void AFishSchoolRenderer::RequestMesh(int32 Mesh)
+{
+	if (!MeshHandles.IsValidIndex(Mesh) || MeshHandles[Mesh].IsValid() || SpeciesMeshes[Mesh].IsNull())
+	{
+		return;
+	}
+
+	MeshHandles[Mesh] = UAssetManager::GetStreamableManager().RequestAsyncLoad(SpeciesMeshes[Mesh].ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &AFishSchoolRenderer::OnMeshLoaded, Mesh));
+}
+
+void AFishSchoolRenderer::OnMeshLoaded(int32 Mesh)
+{
+	if (SchoolInstances.IsValidIndex(Mesh))
+	{
+		SchoolInstances[Mesh]->SetStaticMesh(SpeciesMeshes[Mesh].Get());
+		HeldInstances[Mesh]->SetStaticMesh(SpeciesMeshes[Mesh].Get());
+	}
+}
+
+void AFishSchoolRenderer::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	UpdateSchools();
+	UpdateHeldFish();
+}
+
+void AFishSchoolRenderer::UpdateSchools()
+{
+	const UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>();
+	if (!FishSchools || FishSchools->GetStepCount() == LastStep)
+	{
+		return;
+	}
+	LastStep = FishSchools->GetStepCount();
+
+	const int32 NumMeshes = SpeciesMeshes.Num();
+	const int32 NumFish = FishSchools->GetNumFish();
+
+	// Fish keep their instance while the population stays the same, any zone coming or going lays every mesh out again
+	SpeciesCounts.Init(0, NumMeshes);
+	for (int32 Fish = 0; Fish < NumFish; ++Fish)
+	{
+		++SpeciesCounts[FishSchools->GetFishSpecies(Fish) % NumMeshes];
+	}
+	bool bRelayout = false;
+	for (int32 Mesh = 0; Mesh < NumMeshes; ++Mesh)
+	{
+		bRelayout |= SpeciesTransforms[Mesh].Num() != SpeciesCounts[Mesh] || SchoolInstances[Mesh]->GetInstanceCount() != SpeciesCounts[Mesh];
+	}
+
+	const float StepTime = GetWorld()->GetTimeSeconds();
+	const float RewriteDistanceSquared = FMath::Square(RewriteDistance);
+	const float RewriteCos = FMath::Cos(FMath::DegreesToRadians(RewriteAngle));
+
+	if (bRelayout)
+	{
+		for (int32 Mesh = 0; Mesh < NumMeshes; ++Mesh)
+		{
+			SpeciesTransforms[Mesh].Reset(SpeciesCounts[Mesh]);
+			SpeciesCustomData[Mesh].Reset(SpeciesCounts[Mesh] * FishSchoolRenderer::NumCustomData);
+		}
+	}
+
+	DirtyInstances.Init(false, NumFish);
+	SpeciesCounts.Init(0, NumMeshes);
+	for (int32 Fish = 0; Fish < NumFish; ++Fish)
+	{
+		const int32 Mesh = FishSchools->GetFishSpecies(Fish) % NumMeshes;
+		const int32 Instance = SpeciesCounts[Mesh]++;
+		const FVector Location = FishSchools->GetFishLocation(Fish);
+		const FVector Velocity = FishSchools->GetFishVelocity(Fish);
+
+		TArray<FTransform>& Transforms = SpeciesTransforms[Mesh];
+		TArray<float>& CustomData = SpeciesCustomData[Mesh];
+		if (bRelayout)
+		{
+			Transforms.AddDefaulted();
+			CustomData.AddZeroed(FishSchoolRenderer::NumCustomData);
+			CustomData[Instance * FishSchoolRenderer::NumCustomData] = (Fish * 0.618034f) - FMath::FloorToFloat(Fish * 0.618034f);
+		}
+		else
+		{
+			// Where the material draws the fish right now
+			float* Written = &CustomData[Instance * FishSchoolRenderer::NumCustomData];
+			const FVector WrittenVelocity(Written[1], Written[2], Written[3]);
+			const FVector Drawn = Transforms[Instance].GetLocation() + WrittenVelocity * (StepTime - Written[4]);
+			const bool bStrayed = FVector::DistSquared(Drawn, Location) > RewriteDistanceSquared;
+			const bool bTurned = (WrittenVelocity.GetSafeNormal() | Velocity.GetSafeNormal()) < RewriteCos;
+			if (!bStrayed && !bTurned)
+			{
+				continue;
+			}
+		}
+
+		Transforms[Instance] = FTransform(FRotationMatrix::MakeFromX(Velocity).ToQuat(), Location);
+		float* Data = &CustomData[Instance * FishSchoolRenderer::NumCustomData];
+		Data[1] = Velocity.X;
+		Data[2] = Velocity.Y;
+		Data[3] = Velocity.Z;
+		Data[4] = StepTime;
+		DirtyInstances[Fish] = true;
+	}
+
+	for (int32 Mesh = 0; Mesh < NumMeshes; ++Mesh)
+	{
+		UHierarchicalInstancedStaticMeshComponent* Instances = SchoolInstances[Mesh];
+		if (SpeciesTransforms[Mesh].Num() > 0)
+		{
+			RequestMesh(Mesh);
+		}
+
+		if (bRelayout)
+		{
+			Instances->ClearInstances();
+			Instances->AddInstances(SpeciesTransforms[Mesh], false);
+			Instances->PerInstanceSMCustomData = SpeciesCustomData[Mesh];
+			Instances->MarkRenderStateDirty();
+		}
+	}
+	if (bRelayout)
+	{
+		return;
+	}
+
+	// Dirty fish to runs of consecutive instances of their mesh
+	SpeciesCounts.Init(0, NumMeshes);
+	TArray<int32, TInlineAllocator<8>> RunStarts;
+	RunStarts.Init(INDEX_NONE, NumMeshes);
+	TBitArray<> MeshesWritten(false, NumMeshes);
+	for (int32 Fish = 0; Fish < NumFish; ++Fish)
+	{
+		const int32 Mesh = FishSchools->GetFishSpecies(Fish) % NumMeshes;
+		const int32 Instance = SpeciesCounts[Mesh]++;
+		if (DirtyInstances[Fish])
+		{
+			if (RunStarts[Mesh] == INDEX_NONE)
+			{
+				RunStarts[Mesh] = Instance;
+			}
+		}
+		else if (RunStarts[Mesh] != INDEX_NONE)
+		{
+			WriteSchoolInstances(Mesh, RunStarts[Mesh], Instance - RunStarts[Mesh]);
+			RunStarts[Mesh] = INDEX_NONE;
+			MeshesWritten[Mesh] = true;
+		}
+	}
+	for (int32 Mesh = 0; Mesh < NumMeshes; ++Mesh)
+	{
+		if (RunStarts[Mesh] != INDEX_NONE)
+		{
+			WriteSchoolInstances(Mesh, RunStarts[Mesh], SpeciesCounts[Mesh] - RunStarts[Mesh]);
+			MeshesWritten[Mesh] = true;
+		}
+		if (MeshesWritten[Mesh])
+		{
+			SchoolInstances[Mesh]->MarkRenderStateDirty();
+		}
+	}
+}
+
+void AFishSchoolRenderer::WriteSchoolInstances(int32 Mesh, int32 First, int32 Num)
+{
+	UHierarchicalInstancedStaticMeshComponent* Instances = SchoolInstances[Mesh];
+
+	RunTransforms.Reset(Num);
+	RunTransforms.Append(SpeciesTransforms[Mesh].GetData() + First, Num);
+	Instances->BatchUpdateInstancesTransforms(First, RunTransforms, true, false, true);
+
+	const int32 DataStart = First * FishSchoolRenderer::NumCustomData;
+	FMemory::Memcpy(&Instances->PerInstanceSMCustomData[DataStart], &SpeciesCustomData[Mesh][DataStart], Num * FishSchoolRenderer::NumCustomData * sizeof(float));
+}
+
+void AFishSchoolRenderer::ShowHeldFish(AFishingGameCharacter* Angler, USceneComponent* Parent, FName Socket, const FQuat& Rotation, uint16 Species)
+{
+	if (SpeciesMeshes.Num() > 0 && Parent)
+	{
+		FHeldFish& Held = HeldFish.Add(Angler);
+		Held.Parent = Parent;
+		Held.Socket = Socket;
+		Held.Rotation = Rotation;
+		Held.Mesh = Species % SpeciesMeshes.Num();
+		RequestMesh(Held.Mesh);
+		RebuildHeldFish();
+	}
+}
+
+void AFishSchoolRenderer::HideHeldFish(AFishingGameCharacter* Angler)
+{
+	if (HeldFish.Remove(Angler) > 0)
+	{
+		RebuildHeldFish();
+	}
+}
+
+void AFishSchoolRenderer::RebuildHeldFish()
+{
+	// Catches change a few times a minute at most, so a rebuild is cheaper than tracking instance indices
+	for (int32 Mesh = 0; Mesh < HeldInstances.Num(); ++Mesh)
+	{
+		TArray<FTransform> Transforms;
+		TArray<float> CustomData;
+		for (TPair<TWeakObjectPtr<AFishingGameCharacter>, FHeldFish>& Held : HeldFish)
+		{
+			USceneComponent* Parent = Held.Value.Parent.Get();
+			if (Held.Value.Mesh == Mesh && Held.Key.IsValid() && Parent)
+			{
+				Held.Value.Instance = Transforms.Num();
+				const FTransform Socket = Parent->GetSocketTransform(Held.Value.Socket);
+				Transforms.Emplace(Socket.GetRotation() * Held.Value.Rotation, Socket.GetLocation());
+				CustomData.Append({ 0.f, 0.f, 0.f, 0.f, 0.f });
+			}
+		}
+
+		HeldInstances[Mesh]->ClearInstances();
+		HeldInstances[Mesh]->AddInstances(Transforms, false);
+		HeldInstances[Mesh]->PerInstanceSMCustomData = MoveTemp(CustomData);
+		HeldInstances[Mesh]->MarkRenderStateDirty();
+	}
+}
+
+void AFishSchoolRenderer::UpdateHeldFish()
+{
+	if (HeldFish.Num() == 0)
+	{
+		return;
+	}
+
+	// A handful of instances, following whatever moved their angler's hook this frame
+	for (int32 Mesh = 0; Mesh < HeldInstances.Num(); ++Mesh)
+	{
+		UHierarchicalInstancedStaticMeshComponent* Instances = HeldInstances[Mesh];
+		if (Instances->GetInstanceCount() == 0)
+		{
+			continue;
+		}
+
+		HeldTransforms.SetNum(Instances->GetInstanceCount());
+		bool bComplete = true;
+		for (const TPair<TWeakObjectPtr<AFishingGameCharacter>, FHeldFish>& Held : HeldFish)
+		{
+			const USceneComponent* Parent = Held.Value.Parent.Get();
+			if (Held.Value.Mesh != Mesh)
+			{
+				continue;
+			}
+			if (!Parent || !HeldTransforms.IsValidIndex(Held.Value.Instance))
+			{
+				bComplete = false;
+				continue;
+			}
+			const FTransform Socket = Parent->GetSocketTransform(Held.Value.Socket);
+			HeldTransforms[Held.Value.Instance] = FTransform(Socket.GetRotation() * Held.Value.Rotation, Socket.GetLocation());
+		}
+
+		if (bComplete)
+		{
+			Instances->BatchUpdateInstancesTransforms(0, HeldTransforms, true, true, true);
+		}
+	}
+
+	// An angler or hook went away without hiding its fish
+	const int32 NumHeld = HeldFish.Num();
+	for (auto It = HeldFish.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || !It.Value().Parent.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	if (HeldFish.Num() != NumHeld)
+	{
+		RebuildHeldFish();
+	}
+}
@@ -0,0 +1,438 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishSchoolSubsystem.h"
+#include "FishingGame.h"
+#include "FishingGameCharacter.h"
+#include "FishingZone.h"
+#include "FishingLootTable.h"
+#include "Async/ParallelFor.h"
+#include "Components/BoxComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+
+namespace FishSchool
+{
+	/** 4-fish groups handed to each ParallelFor task. */
+	static constexpr int32 GroupsPerTask = 256;
+
+	static constexpr float CohesionWeight = 0.4f;
+	static constexpr float AlignmentWeight = 0.8f;
+	static constexpr float BoundsWeight = 4.f;
+	static constexpr float WanderWeight = 60.f;
+	static constexpr float AttractWeight = 400.f;
+
+	/** Integer hash mapped to [-1, 1), stable across platforms and thread splits. */
+	static FORCEINLINE float HashToSignedUnit(uint32 Value)
+	{
+		Value ^= Value >> 16;
+		Value *= 0x7feb352dU;
+		Value ^= Value >> 15;
+		Value *= 0x846ca68bU;
+		Value ^= Value >> 16;
+		return (Value & 0xFFFFFF) / float(0x800000) - 1.f;
+	}
+
+	static FORCEINLINE VectorRegister WanderLanes(uint32 Seed, uint32 Step, int32 FirstFish, uint32 Axis)
+	{
+		const uint32 Base = HashCombine(HashCombine(Seed, Step), Axis);
+		return MakeVectorRegister(
+			HashToSignedUnit(Base ^ (FirstFish + 0) * 0x9E3779B9U),
+			HashToSignedUnit(Base ^ (FirstFish + 1) * 0x9E3779B9U),
+			HashToSignedUnit(Base ^ (FirstFish + 2) * 0x9E3779B9U),
+			HashToSignedUnit(Base ^ (FirstFish + 3) * 0x9E3779B9U));
+	}
+}
+
+namespace FishSchoolBench
+{
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.FishBench"),
+		TEXT("Times the fish simulation step on a throwaway population against a per step budget. Usage: Fishing.FishBench [Fish=50000] [Steps=200] [BudgetMs=1]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World)
+			{
+				return;
+			}
+
+			const int32 NumFish = FMath::Max(4, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50000);
+			const int32 NumSteps = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 200);
+			const float BudgetMs = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 1.f;
+
+			// Kept out of the world's own population, which goes on untouched
+			UFishSchoolSubsystem* Bench = NewObject<UFishSchoolSubsystem>(World);
+			Bench->RunBenchmark(NumFish, NumSteps, BudgetMs);
+			Bench->MarkPendingKill();
+		}));
+}
+
+void UFishSchoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("FishingSeed="), Seed);
+}
+
+void UFishSchoolSubsystem::AddZone(AFishingZone* Zone)
+{
+	if (!Zone || Zone->GetFishPopulation() <= 0 || HasFish(Zone))
+	{
+		return;
+	}
+
+	const FBox Bounds = Zone->GetZoneBox()->Bounds.GetBox();
+	const int32 SchoolSize = Align(FMath::Max(Zone->GetSchoolSize(), 4), 4);
+	const int32 NumSchools = FMath::DivideAndRoundUp(Zone->GetFishPopulation(), SchoolSize);
+
+	// Seeded from the zone name rather than spawn order, so streaming zones in a different order changes nothing
+	FRandomStream Random(HashCombine(Seed, GetTypeHash(Zone->GetFName())));
+	UFishingLootSubsystem* Loot = GetWorld()->GetSubsystem<UFishingLootSubsystem>();
+
+	for (int32 SchoolIndex = 0; SchoolIndex < NumSchools; ++SchoolIndex)
+	{
+		FFishingLootRoll Roll;
+		const uint16 SchoolSpecies = Loot && Loot->Roll(Zone, Random, Roll) ? (uint16)Roll.SpeciesId : (uint16)Random.RandRange(0, 255);
+		AddSchool(Zone, Bounds, SchoolSize, SchoolSpecies, Random);
+	}
+
+	RebuildGroupSchools();
+}
+
+void UFishSchoolSubsystem::AddSchool(AFishingZone* Zone, const FBox& Bounds, int32 SchoolSize, uint16 SchoolSpecies, FRandomStream& Random)
+{
+	FFishSchool& School = Schools.AddDefaulted_GetRef();
+	School.Zone = Zone;
+	School.BoundsMin = Bounds.Min;
+	School.BoundsMax = Bounds.Max;
+	School.FirstFish = PosX.Num();
+	School.NumFish = SchoolSize;
+	School.Species = SchoolSpecies;
+
+	const FVector Home(Random.FRandRange(Bounds.Min.X, Bounds.Max.X), Random.FRandRange(Bounds.Min.Y, Bounds.Max.Y), Random.FRandRange(Bounds.Min.Z, Bounds.Max.Z));
+	const FVector Heading = FVector(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f), 0.f).GetSafeNormal() * MaxSpeed * 0.5f;
+
+	for (int32 Fish = 0; Fish < SchoolSize; ++Fish)
+	{
+		const FVector Offset = Random.GetUnitVector() * Random.FRandRange(0.f, 150.f);
+		PosX.Add(Home.X + Offset.X);
+		PosY.Add(Home.Y + Offset.Y);
+		PosZ.Add(Home.Z + Offset.Z * 0.3f);
+		VelX.Add(Heading.X);
+		VelY.Add(Heading.Y);
+		VelZ.Add(0.f);
+		Hunger.Add(Random.FRand());
+		Species.Add(School.Species);
+	}
+}
+
+void UFishSchoolSubsystem::RemoveZone(AFishingZone* Zone)
+{
+	for (int32 SchoolIndex = Schools.Num() - 1; SchoolIndex >= 0; --SchoolIndex)
+	{
+		const FFishSchool School = Schools[SchoolIndex];
+		if (School.Zone != Zone)
+		{
+			continue;
+		}
+
+		for (TArray<float>* Lane : { &PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &Hunger })
+		{
+			Lane->RemoveAt(School.FirstFish, School.NumFish, false);
+		}
+		Species.RemoveAt(School.FirstFish, School.NumFish, false);
+
+		Schools.RemoveAt(SchoolIndex);
+		for (int32 Later = SchoolIndex; Later < Schools.Num(); ++Later)
+		{
+			Schools[Later].FirstFish -= School.NumFish;
+		}
+	}
+
+	// Anglers still waiting there fall back to a timed bite
+	TArray<TWeakObjectPtr<AFishingGameCharacter>, TInlineAllocator<8>> Waiting;
+	for (const FFishHook& Hook : Hooks)
+	{
+		if (Hook.Zone == Zone && !Hook.bTaken)
+		{
+			Waiting.Add(Hook.Angler);
+		}
+	}
+	Hooks.RemoveAll([Zone](const FFishHook& Hook) { return Hook.Zone == Zone; });
+	RebuildGroupSchools();
+
+	for (const TWeakObjectPtr<AFishingGameCharacter>& Angler : Waiting)
+	{
+		if (Angler.IsValid())
+		{
+			Angler->WaitForBite();
+		}
+	}
+}
+
+bool UFishSchoolSubsystem::HasFish(const AFishingZone* Zone) const
+{
+	return Schools.ContainsByPredicate([Zone](const FFishSchool& School) { return School.Zone == Zone; });
+}
+
+void UFishSchoolSubsystem::AddHook(AFishingGameCharacter* Angler, const FVector& Location, AFishingZone* Zone)
+{
+	RemoveHook(Angler);
+
+	FFishHook& Hook = Hooks.AddDefaulted_GetRef();
+	Hook.Angler = Angler;
+	Hook.Zone = Zone;
+	Hook.Location = Location;
+}
+
+void UFishSchoolSubsystem::RemoveHook(AFishingGameCharacter* Angler)
+{
+	Hooks.RemoveAll([Angler](const FFishHook& Hook) { return Hook.Angler == Angler; });
+}
+
+void UFishSchoolSubsystem::RunBenchmark(int32 NumFish, int32 NumSteps, float BudgetMs)
+{
+	// Lake sized area with the default school size, one waiting hook per thousand fish to keep the attraction path busy
+	const FBox Bounds(FVector(-20000.f, -20000.f, -400.f), FVector(20000.f, 20000.f, 0.f));
+	const int32 SchoolSize = 32;
+	FRandomStream Random(Seed);
+	for (int32 Added = 0; Added < NumFish; Added += SchoolSize)
+	{
+		AddSchool(nullptr, Bounds, SchoolSize, (uint16)Random.RandRange(0, 255), Random);
+	}
+	for (int32 Index = 0; Index < FMath::Max(NumFish / 1000, 1); ++Index)
+	{
+		FFishHook& Hook = Hooks.AddDefaulted_GetRef();
+		Hook.Location = FVector(Random.FRandRange(Bounds.Min.X, Bounds.Max.X), Random.FRandRange(Bounds.Min.Y, Bounds.Max.Y), 0.f);
+	}
+	RebuildGroupSchools();
+
+	const float StepSeconds = 1.f / SimulationRate;
+	Step(StepSeconds);
+
+	double TotalMs = 0.0;
+	double PeakMs = 0.0;
+	for (int32 Index = 0; Index < NumSteps; ++Index)
+	{
+		const double Start = FPlatformTime::Seconds();
+		Step(StepSeconds);
+		const double StepMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+		TotalMs += StepMs;
+		PeakMs = FMath::Max(PeakMs, StepMs);
+	}
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing fish bench: %d fish in %d schools, %d steps on %d task graph workers: %.3f ms avg, %.3f ms peak per step, %s the %.2f ms budget"),
+		PosX.Num(), Schools.Num(), NumSteps, FTaskGraphInterface::Get().GetNumWorkerThreads(), TotalMs / NumSteps, PeakMs, TotalMs / NumSteps <= BudgetMs ? TEXT("within") : TEXT("OVER"), BudgetMs);
+
+	Schools.Empty();
+	Hooks.Empty();
+	for (TArray<float>* Lane : { &PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &Hunger })
+	{
+		Lane->Empty();
+	}
+	Species.Empty();
+	GroupSchools.Empty();
+}
+
+void UFishSchoolSubsystem::RebuildGroupSchools()
+{
+	GroupSchools.Reset(PosX.Num() / 4);
+	for (int32 SchoolIndex = 0; SchoolIndex < Schools.Num(); ++SchoolIndex)
+	{
+		for (int32 Group = 0; Group < Schools[SchoolIndex].NumFish / 4; ++Group)
+		{
+			GroupSchools.Add(SchoolIndex);
+		}
+	}
+
+	SET_MEMORY_STAT(STAT_FishSchoolMemory, PosX.GetAllocatedSize() + PosY.GetAllocatedSize() + PosZ.GetAllocatedSize()
+		+ VelX.GetAllocatedSize() + VelY.GetAllocatedSize() + VelZ.GetAllocatedSize() + Hunger.GetAllocatedSize()
+		+ Species.GetAllocatedSize() + Schools.GetAllocatedSize() + GroupSchools.GetAllocatedSize());
+}
+
+void UFishSchoolSubsystem::Tick(float DeltaTime)
+{
+	const float StepSeconds = 1.f / SimulationRate;
+
+	// Catch up at most a few steps after a hitch instead of spiralling
+	Accumulator = FMath::Min(Accumulator + DeltaTime, StepSeconds * 4.f);
+	while (Accumulator >= StepSeconds)
+	{
+		Accumulator -= StepSeconds;
+		Step(StepSeconds);
+	}
+}
+
+void UFishSchoolSubsystem::Step(float StepSeconds)
+{
+	// Each school follows the closest waiting hook in its zone
+	ParallelFor(Schools.Num(), [this](int32 SchoolIndex)
+	{
+		FFishSchool& School = Schools[SchoolIndex];
+
+		FVector Sum = FVector::ZeroVector;
+		FVector VelocitySum = FVector::ZeroVector;
+		for (int32 Fish = School.FirstFish; Fish < School.FirstFish + School.NumFish; ++Fish)
+		{
+			Sum += FVector(PosX[Fish], PosY[Fish], PosZ[Fish]);
+			VelocitySum += FVector(VelX[Fish], VelY[Fish], VelZ[Fish]);
+		}
+		School.Centroid = Sum / School.NumFish;
+		School.AverageVelocity = VelocitySum / School.NumFish;
+
+		School.TargetHook = INDEX_NONE;
+		float BestDistSquared = FMath::Square(AttractRadius * 4.f);
+		for (int32 HookIndex = 0; HookIndex < Hooks.Num(); ++HookIndex)
+		{
+			const float DistSquared = FVector::DistSquared(Hooks[HookIndex].Location, School.Centroid);
+			if (Hooks[HookIndex].Zone == School.Zone && DistSquared < BestDistSquared)
+			{
+				BestDistSquared = DistSquared;
+				School.TargetHook = HookIndex;
+			}
+		}
+	});
+
+	const int32 NumGroups = GroupSchools.Num();
+	const int32 NumTasks = FMath::DivideAndRoundUp(NumGroups, FishSchool::GroupsPerTask);
+	TaskBiters.SetNum(NumTasks);
+
+	ParallelFor(NumTasks, [this, NumGroups, StepSeconds](int32 Task)
+	{
+		const int32 FirstGroup = Task * FishSchool::GroupsPerTask;
+		TaskBiters[Task].Reset();
+		StepGroups(FirstGroup, FMath::Min(FirstGroup + FishSchool::GroupsPerTask, NumGroups), StepSeconds, TaskBiters[Task]);
+	});
+
+	// Resolve bites in fish order so the outcome doesn't depend on how the work was split
+	TArray<TPair<TWeakObjectPtr<AFishingGameCharacter>, uint16>, TInlineAllocator<8>> BittenAnglers;
+	for (const TArray<int32>& Biters : TaskBiters)
+	{
+		for (int32 Fish : Biters)
+		{
+			const FFishSchool& School = Schools[GroupSchools[Fish / 4]];
+			FFishHook& Hook = Hooks[School.TargetHook];
+			if (!Hook.bTaken)
+			{
+				Hook.bTaken = true;
+				Hunger[Fish] = 0.f;
+				BittenAnglers.Emplace(Hook.Angler, Species[Fish]);
+			}
+		}
+	}
+
+	++StepCount;
+
+	if (BittenAnglers.Num() > 0)
+	{
+		Hooks.RemoveAll([](const FFishHook& Hook) { return Hook.bTaken; });
+		for (const TPair<TWeakObjectPtr<AFishingGameCharacter>, uint16>& Bite : BittenAnglers)
+		{
+			if (Bite.Key.IsValid())
+			{
+				Bite.Key->FishBite(Bite.Value);
+			}
+		}
+	}
+}
+
+void UFishSchoolSubsystem::StepGroups(int32 FirstGroup, int32 LastGroup, float StepSeconds, TArray<int32>& OutBiters)
+{
+	const VectorRegister Dt = VectorSetFloat1(StepSeconds);
+	const VectorRegister One = VectorOne();
+	const VectorRegister Epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const VectorRegister Cohesion = VectorSetFloat1(FishSchool::CohesionWeight);
+	const VectorRegister Alignment = VectorSetFloat1(FishSchool::AlignmentWeight);
+	const VectorRegister BoundsPull = VectorSetFloat1(FishSchool::BoundsWeight);
+	const VectorRegister Wander = VectorSetFloat1(FishSchool::WanderWeight);
+	const VectorRegister Attract = VectorSetFloat1(FishSchool::AttractWeight);
+	const VectorRegister Speed = VectorSetFloat1(MaxSpeed);
+	const VectorRegister HungerGain = VectorSetFloat1(HungerRate * StepSeconds);
+	const VectorRegister Hungry = VectorSetFloat1(HungerThreshold);
+	const VectorRegister AttractRadiusSquared = VectorSetFloat1(AttractRadius * AttractRadius);
+	const VectorRegister BiteRadiusSquared = VectorSetFloat1(BiteRadius * BiteRadius);
+
+	for (int32 Group = FirstGroup; Group < LastGroup; ++Group)
+	{
+		const FFishSchool& School = Schools[GroupSchools[Group]];
+		const int32 Fish = Group * 4;
+
+		VectorRegister Px = VectorLoad(&PosX[Fish]);
+		VectorRegister Py = VectorLoad(&PosY[Fish]);
+		VectorRegister Pz = VectorLoad(&PosZ[Fish]);
+		VectorRegister Vx = VectorLoad(&VelX[Fish]);
+		VectorRegister Vy = VectorLoad(&VelY[Fish]);
+		VectorRegister Vz = VectorLoad(&VelZ[Fish]);
+		VectorRegister H = VectorLoad(&Hunger[Fish]);
+
+		// Cohesion towards the school centre, alignment with its heading
+		VectorRegister Ax = VectorMultiply(VectorSubtract(VectorSetFloat1(School.Centroid.X), Px), Cohesion);
+		VectorRegister Ay = VectorMultiply(VectorSubtract(VectorSetFloat1(School.Centroid.Y), Py), Cohesion);
+		VectorRegister Az = VectorMultiply(VectorSubtract(VectorSetFloat1(School.Centroid.Z), Pz), Cohesion);
+		Ax = VectorMultiplyAdd(VectorSubtract(VectorSetFloat1(School.AverageVelocity.X), Vx), Alignment, Ax);
+		Ay = VectorMultiplyAdd(VectorSubtract(VectorSetFloat1(School.AverageVelocity.Y), Vy), Alignment, Ay);
+		Az = VectorMultiplyAdd(VectorSubtract(VectorSetFloat1(School.AverageVelocity.Z), Vz), Alignment, Az);
+
+		// Pulled back when leaving the zone volume
+		Ax = VectorMultiplyAdd(VectorSubtract(VectorMin(VectorMax(Px, VectorSetFloat1(School.BoundsMin.X)), VectorSetFloat1(School.BoundsMax.X)), Px), BoundsPull, Ax);
+		Ay = VectorMultiplyAdd(VectorSubtract(VectorMin(VectorMax(Py, VectorSetFloat1(School.BoundsMin.Y)), VectorSetFloat1(School.BoundsMax.Y)), Py), BoundsPull, Ay);
+		Az = VectorMultiplyAdd(VectorSubtract(VectorMin(VectorMax(Pz, VectorSetFloat1(School.BoundsMin.Z)), VectorSetFloat1(School.BoundsMax.Z)), Pz), BoundsPull, Az);
+
+		Ax = VectorMultiplyAdd(FishSchool::WanderLanes(Seed, StepCount, Fish, 0), Wander, Ax);
+		Ay = VectorMultiplyAdd(FishSchool::WanderLanes(Seed, StepCount, Fish, 1), Wander, Ay);
+		Az = VectorMultiplyAdd(VectorMultiply(FishSchool::WanderLanes(Seed, StepCount, Fish, 2), VectorSetFloat1(0.2f)), Wander, Az);
+
+		// Hungry fish in range head straight for the hook
+		VectorRegister BiteMask = VectorZero();
+		if (School.TargetHook != INDEX_NONE)
+		{
+			const FVector& HookLocation = Hooks[School.TargetHook].Location;
+			const VectorRegister Dx = VectorSubtract(VectorSetFloat1(HookLocation.X), Px);
+			const VectorRegister Dy = VectorSubtract(VectorSetFloat1(HookLocation.Y), Py);
+			const VectorRegister Dz = VectorSubtract(VectorSetFloat1(HookLocation.Z), Pz);
+			const VectorRegister DistSquared = VectorMultiplyAdd(Dz, Dz, VectorMultiplyAdd(Dy, Dy, VectorMultiply(Dx, Dx)));
+			const VectorRegister IsHungry = VectorCompareGT(H, Hungry);
+			const VectorRegister Seeking = VectorBitwiseAnd(IsHungry, VectorCompareLT(DistSquared, AttractRadiusSquared));
+			const VectorRegister Pull = VectorMultiply(VectorReciprocalSqrt(VectorAdd(DistSquared, Epsilon)), Attract);
+
+			Ax = VectorSelect(Seeking, VectorMultiplyAdd(Dx, Pull, Ax), Ax);
+			Ay = VectorSelect(Seeking, VectorMultiplyAdd(Dy, Pull, Ay), Ay);
+			Az = VectorSelect(Seeking, VectorMultiplyAdd(Dz, Pull, Az), Az);
+			BiteMask = VectorBitwiseAnd(IsHungry, VectorCompareLT(DistSquared, BiteRadiusSquared));
+		}
+
+		Vx = VectorMultiplyAdd(Ax, Dt, Vx);
+		Vy = VectorMultiplyAdd(Ay, Dt, Vy);
+		Vz = VectorMultiplyAdd(Az, Dt, Vz);
+
+		const VectorRegister SpeedSquared = VectorMultiplyAdd(Vz, Vz, VectorMultiplyAdd(Vy, Vy, VectorMultiply(Vx, Vx)));
+		const VectorRegister SpeedScale = VectorMin(One, VectorMultiply(Speed, VectorReciprocalSqrt(VectorAdd(SpeedSquared, Epsilon))));
+		Vx = VectorMultiply(Vx, SpeedScale);
+		Vy = VectorMultiply(Vy, SpeedScale);
+		Vz = VectorMultiply(Vz, SpeedScale);
+
+		VectorStore(VectorMultiplyAdd(Vx, Dt, Px), &PosX[Fish]);
+		VectorStore(VectorMultiplyAdd(Vy, Dt, Py), &PosY[Fish]);
+		VectorStore(VectorMultiplyAdd(Vz, Dt, Pz), &PosZ[Fish]);
+		VectorStore(Vx, &VelX[Fish]);
+		VectorStore(Vy, &VelY[Fish]);
+		VectorStore(Vz, &VelZ[Fish]);
+		VectorStore(VectorMin(One, VectorAdd(H, HungerGain)), &Hunger[Fish]);
+
+		if (const int32 BiteBits = VectorMaskBits(BiteMask))
+		{
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				if (BiteBits & (1 << Lane))
+				{
+					OutBiters.Add(Fish + Lane);
+				}
+			}
+		}
+	}
+}
+
+TStatId UFishSchoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishSchoolSubsystem, STATGROUP_Tickables);
+}
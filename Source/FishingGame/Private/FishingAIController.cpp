@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingAIController.h"
+#include "Engine/World.h"
+#include "FishingGame.h"
+#include "FishingGameCharacter.h"
+#include "FishingNetTypes.h"
+
+AFishingAIController::AFishingAIController()
+{
+	// Stepped in batches by UFishingSignificanceSubsystem
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+void AFishingAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	// Staggered so anglers spawned together don't all cast on the same frame
+	NextStep(EFishingStep::Idle, FMath::FRandRange(0.f, IdleTimeRange.Y));
+}
+
+AFishingGameCharacter* AFishingAIController::GetAngler() const
+{
+	return Cast<AFishingGameCharacter>(GetPawn());
+}
+
+float AFishingAIController::GetCastingProgress() const
+{
+	if (bReadyToFish)
+	{
+		return FMath::Min(StepTime * CastingSpeed, 1.f);
+	}
+	return CastingProgress;
+}
+
+void AFishingAIController::NextStep(EFishingStep InStep, float Duration)
+{
+	Step = InStep;
+	StepTime = 0.f;
+	StepDuration = Duration;
+}
+
+void AFishingAIController::StepFishing(float DeltaTime)
+{
+	AFishingGameCharacter* Angler = GetAngler();
+	if (!Angler)
+	{
+		return;
+	}
+
+	StepTime += DeltaTime;
+	const bool bStepElapsed = StepTime >= StepDuration;
+
+	switch (Step)
+	{
+	case EFishingStep::Idle:
+		if (bStepElapsed)
+		{
+			ReadyCast(Angler);
+			NextStep(EFishingStep::Charging, FMath::FRandRange(ChargeTimeRange.X, ChargeTimeRange.Y));
+		}
+		break;
+
+	case EFishingStep::Charging:
+		if (bStepElapsed)
+		{
+			ThrowCast(Angler);
+			NextStep(EFishingStep::Launching, LaunchDelay);
+		}
+		break;
+
+	case EFishingStep::Launching:
+		if (bStepElapsed)
+		{
+			// The launch notify may already have sent the hook off
+			if (Angler->GetHookMesh()->GetAttachParent())
+			{
+				Angler->LaunchHook();
+			}
+			NextStep(EFishingStep::HookInFlight, MaxHookFlightTime);
+		}
+		break;
+
+	case EFishingStep::HookInFlight:
+		if (Angler->IsHookLanded())
+		{
+			bTransition = false;
+			bFishing = true;
+			if (Angler->GetFishingPhase() == EFishingPhase::HookInFlight)
+			{
+				Angler->StartFishing();
+			}
+			NextStep(EFishingStep::WaitingForBite, 0.f);
+		}
+		else if (bStepElapsed)
+		{
+			// Missed the water
+			Reel(Angler);
+		}
+		break;
+
+	case EFishingStep::WaitingForBite:
+		if (Angler->IsFishBiting())
+		{
+			NextStep(EFishingStep::Reacting, FMath::FRandRange(ReactionTimeRange.X, ReactionTimeRange.Y));
+		}
+		break;
+
+	case EFishingStep::Reacting:
+		if (bStepElapsed)
+		{
+			if (Angler->IsFishBiting())
+			{
+				++NumCatches;
+			}
+			Reel(Angler);
+		}
+		break;
+	}
+}
+
+void AFishingAIController::ReadyCast(AFishingGameCharacter* Angler)
+{
+	FISHING_SCOPE(ReadyThrowCast);
+
+	CastingProgress = 0.f;
+	bReadyToFish = true;
+	Angler->HideCaughtFish();
+	Angler->SetFishingPhase(EFishingPhase::Charging);
+}
+
+void AFishingAIController::ThrowCast(AFishingGameCharacter* Angler)
+{
+	FISHING_SCOPE(ThrowCast);
+
+	CastingProgress = GetCastingProgress();
+	bReadyToFish = false;
+	bTransition = true;
+	++NumCasts;
+	Angler->SetFishingPhase(EFishingPhase::Casting, CastingProgress);
+}
+
+void AFishingAIController::Reel(AFishingGameCharacter* Angler)
+{
+	if (bFishing)
+	{
+		bFishing = false;
+		bTransition = true;
+		Angler->ReelIn(GetWorld()->GetTimeSeconds());
+		Angler->SetFishingPhase(EFishingPhase::Reeling);
+	}
+	Angler->ReelHook();
+	Angler->ClearTimersAndVFX();
+	bTransition = false;
+	NextStep(EFishingStep::Idle, FMath::FRandRange(IdleTimeRange.X, IdleTimeRange.Y));
+}
@@ -0,0 +1,353 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingAnglerUpdateSubsystem.h"
+#include "FishingGame.h"
+#include "FishingAnglerController.h"
+#include "FishingGameCharacter.h"
+#include "FishingZoneSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+void UFishingAnglerUpdateSubsystem::UpdateHooks(const TArray<FHookSnapshot>& InSnapshots, TArray<FHookResult>& OutResults, int32 First, int32 Last, float DeltaTime, const UFishingZoneSubsystem& Zones)
+{
+	for (int32 Index = First; Index < Last; ++Index)
+	{
+		const FHookSnapshot& Snapshot = InSnapshots[Index];
+		FHookResult& Result = OutResults[Index];
+		Result.FlightTime = Snapshot.FlightTime;
+		Result.ZoneIndex = INDEX_NONE;
+		Result.bLanded = false;
+
+		if (Snapshot.Mode == EHookMode::Flight)
+		{
+			Result.FlightTime += DeltaTime;
+			if (Snapshot.Trajectory.bHasLanding && Result.FlightTime >= Snapshot.Trajectory.LandingTime)
+			{
+				// Landings on a zone's entry point sit on its boundary; look just past it along the path
+				Result.Location = Snapshot.Trajectory.LandingLocation;
+				const FVector Probe = Result.Location + Snapshot.Trajectory.GetVelocityAtTime(Snapshot.Trajectory.LandingTime).GetSafeNormal();
+				Result.ZoneIndex = Zones.FindZoneIndexAtPoint(Probe);
+				Result.bLanded = true;
+			}
+			else
+			{
+				Result.Location = Snapshot.Trajectory.GetLocationAtTime(Result.FlightTime);
+			}
+		}
+		else
+		{
+			Result.Location = Snapshot.Location;
+			Result.ZoneIndex = Zones.FindZoneIndexAtPoint(Snapshot.Location);
+		}
+	}
+}
+
+void UFishingAnglerUpdateSubsystem::RunJobs(const TArray<FHookSnapshot>& InSnapshots, TArray<FHookResult>& OutResults, int32 NumJobs, float DeltaTime, const UFishingZoneSubsystem& Zones)
+{
+	const int32 Num = InSnapshots.Num();
+	OutResults.SetNum(Num, false);
+	NumJobs = FMath::Clamp(NumJobs, 1, FMath::Max(Num, 1));
+
+	ParallelFor(NumJobs, [&InSnapshots, &OutResults, &Zones, Num, NumJobs, DeltaTime](int32 Job)
+	{
+		UpdateHooks(InSnapshots, OutResults, (int64)Num * Job / NumJobs, (int64)Num * (Job + 1) / NumJobs, DeltaTime, Zones);
+	}, NumJobs == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+int32 UFishingAnglerUpdateSubsystem::RegisterAngler(AFishingGameCharacter* Angler)
+{
+	int32 AnglerIndex;
+	if (FreeIndices.Num() > 0)
+	{
+		AnglerIndex = FreeIndices.Pop(false);
+	}
+	else
+	{
+		AnglerIndex = Owners.AddDefaulted();
+		Modes.Add(EHookMode::None);
+		Trajectories.AddDefaulted();
+		FlightTimes.Add(0.f);
+		Registered.Add(false);
+	}
+
+	Owners[AnglerIndex] = Angler;
+	Registered[AnglerIndex] = true;
+	return AnglerIndex;
+}
+
+void UFishingAnglerUpdateSubsystem::UnregisterAngler(int32 AnglerIndex)
+{
+	if (Registered.IsValidIndex(AnglerIndex) && Registered[AnglerIndex])
+	{
+		StopHook(AnglerIndex);
+		Owners[AnglerIndex] = nullptr;
+		Registered[AnglerIndex] = false;
+		FreeIndices.Add(AnglerIndex);
+	}
+}
+
+void UFishingAnglerUpdateSubsystem::BeginFlight(int32 AnglerIndex, const FFishingCastTrajectory& Trajectory, float ElapsedTime)
+{
+	if (Registered.IsValidIndex(AnglerIndex) && Registered[AnglerIndex])
+	{
+		Trajectories[AnglerIndex] = Trajectory;
+		FlightTimes[AnglerIndex] = ElapsedTime;
+		SetMode(AnglerIndex, EHookMode::Flight);
+	}
+}
+
+void UFishingAnglerUpdateSubsystem::BeginPhysicsCast(int32 AnglerIndex)
+{
+	if (Registered.IsValidIndex(AnglerIndex) && Registered[AnglerIndex])
+	{
+		SetMode(AnglerIndex, EHookMode::Physics);
+	}
+}
+
+void UFishingAnglerUpdateSubsystem::StopHook(int32 AnglerIndex)
+{
+	if (Registered.IsValidIndex(AnglerIndex) && Registered[AnglerIndex])
+	{
+		SetMode(AnglerIndex, EHookMode::None);
+	}
+}
+
+void UFishingAnglerUpdateSubsystem::SetMode(int32 AnglerIndex, EHookMode Mode)
+{
+	if ((Modes[AnglerIndex] == EHookMode::None) != (Mode == EHookMode::None))
+	{
+		if (Mode == EHookMode::None)
+		{
+			ActiveAnglers.RemoveSingleSwap(AnglerIndex, false);
+		}
+		else
+		{
+			ActiveAnglers.Add(AnglerIndex);
+		}
+	}
+	Modes[AnglerIndex] = Mode;
+}
+
+void UFishingAnglerUpdateSubsystem::Deinitialize()
+{
+	ActiveAnglers.Empty();
+	Snapshots.Empty();
+	Results.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFishingAnglerUpdateSubsystem::Tick(float DeltaTime)
+{
+	FISHING_SCOPE(HookFlight);
+
+	UFishingZoneSubsystem* Zones = GetWorld()->GetSubsystem<UFishingZoneSubsystem>();
+	if (!Zones)
+	{
+		return;
+	}
+
+	// Snapshot: everything the jobs read is copied here, the jobs never look at an actor
+	Snapshots.Reset();
+	SnapshotAnglers.Reset();
+	for (int32 AnglerIndex : ActiveAnglers)
+	{
+		AFishingGameCharacter* Angler = Owners[AnglerIndex].Get();
+		if (!Angler)
+		{
+			continue;
+		}
+
+		FHookSnapshot& Snapshot = Snapshots.AddDefaulted_GetRef();
+		Snapshot.Mode = Modes[AnglerIndex];
+		if (Snapshot.Mode == EHookMode::Flight)
+		{
+			Snapshot.Trajectory = Trajectories[AnglerIndex];
+			Snapshot.FlightTime = FlightTimes[AnglerIndex];
+		}
+		else
+		{
+			// A physics cast only lands while the controller is still waiting for it
+			const IFishingAnglerController* AnglerController = Cast<IFishingAnglerController>(Angler->GetController());
+			if (!AnglerController || AnglerController->GetIsFishing() || !AnglerController->GetInTransition())
+			{
+				Snapshots.Pop(false);
+				continue;
+			}
+			Snapshot.Location = Angler->GetHookMesh()->GetComponentLocation();
+		}
+		SnapshotAnglers.Add(AnglerIndex);
+	}
+
+	RunJobs(Snapshots, Results, FMath::DivideAndRoundUp(Snapshots.Num(), FMath::Max(AnglersPerJob, 1)), DeltaTime, *Zones);
+
+	// Settle state for the whole batch first, the callbacks are free to start or stop any angler's hook
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const int32 AnglerIndex = SnapshotAnglers[Index];
+		const FHookResult& Result = Results[Index];
+		if (Modes[AnglerIndex] == EHookMode::Flight)
+		{
+			FlightTimes[AnglerIndex] = Result.FlightTime;
+			if (Result.bLanded)
+			{
+				SetMode(AnglerIndex, EHookMode::None);
+				Landed.Emplace(AnglerIndex, Index);
+			}
+		}
+		else if (Result.ZoneIndex != INDEX_NONE)
+		{
+			SetMode(AnglerIndex, EHookMode::None);
+			Pinned.Emplace(AnglerIndex, Index);
+		}
+	}
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const int32 AnglerIndex = SnapshotAnglers[Index];
+		if (Modes[AnglerIndex] == EHookMode::Flight)
+		{
+			if (AFishingGameCharacter* Angler = Owners[AnglerIndex].Get())
+			{
+				Angler->GetHookMesh()->SetWorldLocation(Results[Index].Location);
+			}
+		}
+	}
+	for (const TPair<int32, int32>& Landing : Landed)
+	{
+		if (AFishingGameCharacter* Angler = Owners[Landing.Key].Get())
+		{
+			Angler->LandHook(Results[Landing.Value].Location, Zones->GetZone(Results[Landing.Value].ZoneIndex));
+		}
+	}
+	for (const TPair<int32, int32>& Pin : Pinned)
+	{
+		if (AFishingGameCharacter* Angler = Owners[Pin.Key].Get())
+		{
+			Angler->PinHook(Zones->GetZone(Results[Pin.Value].ZoneIndex));
+		}
+	}
+
+	Landed.Reset();
+	Pinned.Reset();
+}
+
+TStatId UFishingAnglerUpdateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingAnglerUpdateSubsystem, STATGROUP_Tickables);
+}
+
+namespace FishingAnglerUpdate
+{
+	/** Milliseconds a frame of updating Initial with NumJobs jobs takes, averaged over NumFrames frames. */
+	static double TimeJobs(const TArray<UFishingAnglerUpdateSubsystem::FHookSnapshot>& Initial, TArray<UFishingAnglerUpdateSubsystem::FHookResult>& Results, int32 NumJobs, int32 NumFrames, float DeltaTime, const UFishingZoneSubsystem& Zones)
+	{
+		TArray<UFishingAnglerUpdateSubsystem::FHookSnapshot> Snapshots = Initial;
+
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			UFishingAnglerUpdateSubsystem::RunJobs(Snapshots, Results, NumJobs, DeltaTime, Zones);
+			for (int32 Index = 0; Index < Snapshots.Num(); ++Index)
+			{
+				Snapshots[Index].FlightTime = Results[Index].FlightTime;
+			}
+		}
+		return (FPlatformTime::Seconds() - Start) * 1000.0 / NumFrames;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.AnglerUpdateBench"),
+		TEXT("Times the angler update on synthetic hooks over this world's zones on 1 thread up to every task graph worker plus the game thread, ")
+		TEXT("then finds the batch size from which splitting it pays off. Run with -numworkerthreads=N for more or fewer workers. ")
+		TEXT("Usage: Fishing.AnglerUpdateBench [Anglers=20000] [Frames=100]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const UFishingZoneSubsystem* Zones = World ? World->GetSubsystem<UFishingZoneSubsystem>() : nullptr;
+			const UFishingAnglerUpdateSubsystem* Updates = World ? World->GetSubsystem<UFishingAnglerUpdateSubsystem>() : nullptr;
+			if (!Zones || !Updates)
+			{
+				return;
+			}
+
+			const int32 NumAnglers = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20000);
+			const int32 NumFrames = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100);
+			const float DeltaTime = 1.f / 60.f;
+
+			// Half the hooks fly a cast that lands within the bench, the other half simulate physics somewhere in the area
+			FRandomStream Random(0xF15);
+			TArray<UFishingAnglerUpdateSubsystem::FHookSnapshot> Initial;
+			Initial.SetNum(NumAnglers);
+			for (UFishingAnglerUpdateSubsystem::FHookSnapshot& Snapshot : Initial)
+			{
+				const FVector Origin(Random.FRandRange(-50000.f, 50000.f), Random.FRandRange(-50000.f, 50000.f), 100.f);
+				if (Random.FRand() < 0.5f)
+				{
+					Snapshot.Mode = UFishingAnglerUpdateSubsystem::EHookMode::Flight;
+					Snapshot.Trajectory = FFishingCastTrajectory(Origin, FVector(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f), 1.f) * 800.f, -980.f);
+					Snapshot.Trajectory.SolvePlaneLanding(0.f);
+				}
+				else
+				{
+					Snapshot.Mode = UFishingAnglerUpdateSubsystem::EHookMode::Physics;
+					Snapshot.Location = Origin;
+				}
+			}
+
+			// ParallelFor runs no more jobs at once than it has, so one job per thread bounds the threads taking part
+			const int32 MaxThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+			UE_LOG(LogFishingGame, Display, TEXT("Fishing angler update bench: %d anglers, %d frames, %d zones, %d task graph workers"),
+				NumAnglers, NumFrames, Zones->GetNumZones(), MaxThreads - 1);
+
+			TArray<UFishingAnglerUpdateSubsystem::FHookResult> Reference;
+			const double SerialMs = TimeJobs(Initial, Reference, 1, NumFrames, DeltaTime, *Zones);
+			UE_LOG(LogFishingGame, Display, TEXT("   1 thread:  %.3f ms a frame"), SerialMs);
+			for (int32 NumThreads = 2; NumThreads <= MaxThreads; NumThreads = NumThreads < MaxThreads ? FMath::Min(NumThreads * 2, MaxThreads) : MaxThreads + 1)
+			{
+				TArray<UFishingAnglerUpdateSubsystem::FHookResult> Results;
+				const double FrameMs = TimeJobs(Initial, Results, NumThreads, NumFrames, DeltaTime, *Zones);
+
+				bool bMatches = true;
+				for (int32 Index = 0; Index < Results.Num() && bMatches; ++Index)
+				{
+					bMatches = Results[Index].Location == Reference[Index].Location && Results[Index].ZoneIndex == Reference[Index].ZoneIndex && Results[Index].bLanded == Reference[Index].bLanded;
+				}
+
+				UE_LOG(LogFishingGame, Display, TEXT("  %2d threads: %.3f ms a frame, %.2fx one thread%s"),
+					NumThreads, FrameMs, FrameMs > 0.0 ? SerialMs / FrameMs : 0.0, bMatches ? TEXT("") : TEXT(", RESULTS DIFFER"));
+			}
+
+			// Small batches: the smallest one that two jobs update faster than one is where a split starts paying for the hand-off
+			if (MaxThreads > 1)
+			{
+				const int32 BatchFrames = NumFrames * 20;
+				int32 Crossover = INDEX_NONE;
+				for (int32 BatchSize = 8; BatchSize <= FMath::Min(NumAnglers, 1024); BatchSize *= 2)
+				{
+					const TArray<UFishingAnglerUpdateSubsystem::FHookSnapshot> Batch(Initial.GetData(), BatchSize);
+					TArray<UFishingAnglerUpdateSubsystem::FHookResult> Results;
+					const double InlineUs = TimeJobs(Batch, Results, 1, BatchFrames, DeltaTime, *Zones) * 1000.0;
+					const double SplitUs = TimeJobs(Batch, Results, 2, BatchFrames, DeltaTime, *Zones) * 1000.0;
+					UE_LOG(LogFishingGame, Display, TEXT("  %4d anglers: %.2f us inline, %.2f us in 2 jobs"), BatchSize, InlineUs, SplitUs);
+					if (Crossover == INDEX_NONE && SplitUs < InlineUs)
+					{
+						Crossover = BatchSize;
+					}
+				}
+
+				// Half the crossover didn't pay off yet, so batches up to it are best left inline
+				if (Crossover == INDEX_NONE)
+				{
+					UE_LOG(LogFishingGame, Display, TEXT("  AnglersPerJob is %d, up to that many hooks stay on the game thread; no batch measured pays off splitting"), Updates->AnglersPerJob);
+				}
+				else
+				{
+					UE_LOG(LogFishingGame, Display, TEXT("  AnglersPerJob is %d, up to that many hooks stay on the game thread; measured %d"), Updates->AnglersPerJob, Crossover / 2);
+				}
+			}
+		}));
+}
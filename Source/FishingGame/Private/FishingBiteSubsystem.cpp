@@ -0,0 +1,264 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingBiteSubsystem.h"
+#include "FishingGame.h"
+#include "FishingGameCharacter.h"
+#include "Engine/World.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+
+namespace FishingBite
+{
+	/**
+	 * The same anglers on an FFishingBiteWheel and on an FTimerManager with a timer and a delegate each, as before the wheel.
+	 * Bites come after a 3 to 15 s wait and escape 2 s later; every frame one angler in a thousand reels in early and recasts.
+	 * An FTimerManager only ticks once per engine frame, so the bench steps both one frame per engine frame on a clock of its own.
+	 */
+	struct FBench
+	{
+		static constexpr float MinWait = 3.f;
+		static constexpr float MaxWait = 15.f;
+		static constexpr float EscapeWindow = 2.f;
+		static constexpr float DeltaTime = 1.f / 60.f;
+
+		TArray<int32> AnglerCounts;
+		int32 NumFrames = 0;
+
+		int32 NumAnglers = 0;
+		int32 RecastsPerFrame = 0;
+		int32 Frame = 0;
+		double Now = 0.0;
+
+		FFishingBiteWheel Wheel;
+		FRandomStream WheelRandom;
+		int32 WheelFires = 0;
+		double WheelMs = 0.0;
+
+		TUniquePtr<FTimerManager> TimerManager;
+		FRandomStream TimerRandom;
+		TArray<FTimerHandle> Handles;
+		TArray<bool> Biting;
+		int32 TimerFires = 0;
+		double TimerMs = 0.0;
+
+		void Start(int32 InNumAnglers)
+		{
+			NumAnglers = InNumAnglers;
+			RecastsPerFrame = FMath::Max(NumAnglers / 1000, 1);
+			Frame = 0;
+			Now = 0.0;
+
+			Wheel = FFishingBiteWheel();
+			WheelRandom.Initialize(0xB17E);
+			WheelFires = 0;
+			WheelMs = 0.0;
+			for (int32 Index = 0; Index < NumAnglers; ++Index)
+			{
+				Wheel.Schedule(Wheel.AddAngler(), FFishingBiteWheel::EState::Waiting, WheelRandom.FRandRange(MinWait, MaxWait), Now);
+			}
+
+			TimerManager = MakeUnique<FTimerManager>();
+			TimerRandom.Initialize(0xB17E);
+			Handles.Reset();
+			Handles.SetNum(NumAnglers);
+			Biting.Reset();
+			Biting.SetNumZeroed(NumAnglers);
+			TimerFires = 0;
+			TimerMs = 0.0;
+			for (int32 Index = 0; Index < NumAnglers; ++Index)
+			{
+				ArmTimer(Index, TimerRandom.FRandRange(MinWait, MaxWait));
+			}
+		}
+
+		void ArmTimer(int32 AnglerIndex, float Delay)
+		{
+			TimerManager->SetTimer(Handles[AnglerIndex], FTimerDelegate::CreateLambda([this, AnglerIndex]() { FireTimer(AnglerIndex); }), Delay, false);
+		}
+
+		void FireTimer(int32 AnglerIndex)
+		{
+			++TimerFires;
+			Biting[AnglerIndex] = !Biting[AnglerIndex];
+			ArmTimer(AnglerIndex, Biting[AnglerIndex] ? EscapeWindow : TimerRandom.FRandRange(MinWait, MaxWait));
+		}
+
+		void StepWheel()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			Wheel.Advance(Now);
+			for (int32 AnglerIndex : Wheel.GetExpiredWaits())
+			{
+				Wheel.Schedule(AnglerIndex, FFishingBiteWheel::EState::Biting, EscapeWindow, Now);
+			}
+			for (int32 AnglerIndex : Wheel.GetExpiredBites())
+			{
+				Wheel.Schedule(AnglerIndex, FFishingBiteWheel::EState::Waiting, WheelRandom.FRandRange(MinWait, MaxWait), Now);
+			}
+			WheelFires += Wheel.GetExpiredWaits().Num() + Wheel.GetExpiredBites().Num();
+			Wheel.ResetExpired();
+
+			for (int32 Recast = 0; Recast < RecastsPerFrame; ++Recast)
+			{
+				Wheel.Schedule(WheelRandom.RandHelper(NumAnglers), FFishingBiteWheel::EState::Waiting, WheelRandom.FRandRange(MinWait, MaxWait), Now);
+			}
+
+			WheelMs += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		}
+
+		void StepTimers()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			TimerManager->Tick(DeltaTime);
+
+			for (int32 Recast = 0; Recast < RecastsPerFrame; ++Recast)
+			{
+				const int32 AnglerIndex = TimerRandom.RandHelper(NumAnglers);
+				Biting[AnglerIndex] = false;
+				ArmTimer(AnglerIndex, TimerRandom.FRandRange(MinWait, MaxWait));
+			}
+
+			TimerMs += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		}
+
+		void Report() const
+		{
+			UE_LOG(LogFishingGame, Display, TEXT("Fishing bite bench: %d anglers, %d frames, %d recasts a frame"), NumAnglers, NumFrames, RecastsPerFrame);
+			UE_LOG(LogFishingGame, Display, TEXT("  timing wheel:  %.4f ms a frame, %d deadlines fired"), WheelMs / NumFrames, WheelFires);
+			UE_LOG(LogFishingGame, Display, TEXT("  timer manager: %.4f ms a frame, %d deadlines fired, %.2fx the wheel"),
+				TimerMs / NumFrames, TimerFires, WheelMs > 0.0 ? TimerMs / WheelMs : 0.0);
+		}
+
+		/** One bench frame per engine frame, then the next angler count. False once every count has run. */
+		bool Tick(float)
+		{
+			Now += DeltaTime;
+			StepWheel();
+			StepTimers();
+
+			if (++Frame < NumFrames)
+			{
+				return true;
+			}
+
+			Report();
+			if (AnglerCounts.Num() > 0)
+			{
+				Start(AnglerCounts[0]);
+				AnglerCounts.RemoveAt(0);
+				return true;
+			}
+
+			TimerManager.Reset();
+			return false;
+		}
+	};
+
+	static TSharedPtr<FBench> RunningBench;
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.BiteBench"),
+		TEXT("Times the bite timing wheel against an FTimerManager with a timer per angler, both on throwaway state, for a minute of anglers ")
+		TEXT("waiting, biting and recasting. Steps one bench frame per engine frame. Usage: Fishing.BiteBench [Anglers=1000,10000] [Frames=3600]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (RunningBench.IsValid())
+			{
+				return;
+			}
+
+			// Kept out of the world's own anglers, which go on untouched
+			RunningBench = MakeShared<FBench>();
+			RunningBench->AnglerCounts = { 1000, 10000 };
+			if (Args.Num() > 0)
+			{
+				RunningBench->AnglerCounts = { FMath::Max(1, FCString::Atoi(*Args[0])) };
+			}
+			RunningBench->NumFrames = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 3600);
+
+			RunningBench->Start(RunningBench->AnglerCounts[0]);
+			RunningBench->AnglerCounts.RemoveAt(0);
+			FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+			{
+				const bool bRunning = RunningBench->Tick(DeltaTime);
+				if (!bRunning)
+				{
+					RunningBench.Reset();
+				}
+				return bRunning;
+			}));
+		}));
+}
+
+int32 UFishingBiteSubsystem::RegisterAngler(AFishingGameCharacter* Angler)
+{
+	const int32 AnglerIndex = Wheel.AddAngler();
+	if (!Owners.IsValidIndex(AnglerIndex))
+	{
+		Owners.SetNum(AnglerIndex + 1);
+	}
+	Owners[AnglerIndex] = Angler;
+	return AnglerIndex;
+}
+
+void UFishingBiteSubsystem::UnregisterAngler(int32 AnglerIndex)
+{
+	Wheel.RemoveAngler(AnglerIndex);
+	if (Owners.IsValidIndex(AnglerIndex))
+	{
+		Owners[AnglerIndex] = nullptr;
+	}
+}
+
+void UFishingBiteSubsystem::ArmBite(int32 AnglerIndex, float WaitTime)
+{
+	Wheel.Schedule(AnglerIndex, FFishingBiteWheel::EState::Waiting, WaitTime, GetWorld()->GetTimeSeconds());
+}
+
+void UFishingBiteSubsystem::ArmEscape(int32 AnglerIndex, float Window)
+{
+	Wheel.Schedule(AnglerIndex, FFishingBiteWheel::EState::Biting, Window, GetWorld()->GetTimeSeconds());
+}
+
+void UFishingBiteSubsystem::Cancel(int32 AnglerIndex)
+{
+	Wheel.Cancel(AnglerIndex);
+}
+
+void UFishingBiteSubsystem::Deinitialize()
+{
+	Wheel.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFishingBiteSubsystem::Tick(float DeltaTime)
+{
+	Wheel.Advance(GetWorld()->GetTimeSeconds());
+
+	for (int32 AnglerIndex : Wheel.GetExpiredWaits())
+	{
+		if (AFishingGameCharacter* Angler = Owners[AnglerIndex].Get())
+		{
+			Angler->FishBite();
+		}
+	}
+	for (int32 AnglerIndex : Wheel.GetExpiredBites())
+	{
+		if (AFishingGameCharacter* Angler = Owners[AnglerIndex].Get())
+		{
+			Angler->StartFishing();
+		}
+	}
+
+	Wheel.ResetExpired();
+}
+
+TStatId UFishingBiteSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingBiteSubsystem, STATGROUP_Tickables);
+}
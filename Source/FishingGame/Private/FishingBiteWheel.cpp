@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingBiteWheel.h"
+
+int32 FFishingBiteWheel::AddAngler()
+{
+	int32 AnglerIndex;
+	if (FreeIndices.Num() > 0)
+	{
+		AnglerIndex = FreeIndices.Pop(false);
+	}
+	else
+	{
+		AnglerIndex = States.Add(EState::Free);
+		DeadlineTicks.Add(0);
+		DeadlineTimes.Add(0.0);
+		Generations.Add(0);
+	}
+
+	States[AnglerIndex] = EState::Idle;
+	return AnglerIndex;
+}
+
+void FFishingBiteWheel::RemoveAngler(int32 AnglerIndex)
+{
+	if (States.IsValidIndex(AnglerIndex) && States[AnglerIndex] != EState::Free)
+	{
+		Cancel(AnglerIndex);
+		States[AnglerIndex] = EState::Free;
+		FreeIndices.Add(AnglerIndex);
+	}
+}
+
+void FFishingBiteWheel::Schedule(int32 AnglerIndex, EState State, float Delay, double Now)
+{
+	if (!States.IsValidIndex(AnglerIndex) || States[AnglerIndex] == EState::Free)
+	{
+		return;
+	}
+
+	Cancel(AnglerIndex);
+
+	if (NumPending == 0)
+	{
+		// Wheel was idle, fast forward it instead of walking every empty bucket since the last deadline
+		CurrentTick = GetWheelTick(Now);
+	}
+
+	const double Deadline = Now + FMath::Max(Delay, 0.f);
+	DeadlineTimes[AnglerIndex] = Deadline;
+	DeadlineTicks[AnglerIndex] = FMath::Max(CurrentTick + 1, (uint64)FMath::CeilToDouble(Deadline / TickInterval));
+	States[AnglerIndex] = State;
+	++NumPending;
+
+	Insert({ AnglerIndex, Generations[AnglerIndex] });
+}
+
+void FFishingBiteWheel::Cancel(int32 AnglerIndex)
+{
+	if (States.IsValidIndex(AnglerIndex) && (States[AnglerIndex] == EState::Waiting || States[AnglerIndex] == EState::Biting))
+	{
+		// Leaves the stale wheel entry behind, it is dropped when its bucket comes up
+		++Generations[AnglerIndex];
+		States[AnglerIndex] = EState::Idle;
+		--NumPending;
+	}
+}
+
+void FFishingBiteWheel::Advance(double Now)
+{
+	const uint64 TargetTick = GetWheelTick(Now);
+	while (CurrentTick < TargetTick && NumPending > ExpiredWaits.Num() + ExpiredBites.Num())
+	{
+		++CurrentTick;
+
+		if (CurrentTick % InnerSlots == 0)
+		{
+			const uint64 Rotation = CurrentTick / InnerSlots;
+			if (Rotation % OuterSlots == 0)
+			{
+				TArray<FEntry> Pending = MoveTemp(Overflow);
+				for (const FEntry& Entry : Pending)
+				{
+					if (IsCurrent(Entry))
+					{
+						Insert(Entry);
+					}
+				}
+			}
+
+			TArray<FEntry> Cascading = MoveTemp(OuterWheel[Rotation % OuterSlots]);
+			for (const FEntry& Entry : Cascading)
+			{
+				if (IsCurrent(Entry))
+				{
+					Insert(Entry);
+				}
+			}
+		}
+
+		TArray<FEntry>& Slot = InnerWheel[CurrentTick % InnerSlots];
+		for (const FEntry& Entry : Slot)
+		{
+			if (IsCurrent(Entry))
+			{
+				(States[Entry.AnglerIndex] == EState::Waiting ? ExpiredWaits : ExpiredBites).Add(Entry.AnglerIndex);
+			}
+		}
+		Slot.Reset();
+	}
+
+	// Settle state for the whole batch first, callers are free to re-arm the anglers as they go through the lists
+	for (int32 AnglerIndex : ExpiredWaits)
+	{
+		Cancel(AnglerIndex);
+	}
+	for (int32 AnglerIndex : ExpiredBites)
+	{
+		Cancel(AnglerIndex);
+	}
+}
+
+void FFishingBiteWheel::ResetExpired()
+{
+	ExpiredWaits.Reset();
+	ExpiredBites.Reset();
+}
+
+void FFishingBiteWheel::Empty()
+{
+	for (int32 AnglerIndex = 0; AnglerIndex < States.Num(); ++AnglerIndex)
+	{
+		Cancel(AnglerIndex);
+	}
+	for (TArray<FEntry>& Slot : InnerWheel)
+	{
+		Slot.Empty();
+	}
+	for (TArray<FEntry>& Slot : OuterWheel)
+	{
+		Slot.Empty();
+	}
+	Overflow.Empty();
+	ResetExpired();
+}
+
+void FFishingBiteWheel::Insert(const FEntry& Entry)
+{
+	const uint64 Deadline = DeadlineTicks[Entry.AnglerIndex];
+
+	if (Deadline - CurrentTick < InnerSlots)
+	{
+		InnerWheel[Deadline % InnerSlots].Add(Entry);
+	}
+	else if (Deadline / InnerSlots - CurrentTick / InnerSlots < OuterSlots)
+	{
+		OuterWheel[(Deadline / InnerSlots) % OuterSlots].Add(Entry);
+	}
+	else
+	{
+		Overflow.Add(Entry);
+	}
+}
+
+bool FFishingBiteWheel::IsCurrent(const FEntry& Entry) const
+{
+	return Generations[Entry.AnglerIndex] == Entry.Generation;
+}
+
+uint64 FFishingBiteWheel::GetWheelTick(double Time)
+{
+	return (uint64)FMath::FloorToDouble(Time / TickInterval);
+}
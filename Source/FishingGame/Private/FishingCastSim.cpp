@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingCastSim.h"
+#include "FishingGame.h"
+#include "HAL/IConsoleManager.h"
+
+namespace FishingCastSimCheck
+{
+	/** One happening of the scripted session: a button input, or a bite armed BiteDelay after the hook lands at Time. */
+	struct FScriptEntry
+	{
+		double Time;
+		FFishingCastSim::EInput Input;
+		bool bArmBite;
+		double BiteDelay;
+		float EscapeWindow;
+	};
+
+	using EInput = FFishingCastSim::EInput;
+
+	static const FScriptEntry Script[] =
+	{
+		{ 0.4137, EInput::CastPressed, false, 0.0, 0.f },
+		{ 1.6021, EInput::CastReleased, false, 0.0, 0.f },
+		{ 2.3009, EInput::ReelPressed, true, 1.1177, 2.f },
+		{ 4.9113, EInput::ReelPressed, false, 0.0, 0.f },
+		{ 5.2031, EInput::CastPressed, false, 0.0, 0.f },
+		{ 6.7044, EInput::CastReleased, false, 0.0, 0.f },
+		// Reeled 10 ms before the fish escapes
+		{ 7.0123, EInput::ReelPressed, true, 1.9877, 0.75f },
+		{ 9.7401, EInput::ReelPressed, false, 0.0, 0.f },
+		// Reeled 0.4 ms after it escaped
+		{ 10.1, EInput::ReelPressed, true, 0.4, 2.f },
+		{ 12.5004, EInput::ReelPressed, false, 0.0, 0.f },
+	};
+
+	static constexpr int32 ScriptSeconds = 14;
+
+	/** Plays Script at Fps, handing each entry over on the first frame at or after it, stamped with its own time or, with bFrameStamped, the frame's. */
+	static TArray<FFishingCastSim::FEvent> Run(int32 Fps, bool bFrameStamped, uint64& OutSteps)
+	{
+		FFishingCastSim Sim;
+		Sim.Reset(FFishingCastSim::FSettings(), 0.0);
+
+		TArray<FFishingCastSim::FEvent> Events;
+		int32 Next = 0;
+		for (int32 Frame = 1; Frame <= ScriptSeconds * Fps; ++Frame)
+		{
+			const double FrameTime = (double)Frame / Fps;
+			for (; Next < UE_ARRAY_COUNT(Script) && Script[Next].Time <= FrameTime; ++Next)
+			{
+				const FScriptEntry& Entry = Script[Next];
+				const double Time = bFrameStamped ? FrameTime : Entry.Time;
+				if (Entry.bArmBite)
+				{
+					Sim.Advance(Time);
+					Sim.ArmBite(Time + Entry.BiteDelay, Entry.EscapeWindow);
+				}
+				else
+				{
+					Sim.AddInput(Entry.Input, Time);
+				}
+			}
+
+			Sim.Advance(FrameTime);
+			FFishingCastSim::FEvent Event;
+			while (Sim.PopEvent(Event))
+			{
+				Events.Add(Event);
+			}
+		}
+
+		OutSteps = Sim.GetStepCount();
+		return Events;
+	}
+
+	static FString Describe(const TArray<FFishingCastSim::FEvent>& Events)
+	{
+		static const TCHAR* Names[] = { TEXT("thrown"), TEXT("bite"), TEXT("escaped"), TEXT("hooked"), TEXT("empty") };
+
+		FString Result;
+		for (const FFishingCastSim::FEvent& Event : Events)
+		{
+			Result += FString::Printf(TEXT(" %s@%.4f"), Names[(int32)Event.Type], Event.Time);
+			if (Event.Type == FFishingCastSim::EEventType::Thrown || Event.Type == FFishingCastSim::EEventType::Hooked)
+			{
+				Result += FString::Printf(TEXT("(%.4f)"), Event.Value);
+			}
+		}
+		return Result;
+	}
+
+	static FAutoConsoleCommand CastSimCommand(
+		TEXT("Fishing.CastSim"),
+		TEXT("Plays a scripted cast, bite and reel session through the cast simulation at 20, 60 and 240 fps and checks each frame rate ends with the same outcomes."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const int32 FrameRates[] = { 20, 60, 240 };
+
+			uint64 ReferenceSteps = 0;
+			const TArray<FFishingCastSim::FEvent> Reference = Run(FrameRates[0], false, ReferenceSteps);
+
+			bool bIdentical = true;
+			for (int32 Fps : FrameRates)
+			{
+				uint64 Steps = 0;
+				uint64 FrameSteps = 0;
+				const TArray<FFishingCastSim::FEvent> Events = Run(Fps, false, Steps);
+				const TArray<FFishingCastSim::FEvent> FrameStamped = Run(Fps, true, FrameSteps);
+				bIdentical &= Events == Reference && Steps == ReferenceSteps;
+
+				UE_LOG(LogFishingGame, Display, TEXT("Fishing cast sim: %3d fps, %llu steps:%s"), Fps, Steps, *Describe(Events));
+				UE_LOG(LogFishingGame, Display, TEXT("  stamped by frame:%s"), *Describe(FrameStamped));
+			}
+
+			if (bIdentical)
+			{
+				UE_LOG(LogFishingGame, Display, TEXT("Fishing cast sim: identical outcomes at every frame rate"));
+			}
+			else
+			{
+				UE_LOG(LogFishingGame, Warning, TEXT("Fishing cast sim: outcomes differ between frame rates"));
+			}
+		}));
+}
+
+void FFishingCastSim::Reset(const FSettings& InSettings, double InStartTime)
+{
+	Settings = InSettings;
+	StepSeconds = 1.0 / FMath::Max(Settings.StepRate, 1.f);
+	Phase = EPhase::Idle;
+	StartTime = InStartTime;
+	Time = InStartTime;
+	StepTime = InStartTime;
+	StepCount = 0;
+	Charge = 0.f;
+	Events.Reset();
+}
+
+void FFishingCastSim::AddInput(EInput Input, double InputTime)
+{
+	InputTime = FMath::Max(InputTime, Time);
+	Advance(InputTime);
+
+	switch (Input)
+	{
+	case EInput::CastPressed:
+		Phase = EPhase::Charging;
+		PressTime = InputTime;
+		Charge = 0.f;
+		break;
+	case EInput::CastReleased:
+		if (Phase == EPhase::Charging)
+		{
+			Phase = EPhase::Idle;
+			Charge = 0.f;
+			Emit(EEventType::Thrown, InputTime, (float)FMath::Min((InputTime - PressTime) * Settings.ChargeRate, 1.0));
+		}
+		break;
+	case EInput::ReelPressed:
+		if (Phase == EPhase::Biting)
+		{
+			Emit(EEventType::Hooked, InputTime, (float)(InputTime - BiteTime));
+		}
+		else
+		{
+			Emit(EEventType::ReeledEmpty, InputTime);
+		}
+		Phase = EPhase::Idle;
+		break;
+	}
+}
+
+void FFishingCastSim::ArmBite(double InBiteTime, float InEscapeWindow)
+{
+	Phase = EPhase::Waiting;
+	Charge = 0.f;
+	BiteTime = InBiteTime;
+	EscapeWindow = FMath::Max(InEscapeWindow, 0.f);
+	EscapeTime = BiteTime + EscapeWindow;
+}
+
+void FFishingCastSim::Cancel()
+{
+	Phase = EPhase::Idle;
+	Charge = 0.f;
+}
+
+void FFishingCastSim::Advance(double ToTime)
+{
+	if (Phase != EPhase::Charging)
+	{
+		// Nothing continuous to integrate, skip to just short of the next deadline and let the loop below take the last steps
+		const double SkipTo = FMath::Min(ToTime, GetNextDeadline());
+		const uint64 SkipCount = (uint64)FMath::Max(FMath::FloorToDouble((SkipTo - StartTime) / StepSeconds) - 1.0, 0.0);
+		if (SkipCount > StepCount)
+		{
+			StepCount = SkipCount;
+			StepTime = StartTime + StepSeconds * StepCount;
+			Time = FMath::Max(Time, StepTime);
+		}
+	}
+
+	for (;;)
+	{
+		// Recomputed from the step count rather than accumulated, so every chunking lands on bit identical step times
+		const double NextStepTime = StartTime + StepSeconds * (StepCount + 1);
+		const double Deadline = GetNextDeadline();
+
+		if (Deadline <= ToTime && Deadline <= NextStepTime)
+		{
+			Time = FMath::Max(Time, Deadline);
+			ResolveDeadline();
+		}
+		else if (NextStepTime <= ToTime)
+		{
+			StepTime = NextStepTime;
+			++StepCount;
+			Time = FMath::Max(Time, StepTime);
+			Step();
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	Time = FMath::Max(Time, ToTime);
+}
+
+bool FFishingCastSim::PopEvent(FEvent& OutEvent)
+{
+	if (Events.Num() == 0)
+	{
+		return false;
+	}
+	OutEvent = Events[0];
+	Events.RemoveAt(0, 1, false);
+	return true;
+}
+
+double FFishingCastSim::GetNextDeadline() const
+{
+	switch (Phase)
+	{
+	case EPhase::Waiting:
+		return BiteTime;
+	case EPhase::Biting:
+		return EscapeTime;
+	default:
+		return MAX_dbl;
+	}
+}
+
+void FFishingCastSim::ResolveDeadline()
+{
+	if (Phase == EPhase::Waiting)
+	{
+		Phase = EPhase::Biting;
+		Emit(EEventType::Bite, BiteTime);
+	}
+	else if (Phase == EPhase::Biting)
+	{
+		Phase = EPhase::Idle;
+		Emit(EEventType::Escaped, EscapeTime);
+	}
+}
+
+void FFishingCastSim::Step()
+{
+	// Continuous state goes here, the reel and line tension minigame included, integrated over StepSeconds
+	if (Phase == EPhase::Charging)
+	{
+		Charge = (float)FMath::Clamp((StepTime - PressTime) * Settings.ChargeRate, 0.0, 1.0);
+	}
+}
+
+void FFishingCastSim::Emit(EEventType Type, double EventTime, float Value)
+{
+	Events.Add({ Type, EventTime, Value });
+}
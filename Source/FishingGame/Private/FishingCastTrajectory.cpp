@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingCastTrajectory.h"
+#include "FishingZoneSubsystem.h"
+#include "Engine/World.h"
+
+namespace FishingCastTrajectory
+{
+	/** How far below the reference plane the landing query still looks for a surface. */
+	static constexpr float MaxSurfaceDrop = 2000.f;
+
+	/** Farthest the straight segments the path is traced in may stray from the curve. */
+	static constexpr float MaxSag = 10.f;
+
+	/** A two second cast stays within MaxSag at 7 segments, longer ones give up a little accuracy rather than queries. */
+	static constexpr int32 MaxSegments = 8;
+}
+
+float FFishingCastTrajectory::GetApexHeight() const
+{
+	if (GravityZ >= 0.f || Velocity.Z <= 0.f)
+	{
+		return Origin.Z;
+	}
+	return Origin.Z - (Velocity.Z * Velocity.Z) / (2.f * GravityZ);
+}
+
+float FFishingCastTrajectory::GetTimeAtHeight(float Z) const
+{
+	if (GravityZ >= 0.f)
+	{
+		return -1.f;
+	}
+
+	// 0.5 * g * t^2 + Vz * t + (Oz - Z) = 0, the larger root is on the way down
+	const float Discriminant = Velocity.Z * Velocity.Z - 2.f * GravityZ * (Origin.Z - Z);
+	if (Discriminant < 0.f)
+	{
+		return -1.f;
+	}
+	return (Velocity.Z + FMath::Sqrt(Discriminant)) / -GravityZ;
+}
+
+bool FFishingCastTrajectory::SolvePlaneLanding(float PlaneZ)
+{
+	LandingTime = GetTimeAtHeight(PlaneZ);
+	bHasLanding = LandingTime >= 0.f;
+	LandingLocation = bHasLanding ? GetLocationAtTime(LandingTime) : Origin;
+	return bHasLanding;
+}
+
+bool FFishingCastTrajectory::SolveLanding(const UWorld* World, float ReferenceZ, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, const UFishingZoneSubsystem* Zones)
+{
+	if (!SolvePlaneLanding(ReferenceZ - FishingCastTrajectory::MaxSurfaceDrop) || !World)
+	{
+		return bHasLanding;
+	}
+
+	// A single straight sweep to the landing point would cut under the arc into the shore or the angler's own dock, so the arc is
+	// traced as a few chords. A chord over Dt strays g * Dt^2 / 8 from the curve at most.
+	const int32 NumSegments = FMath::Clamp(FMath::CeilToInt(LandingTime * FMath::Sqrt(-GravityZ / (8.f * FishingCastTrajectory::MaxSag))), 1, FishingCastTrajectory::MaxSegments);
+	const float EndTime = LandingTime;
+
+	FVector SegmentStart = Origin;
+	float StartTime = 0.f;
+	for (int32 Segment = 1; Segment <= NumSegments; ++Segment)
+	{
+		const float SegmentTime = EndTime * Segment / NumSegments;
+		const FVector SegmentEnd = GetLocationAtTime(SegmentTime);
+
+		FHitResult Hit;
+		if (World->LineTraceSingleByChannel(Hit, SegmentStart, SegmentEnd, TraceChannel, Params))
+		{
+			LandingTime = FMath::Lerp(StartTime, SegmentTime, Hit.Time);
+			LandingLocation = Hit.ImpactPoint;
+			break;
+		}
+
+		if (Segment < NumSegments)
+		{
+			SegmentStart = SegmentEnd;
+			StartTime = SegmentTime;
+		}
+	}
+
+	// One zone query over the chord the path came down on: a zone box reaching above the water takes the hook where it enters it
+	FVector ZoneEntry;
+	if (Zones && Zones->FindZoneAlongSegment(SegmentStart, LandingLocation, &ZoneEntry))
+	{
+		const FVector Chord = LandingLocation - SegmentStart;
+		const float ZoneFraction = FMath::Clamp(Chord.SizeSquared() > KINDA_SMALL_NUMBER ? FVector::DotProduct(ZoneEntry - SegmentStart, Chord) / Chord.SizeSquared() : 0.f, 0.f, 1.f);
+		LandingTime = FMath::Lerp(StartTime, LandingTime, ZoneFraction);
+		LandingLocation = ZoneEntry;
+	}
+	return bHasLanding;
+}
+
+void FFishingCastTrajectory::GetPreviewPoints(int32 NumPoints, TArray<FVector>& OutPoints) const
+{
+	OutPoints.Reset(NumPoints);
+	if (NumPoints < 2)
+	{
+		return;
+	}
+
+	const float EndTime = bHasLanding ? LandingTime : 1.f;
+	for (int32 Index = 0; Index < NumPoints; ++Index)
+	{
+		OutPoints.Add(GetLocationAtTime(EndTime * Index / (NumPoints - 1)));
+	}
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingCastingBarWidget.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/Image.h"
+#include "Components/InvalidationBox.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Misc/App.h"
+
+void UFishingCastingBarWidget::NativeOnInitialized()
+{
+	Super::NativeOnInitialized();
+
+	if (!FillImage && WidgetTree && !WidgetTree->RootWidget)
+	{
+		UInvalidationBox* Root = WidgetTree->ConstructWidget<UInvalidationBox>(UInvalidationBox::StaticClass(), TEXT("CastingBarCache"));
+		FillImage = WidgetTree->ConstructWidget<UImage>(UImage::StaticClass(), TEXT("FillImage"));
+		Root->AddChild(FillImage);
+		WidgetTree->RootWidget = Root;
+
+		SetAnchorsInViewport(FAnchors(BarAnchor.X, BarAnchor.Y));
+		SetAlignmentInViewport(FVector2D(0.5f, 0.5f));
+		SetDesiredSizeInViewport(BarSize);
+	}
+
+	if (FillImage && FillMaterial)
+	{
+		FillMID = UMaterialInstanceDynamic::Create(FillMaterial, this);
+		FillImage->SetBrushFromMaterial(FillMID);
+	}
+
+	SetVisibility(ESlateVisibility::Collapsed);
+}
+
+void UFishingCastingBarWidget::StartCharging()
+{
+	SyncedCharge = 0.f;
+	SyncedFillRate = 0.f;
+	if (FillMID)
+	{
+		FillMID->SetScalarParameterValue(StartChargeParameter, 0.f);
+		FillMID->SetScalarParameterValue(FillRateParameter, 0.f);
+	}
+	SetVisibility(ESlateVisibility::HitTestInvisible);
+}
+
+void UFishingCastingBarWidget::SyncCharge(float Charge, float FillRate)
+{
+	// Slate feeds user interface materials application time since startup as Time
+	const float Now = FApp::GetCurrentTime() - GStartTime;
+	const float Shown = FMath::Clamp(SyncedCharge + (Now - SyncedTime) * SyncedFillRate, 0.f, 1.f);
+	if (FillRate == SyncedFillRate && FMath::Abs(Shown - Charge) <= ResyncTolerance)
+	{
+		return;
+	}
+
+	SyncedTime = Now;
+	SyncedCharge = Charge;
+	SyncedFillRate = FillRate;
+	if (FillMID)
+	{
+		FillMID->SetScalarParameterValue(StartTimeParameter, SyncedTime);
+		FillMID->SetScalarParameterValue(StartChargeParameter, SyncedCharge);
+		FillMID->SetScalarParameterValue(FillRateParameter, SyncedFillRate);
+	}
+}
+
+void UFishingCastingBarWidget::StopCharging()
+{
+	SetVisibility(ESlateVisibility::Collapsed);
+}
@@ -0,0 +1,447 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingCatchJournal.h"
+#include "FishingGame.h"
+#include "FishingZone.h"
+#include "Containers/Queue.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+
+namespace FishingJournal
+{
+	constexpr uint32 Magic = 0x4A434646; // "FFCJ"
+	constexpr uint32 JournalVersion = 1;
+
+	/** Magic, version, record size and a reserved word. */
+	constexpr int64 HeaderSize = 16;
+
+	/** The writer flushes at least this often, or as soon as a batch of this many catches is waiting. */
+	constexpr uint32 FlushIntervalMs = 1000;
+	constexpr int32 FlushBatchSize = 256;
+
+	static FString GetSegmentPath(const FString& Directory, int32 Segment)
+	{
+		return Directory / FString::Printf(TEXT("Catches_%06d.fcj"), Segment);
+	}
+
+	FORCEINLINE int64 MakeRecordId(int32 Segment, int32 Index)
+	{
+		return ((int64)Segment << 32) | (uint32)Index;
+	}
+}
+
+/** Drains appended catches on its own thread and writes them to the segment files in batches. */
+class FFishingCatchJournalWriter : public FRunnable
+{
+public:
+	FFishingCatchJournalWriter(const FString& InDirectory, int32 InFirstSegment, int32 InSegmentCapacity)
+		: Directory(InDirectory)
+		, CurrentSegment(InFirstSegment)
+		, SegmentCapacity(InSegmentCapacity)
+		, SealedSegment(InFirstSegment)
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, TEXT("FishingCatchJournal"), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FFishingCatchJournalWriter()
+	{
+		Stop();
+		if (Thread)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+		}
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	}
+
+	/** Game thread only. */
+	void Enqueue(const FFishingCatchRecord& Record)
+	{
+		Queue.Enqueue(Record);
+		if (++NumQueued % FishingJournal::FlushBatchSize == 0)
+		{
+			WakeEvent->Trigger();
+		}
+	}
+
+	/** Segments before this one are complete on disk and closed. */
+	FORCEINLINE int32 GetSealedSegment() const { return SealedSegment.Load(); }
+
+	virtual uint32 Run() override
+	{
+		while (!bStopping.Load())
+		{
+			WakeEvent->Wait(FishingJournal::FlushIntervalMs);
+			WriteQueued();
+		}
+		WriteQueued();
+		CloseSegment();
+
+		NumDropped += SegmentDropped;
+		if (NumDropped > 0)
+		{
+			UE_LOG(LogFishingGame, Error, TEXT("Catch journal: %lld catches this session couldn't be written"), NumDropped);
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping.Store(true);
+		WakeEvent->Trigger();
+	}
+
+private:
+	void WriteQueued()
+	{
+		FFishingCatchRecord Record;
+		bool bWrote = false;
+		while (Queue.Dequeue(Record))
+		{
+			// A segment that can't be opened still takes its share of catches, so the segments stay where the game thread indexed them
+			if (!File && !bSegmentFailed && !OpenSegment())
+			{
+				bSegmentFailed = true;
+			}
+
+			if (File)
+			{
+				File->Serialize(&Record, sizeof(Record));
+				bWrote = true;
+			}
+			else
+			{
+				++SegmentDropped;
+			}
+
+			if (++SegmentRecords == SegmentCapacity)
+			{
+				SealSegment();
+			}
+		}
+
+		if (bWrote && File)
+		{
+			File->Flush();
+		}
+	}
+
+	bool OpenSegment()
+	{
+		File.Reset(IFileManager::Get().CreateFileWriter(*FishingJournal::GetSegmentPath(Directory, CurrentSegment)));
+		if (!File)
+		{
+			UE_LOG(LogFishingGame, Error, TEXT("Catch journal: can't open %s, dropping the catches that go in it"), *FishingJournal::GetSegmentPath(Directory, CurrentSegment));
+			return false;
+		}
+
+		uint32 Header[4] = { FishingJournal::Magic, FishingJournal::JournalVersion, sizeof(FFishingCatchRecord), 0 };
+		File->Serialize(Header, sizeof(Header));
+		return true;
+	}
+
+	void SealSegment()
+	{
+		CloseSegment();
+		if (SegmentDropped > 0)
+		{
+			UE_LOG(LogFishingGame, Error, TEXT("Catch journal: dropped %d catches of %s, they only last for this session"),
+				SegmentDropped, *FishingJournal::GetSegmentPath(Directory, CurrentSegment));
+		}
+
+		NumDropped += SegmentDropped;
+		SegmentDropped = 0;
+		SegmentRecords = 0;
+		bSegmentFailed = false;
+		++CurrentSegment;
+		SealedSegment.Store(CurrentSegment);
+	}
+
+	void CloseSegment()
+	{
+		if (File)
+		{
+			File->Close();
+			File.Reset();
+		}
+	}
+
+	FString Directory;
+	int32 CurrentSegment;
+	int32 SegmentCapacity;
+	int32 SegmentRecords = 0;
+	TUniquePtr<FArchive> File;
+
+	/** The current segment couldn't be opened, the rest of its catches are dropped rather than written at the wrong index. */
+	bool bSegmentFailed = false;
+	int32 SegmentDropped = 0;
+	int64 NumDropped = 0;
+
+	TQueue<FFishingCatchRecord, EQueueMode::Spsc> Queue;
+	int64 NumQueued = 0;
+
+	TAtomic<int32> SealedSegment;
+	TAtomic<bool> bStopping { false };
+	FEvent* WakeEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+};
+
+FFishingCatchJournal::FFishingCatchJournal(const FString& InDirectory, int32 InSegmentCapacity)
+	: Directory(InDirectory)
+	, SegmentCapacity(FMath::Max(1, InSegmentCapacity))
+{
+	IFileManager::Get().MakeDirectory(*Directory, true);
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Directory / TEXT("Catches_*.fcj")), true, false);
+	Files.Sort();
+
+	// Earlier sessions are sealed, map them and index what they hold
+	for (const FString& FileName : Files)
+	{
+		FSegment& Segment = Segments.AddDefaulted_GetRef();
+		Segment.Path = Directory / FileName;
+		if (!MapSegment(Segment))
+		{
+			continue;
+		}
+
+		const int32 SegmentIndex = Segments.Num() - 1;
+		const FFishingCatchRecord* Records = reinterpret_cast<const FFishingCatchRecord*>(Segment.MappedRegion->GetMappedPtr() + FishingJournal::HeaderSize);
+		for (int32 Index = 0; Index < Segment.NumRecords; ++Index)
+		{
+			IndexRecord(Records[Index], FishingJournal::MakeRecordId(SegmentIndex, Index));
+		}
+		NumRecords += Segment.NumRecords;
+	}
+
+	FirstSessionSegment = Segments.Num();
+	int32 FirstFileNumber = 0;
+	if (Files.Num() > 0)
+	{
+		FirstFileNumber = FCString::Atoi(*FPaths::GetBaseFilename(Files.Last()).RightChop(8)) + 1;
+	}
+	FileNumberOffset = FirstFileNumber - FirstSessionSegment;
+
+	Writer = MakeUnique<FFishingCatchJournalWriter>(Directory, FirstFileNumber, SegmentCapacity);
+
+	UE_LOG(LogFishingGame, Log, TEXT("Catch journal: %lld catches in %d segments under %s"), NumRecords, Segments.Num(), *Directory);
+}
+
+FFishingCatchJournal::~FFishingCatchJournal()
+{
+	Close();
+
+	for (const FSegment& Segment : Segments)
+	{
+		DEC_MEMORY_STAT_BY(STAT_FishingJournalMemory, Segment.Pending.GetAllocatedSize());
+	}
+}
+
+void FFishingCatchJournal::Close()
+{
+	// Destroying the writer drains its queue and closes the open segment
+	Writer.Reset();
+}
+
+void FFishingCatchJournal::Append(const FFishingCatchRecord& Record)
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	FSegment* Segment = Segments.Num() > FirstSessionSegment ? &Segments.Last() : nullptr;
+	if (!Segment || Segment->Pending.Num() + Segment->NumRecords == SegmentCapacity)
+	{
+		Segment = &Segments.AddDefaulted_GetRef();
+		Segment->Path = FishingJournal::GetSegmentPath(Directory, Segments.Num() - 1 + FileNumberOffset);
+		Segment->Pending.Reserve(SegmentCapacity);
+		INC_MEMORY_STAT_BY(STAT_FishingJournalMemory, Segment->Pending.GetAllocatedSize());
+	}
+
+	IndexRecord(Record, FishingJournal::MakeRecordId(Segments.Num() - 1, Segment->Pending.Num()));
+	Segment->Pending.Add(Record);
+	++NumRecords;
+
+	Writer->Enqueue(Record);
+	MapSealedSegments();
+}
+
+bool FFishingCatchJournal::FindBestCatch(int32 Species, int64 ZoneId, FFishingCatchRecord& OutRecord)
+{
+	MapSealedSegments();
+
+	const FBestCatch* Best = BestCatches.Find(FCatchKey(Species, ZoneId));
+	return Best && ReadRecord(Best->RecordId, OutRecord);
+}
+
+bool FFishingCatchJournal::MapSegment(FSegment& Segment)
+{
+	Segment.MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Segment.Path));
+	if (!Segment.MappedFile || Segment.MappedFile->GetFileSize() < FishingJournal::HeaderSize)
+	{
+		Segment.MappedFile.Reset();
+		return false;
+	}
+
+	Segment.MappedRegion.Reset(Segment.MappedFile->MapRegion(0, Segment.MappedFile->GetFileSize()));
+	if (!Segment.MappedRegion)
+	{
+		Segment.MappedFile.Reset();
+		return false;
+	}
+
+	const uint32* Header = reinterpret_cast<const uint32*>(Segment.MappedRegion->GetMappedPtr());
+	if (Header[0] != FishingJournal::Magic || Header[1] != FishingJournal::JournalVersion || Header[2] != sizeof(FFishingCatchRecord))
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Catch journal: skipping %s, not a version %u journal segment"), *Segment.Path, FishingJournal::JournalVersion);
+		Segment.MappedRegion.Reset();
+		Segment.MappedFile.Reset();
+		return false;
+	}
+
+	// A record cut short by a crash is ignored
+	Segment.NumRecords = (int32)((Segment.MappedRegion->GetMappedSize() - FishingJournal::HeaderSize) / sizeof(FFishingCatchRecord));
+	return true;
+}
+
+void FFishingCatchJournal::MapSealedSegments()
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	const int32 SealedSessionSegments = Writer->GetSealedSegment() - (FirstSessionSegment + FileNumberOffset);
+	while (NumMappedSessionSegments < SealedSessionSegments && Segments.IsValidIndex(FirstSessionSegment + NumMappedSessionSegments))
+	{
+		FSegment& Segment = Segments[FirstSessionSegment + NumMappedSessionSegments];
+		if (MapSegment(Segment))
+		{
+			DEC_MEMORY_STAT_BY(STAT_FishingJournalMemory, Segment.Pending.GetAllocatedSize());
+			Segment.Pending.Empty();
+		}
+		++NumMappedSessionSegments;
+	}
+}
+
+void FFishingCatchJournal::IndexRecord(const FFishingCatchRecord& Record, int64 RecordId)
+{
+	const FCatchKey Keys[] =
+	{
+		FCatchKey(Record.Species, Record.ZoneId),
+		FCatchKey(Record.Species, AnyZone),
+		FCatchKey(AnySpecies, Record.ZoneId),
+		FCatchKey(AnySpecies, AnyZone)
+	};
+
+	for (const FCatchKey& Key : Keys)
+	{
+		FBestCatch* Best = BestCatches.Find(Key);
+		if (!Best)
+		{
+			BestCatches.Add(Key, FBestCatch{ RecordId, Record.Size });
+		}
+		else if (Record.Size > Best->Size)
+		{
+			Best->RecordId = RecordId;
+			Best->Size = Record.Size;
+		}
+	}
+}
+
+bool FFishingCatchJournal::ReadRecord(int64 RecordId, FFishingCatchRecord& OutRecord) const
+{
+	const int32 SegmentIndex = (int32)(RecordId >> 32);
+	const int32 Index = (int32)(RecordId & 0xFFFFFFFF);
+	if (!Segments.IsValidIndex(SegmentIndex))
+	{
+		return false;
+	}
+
+	const FSegment& Segment = Segments[SegmentIndex];
+	if (Segment.MappedRegion && Index < Segment.NumRecords)
+	{
+		FMemory::Memcpy(&OutRecord, Segment.MappedRegion->GetMappedPtr() + FishingJournal::HeaderSize + Index * sizeof(FFishingCatchRecord), sizeof(FFishingCatchRecord));
+		return true;
+	}
+	if (Segment.Pending.IsValidIndex(Index))
+	{
+		OutRecord = Segment.Pending[Index];
+		return true;
+	}
+	return false;
+}
+
+void UFishingCatchJournalSubsystem::Deinitialize()
+{
+	Journal.Reset();
+	Super::Deinitialize();
+}
+
+FFishingCatchJournal& UFishingCatchJournalSubsystem::GetJournal()
+{
+	if (!Journal)
+	{
+		Journal = MakeUnique<FFishingCatchJournal>(FPaths::ProjectSavedDir() / TEXT("FishingJournal"));
+	}
+	return *Journal;
+}
+
+uint32 UFishingCatchJournalSubsystem::GetZoneId(const AFishingZone* Zone)
+{
+	return Zone ? FCrc::StrCrc32(*Zone->GetName()) : 0;
+}
+
+namespace FishingJournal
+{
+	static FAutoConsoleCommand BenchCommand(
+		TEXT("Fishing.JournalBench"),
+		TEXT("Appends synthetic catches to a scratch catch journal and reports write throughput and per-append game thread cost. Usage: Fishing.JournalBench [Catches]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumCatches = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 50000;
+			const FString BenchDirectory = FPaths::ProjectSavedDir() / TEXT("FishingJournalBench");
+			IFileManager::Get().DeleteDirectory(*BenchDirectory, false, true);
+			ON_SCOPE_EXIT
+			{
+				IFileManager::Get().DeleteDirectory(*BenchDirectory, false, true);
+			};
+
+			TArray<double> AppendMicroseconds;
+			AppendMicroseconds.Reserve(NumCatches);
+
+			FRandomStream Random(NumCatches);
+			const double Start = FPlatformTime::Seconds();
+			{
+				FFishingCatchJournal Journal(BenchDirectory);
+				for (int32 Index = 0; Index < NumCatches; ++Index)
+				{
+					FFishingCatchRecord Record;
+					Record.Timestamp = FDateTime::UtcNow().GetTicks();
+					Record.ZoneId = Random.RandRange(1, 8);
+					Record.Species = (uint16)Random.RandRange(0, 31);
+					Record.Size = Random.FRandRange(10.f, 120.f);
+					Record.CastPower = Random.FRand();
+
+					const uint64 AppendStart = FPlatformTime::Cycles64();
+					Journal.Append(Record);
+					AppendMicroseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - AppendStart) * 1000.0);
+				}
+			}
+			const double Seconds = FPlatformTime::Seconds() - Start;
+
+			AppendMicroseconds.Sort();
+			UE_LOG(LogFishingGame, Display, TEXT("Catch journal bench: %d catches written in %.3f s (%.0f catches/s), append p50 %.2f us, p99 %.2f us, max %.2f us"),
+				NumCatches, Seconds, NumCatches / Seconds,
+				AppendMicroseconds[NumCatches / 2], AppendMicroseconds[FMath::Min(NumCatches - 1, (int32)(NumCatches * 0.99))], AppendMicroseconds.Last());
+		}));
+}
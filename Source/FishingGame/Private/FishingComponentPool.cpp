@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingComponentPool.h"
+#include "FishingGame.h"
+#include "FishingGameCharacter.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+namespace FishingComponentPool
+{
+	static FAutoConsoleCommandWithWorldAndArgs ReportCommand(
+		TEXT("Fishing.PoolReport"),
+		TEXT("Logs the components the fishing component pool created, how many are in use and their memory."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (const UFishingComponentPool* Pool = World ? World->GetSubsystem<UFishingComponentPool>() : nullptr)
+			{
+				Pool->LogReport();
+			}
+		}));
+}
+
+USceneComponent* UFishingComponentPool::Acquire(TSubclassOf<USceneComponent> ComponentClass, USceneComponent* Parent, FName Socket)
+{
+	USceneComponent* Component = nullptr;
+
+	TArray<USceneComponent*>& Free = FreeComponents.FindOrAdd(ComponentClass);
+	while (Free.Num() > 0 && !Component)
+	{
+		Component = Free.Pop(false);
+		if (!IsValid(Component))
+		{
+			Component = nullptr;
+		}
+	}
+
+	if (!Component)
+	{
+		AActor* Owner = GetPoolOwner();
+		if (!Owner)
+		{
+			return nullptr;
+		}
+
+		Component = NewObject<USceneComponent>(Owner, ComponentClass);
+		++NumCreated.FindOrAdd(ComponentClass);
+		Component->SetupAttachment(Parent, Socket);
+		Component->RegisterComponent();
+		Owner->AddInstanceComponent(Component);
+	}
+	else
+	{
+		Component->AttachToComponent(Parent, FAttachmentTransformRules::SnapToTargetNotIncludingScale, Socket);
+	}
+
+	Component->SetVisibility(true);
+	return Component;
+}
+
+void UFishingComponentPool::ReleaseComponent(USceneComponent* Component)
+{
+	if (!IsValid(Component))
+	{
+		return;
+	}
+
+	Component->Deactivate();
+	Component->SetVisibility(false);
+	Component->DetachFromComponent(FDetachmentTransformRules::KeepRelativeTransform);
+	FreeComponents.FindOrAdd(Component->GetClass()).Add(Component);
+}
+
+void UFishingComponentPool::LogReport() const
+{
+	int32 NumAnglers = 0;
+	for (TActorIterator<AFishingGameCharacter> It(GetWorld()); It; ++It)
+	{
+		++NumAnglers;
+	}
+
+	// Every angler used to own one of each, registered or not
+	int32 TotalCreated = 0;
+	int64 TotalBytes = 0;
+	int64 UnpooledBytes = 0;
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing pool report: %d anglers in the world"), NumAnglers);
+	for (const TPair<UClass*, int32>& Created : NumCreated)
+	{
+		const TArray<USceneComponent*>* Free = FreeComponents.Find(Created.Key);
+		const int32 NumFree = Free ? Free->Num() : 0;
+
+		// The component objects themselves, plus what they own, e.g. render data
+		int64 Bytes = 0;
+		if (PoolOwner)
+		{
+			for (const UActorComponent* Component : PoolOwner->GetComponents())
+			{
+				if (Component && Component->GetClass() == Created.Key)
+				{
+					Bytes += Created.Key->GetStructureSize() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+				}
+			}
+		}
+		const int64 BytesPerComponent = Created.Value > 0 ? Bytes / Created.Value : Created.Key->GetStructureSize();
+
+		UE_LOG(LogFishingGame, Display, TEXT("  %-28s %4d created (%d in use, %d free), %.1f KB, vs %d and %.1f KB unpooled"),
+			*Created.Key->GetName(), Created.Value, Created.Value - NumFree, NumFree, Bytes / 1024.0, NumAnglers, NumAnglers * BytesPerComponent / 1024.0);
+
+		TotalCreated += Created.Value;
+		TotalBytes += Bytes;
+		UnpooledBytes += NumAnglers * BytesPerComponent;
+	}
+	UE_LOG(LogFishingGame, Display, TEXT("  %d components in %.1f KB, vs %d in %.1f KB unpooled"), TotalCreated, TotalBytes / 1024.0, NumAnglers * NumCreated.Num(), UnpooledBytes / 1024.0);
+}
+
+void UFishingComponentPool::Deinitialize()
+{
+	FreeComponents.Empty();
+	NumCreated.Empty();
+	PoolOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+AActor* UFishingComponentPool::GetPoolOwner()
+{
+	if (!PoolOwner && GetWorld()->IsGameWorld())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Name = TEXT("FishingComponentPool");
+		SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		PoolOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+		if (PoolOwner)
+		{
+			PoolOwner->SetRootComponent(NewObject<USceneComponent>(PoolOwner, TEXT("Root")));
+			PoolOwner->GetRootComponent()->RegisterComponent();
+		}
+	}
+	return PoolOwner;
+}
@@ -0,0 +1,7 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingEquipmentData.h"
+
+const FName UFishingEquipmentData::CursorBundle(TEXT("Cursor"));
+const FName UFishingEquipmentData::FishingBundle(TEXT("Fishing"));
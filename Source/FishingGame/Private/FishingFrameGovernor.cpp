@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingFrameGovernor.h"
+
+void FFishingFrameGovernor::Reset(const FSettings& InSettings, int32 InNumTiers, int32 InTier)
+{
+	Settings = InSettings;
+	Settings.WindowFrames = FMath::Max(Settings.WindowFrames, 1);
+	NumTiers = FMath::Max(InNumTiers, 1);
+	UpgradeBackoff = 0;
+	ProbationTime = 0.f;
+	PercentileMs = 0.f;
+
+	ChangeTier(FMath::Clamp(InTier, 0, NumTiers - 1));
+	CooldownTime = 0.f;
+}
+
+bool FFishingFrameGovernor::AddFrame(float FrameMs, float DeltaTime)
+{
+	CooldownTime = FMath::Max(CooldownTime - DeltaTime, 0.f);
+
+	// An upgrade that held through probation clears the backoff
+	if (ProbationTime > 0.f)
+	{
+		ProbationTime -= DeltaTime;
+		if (ProbationTime <= 0.f)
+		{
+			UpgradeBackoff = 0;
+		}
+	}
+
+	if (Window.Num() < Settings.WindowFrames)
+	{
+		Window.Add(FrameMs);
+	}
+	else
+	{
+		Window[WindowNext] = FrameMs;
+	}
+	WindowNext = (WindowNext + 1) % Settings.WindowFrames;
+
+	// Only judge a tier by a full window of its own frames
+	if (Window.Num() < Settings.WindowFrames)
+	{
+		return false;
+	}
+
+	PercentileMs = ComputePercentile();
+	if (PercentileMs > Settings.TargetFrameMs * Settings.DowngradeThreshold)
+	{
+		OverBudgetTime += DeltaTime;
+		UnderBudgetTime = 0.f;
+	}
+	else if (PercentileMs < Settings.TargetFrameMs * Settings.UpgradeThreshold)
+	{
+		UnderBudgetTime += DeltaTime;
+		OverBudgetTime = 0.f;
+	}
+	else
+	{
+		OverBudgetTime = 0.f;
+		UnderBudgetTime = 0.f;
+	}
+
+	if (CooldownTime > 0.f)
+	{
+		return false;
+	}
+
+	if (OverBudgetTime >= Settings.DowngradeDelay && Tier > 0)
+	{
+		if (ProbationTime > 0.f)
+		{
+			UpgradeBackoff = FMath::Min(UpgradeBackoff + 1, Settings.MaxUpgradeBackoff);
+			ProbationTime = 0.f;
+		}
+		ChangeTier(Tier - 1);
+		return true;
+	}
+
+	if (UnderBudgetTime >= Settings.UpgradeDelay * (1 << UpgradeBackoff) && Tier < NumTiers - 1)
+	{
+		ChangeTier(Tier + 1);
+		ProbationTime = Settings.UpgradeProbation;
+		return true;
+	}
+
+	return false;
+}
+
+void FFishingFrameGovernor::ChangeTier(int32 NewTier)
+{
+	Tier = NewTier;
+	Window.Reset();
+	WindowNext = 0;
+	OverBudgetTime = 0.f;
+	UnderBudgetTime = 0.f;
+	CooldownTime = Settings.ChangeCooldown;
+}
+
+float FFishingFrameGovernor::ComputePercentile()
+{
+	Sorted = Window;
+	Sorted.Sort();
+
+	// Nearest rank
+	const int32 Rank = FMath::CeilToInt(Settings.Percentile * Sorted.Num()) - 1;
+	return Sorted[FMath::Clamp(Rank, 0, Sorted.Num() - 1)];
+}
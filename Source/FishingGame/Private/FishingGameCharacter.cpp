@@ -1,18 +1,38 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FishingGameCharacter.h"
-#include "UObject/ConstructorHelpers.h"
 #include "Camera/CameraComponent.h"
 #include "Components/DecalComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/SpringArmComponent.h"
-#include "CableComponent.h"
-#include "Materials/Material.h"
+#include "FishingLineComponent.h"
 #include "Engine/World.h"
-#include "FishingGamePlayerController.h"
-#include "TimerManager.h"
+#include "FishingGame.h"
+#include "FishingAnglerController.h"
+#include "FishingAIController.h"
+#include "FishingAnglerUpdateSubsystem.h"
+#include "FishingBiteSubsystem.h"
+#include "FishingZone.h"
+#include "FishingZoneSubsystem.h"
+#include "FishSchoolSubsystem.h"
+#include "FishSchoolRenderer.h"
+#include "FishingComponentPool.h"
+#include "FishingCatchJournal.h"
+#include "FishingEquipmentData.h"
+#include "FishingLootTable.h"
+#include "FishingWaveSubsystem.h"
+#include "FishingStreamingSubsystem.h"
+#include "FishingScalabilitySubsystem.h"
+#include "FishingSignificanceSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/SkeletalMesh.h"
+#include "Materials/MaterialInterface.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "Particles/ParticleSystem.h"
 #include "Particles/ParticleSystemComponent.h"
 
 AFishingGameCharacter::AFishingGameCharacter()
@@ -45,7 +65,7 @@ AFishingGameCharacter::AFishingGameCharacter()
 	FishingRod->SetRelativeLocation(FVector(5.235499, -2.556474, 1.357719));
 	FishingRod->SetRelativeRotation(FRotator(76.808014, 89.998528, -34.547497));
 
-	RodLine = CreateDefaultSubobject<UCableComponent>(TEXT("Rod Line"));
+	RodLine = CreateDefaultSubobject<UFishingLineComponent>(TEXT("Rod Line"));
 	RodLine->SetupAttachment(FishingRod, "TipSocket");
 	RodLine->CableLength = 30.f;
 	RodLine->CableWidth = 2.f;
@@ -59,130 +79,871 @@ AFishingGameCharacter::AFishingGameCharacter()
 	Hook->SetCollisionResponseToAllChannels(ECR_Block);
 	Hook->SetCollisionObjectType(ECC_GameTraceChannel1); // Set Hook object type to "Hook"
 
-	FishBiteFXComp = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("Bite VFX"));
-	FishBiteFXComp->SetupAttachment(Hook);
-	FishBiteFXComp->SetAutoActivate(false);
-	FishBiteFXComp->SetRelativeScale3D(FVector(5.f, 5.f, 6.f));
-	FishBiteFXComp->SetUsingAbsoluteRotation(true); // Make sure it always face up
+	// Bite VFX, caught fish and cursor decal come from UFishingComponentPool when they are actually needed, their assets from Equipment
+	EquipmentId = FPrimaryAssetId(FPrimaryAssetType(TEXT("FishingEquipmentData")), TEXT("DA_FishingEquipment"));
+	DefaultCursorDecalMaterial = TSoftObjectPtr<UMaterialInterface>(FSoftObjectPath(TEXT("/Game/FishingGame/Assets/Materials/M_Cursor_Decal.M_Cursor_Decal")));
+	DefaultFishSkeletalMesh = TSoftObjectPtr<USkeletalMesh>(FSoftObjectPath(TEXT("/Game/FishingGame/Assets/Fish/SKM_Fish.SKM_Fish")));
+	DefaultFishBiteFX = TSoftObjectPtr<UParticleSystem>(FSoftObjectPath(TEXT("/Game/CartoonWaterShader/Particles/PS_Waterfall_BottomFoam.PS_Waterfall_BottomFoam")));
 
-	FishMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Fish Mesh"));
-	FishMesh->SetupAttachment(Hook, "FishSocket");
-	FishMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	FishMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
-	FishMesh->SetVisibility(false);
-	FishMesh->SetCastShadow(false);
-	FishMesh->SetUsingAbsoluteScale(true);
-	FishMesh->SetRelativeRotation(FRotator(0.f, 90.f, 0.f));
+	// Lets crowds of anglers skip animation frames by screen size, the player's own angler is always close enough to update every frame
+	GetMesh()->bEnableUpdateRateOptimizations = true;
 
-	CursorToWorld = CreateDefaultSubobject<UDecalComponent>("CursorToWorld");
-	CursorToWorld->SetupAttachment(RootComponent);
-	static ConstructorHelpers::FObjectFinder<UMaterial> DecalMaterialAsset(TEXT("Material'/Game/FishingGame/Assets/Materials/M_Cursor_Decal.M_Cursor_Decal'"));
-	if (DecalMaterialAsset.Succeeded())
+	// Anglers placed in the level fish on their own
+	AIControllerClass = AFishingAIController::StaticClass();
+
+	// The hook is moved by UFishingAnglerUpdateSubsystem, nothing is left to tick
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+void AFishingGameCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UFishingBiteSubsystem* BiteSubsystem = GetBiteSubsystem())
+	{
+		BiteIndex = BiteSubsystem->RegisterAngler(this);
+	}
+	BiteSim.Reset(FFishingCastSim::FSettings(), GetWorld()->GetTimeSeconds());
+
+	if (UFishingAnglerUpdateSubsystem* AnglerUpdate = GetWorld()->GetSubsystem<UFishingAnglerUpdateSubsystem>())
+	{
+		HookUpdateIndex = AnglerUpdate->RegisterAngler(this);
+	}
+
+	// On every machine: clients and listen servers throttle what they render, servers what they simulate
+	if (UFishingSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UFishingSignificanceSubsystem>())
 	{
-		CursorToWorld->SetDecalMaterial(DecalMaterialAsset.Object);
+		Significance->RegisterAngler(this);
 	}
-	CursorToWorld->DecalSize = FVector(16.0f, 32.0f, 32.0f);
-	CursorToWorld->SetRelativeRotation(FRotator(90.0f, 0.0f, 0.0f).Quaternion());
 
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;
+	// Everything the hard references used to pull in with the map, see Fishing.MapLoadBench
+	if (GFishingSyncAssetLoads)
+	{
+		LoadEquipmentBundle(UFishingEquipmentData::CursorBundle);
+		LoadEquipmentBundle(UFishingEquipmentData::FishingBundle);
+	}
+
+	OnFishingPhaseChanged(FishingState.Phase);
 }
 
-void AFishingGameCharacter::Tick(float DeltaSeconds)
+void AFishingGameCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    Super::Tick(DeltaSeconds);
+	if (UFishingBiteSubsystem* BiteSubsystem = GetBiteSubsystem())
+	{
+		BiteSubsystem->UnregisterAngler(BiteIndex);
+	}
+	BiteIndex = INDEX_NONE;
 
-	if (CursorToWorld != nullptr)
+	if (UFishingAnglerUpdateSubsystem* AnglerUpdate = GetWorld()->GetSubsystem<UFishingAnglerUpdateSubsystem>())
+	{
+		AnglerUpdate->UnregisterAngler(HookUpdateIndex);
+	}
+	HookUpdateIndex = INDEX_NONE;
+
+	if (UFishingSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UFishingSignificanceSubsystem>())
+	{
+		Significance->UnregisterAngler(this);
+	}
+
+	if (UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>())
+	{
+		FishSchools->RemoveHook(this);
+	}
+	if (UFishingWaveSubsystem* Water = GetWorld()->GetSubsystem<UFishingWaveSubsystem>())
+	{
+		Water->RemoveFloater(Hook);
+	}
+	HideCaughtFish();
+
+	if (UFishingComponentPool* Pool = GetComponentPool())
+	{
+		Pool->Release(FishBiteFXComp);
+		Pool->Release(CursorToWorld);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AFishingGameCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AFishingGameCharacter, FishingState);
+	DOREPLIFETIME(AFishingGameCharacter, HookLaunch);
+}
+
+float AFishingGameCharacter::GetServerWorldTime() const
+{
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+float AFishingGameCharacter::GetFishingPhaseTime() const
+{
+	return FMath::Max(0.f, GetServerWorldTime() - FishingState.PhaseStartTime);
+}
+
+void AFishingGameCharacter::SetFishingPhase(EFishingPhase Phase, float CastProgress)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// Changes made while dormant would never reach clients
+	if (NetDormancy > DORM_Awake)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	const EFishingPhase PreviousPhase = FishingState.Phase;
+	FishingState.Phase = Phase;
+	FishingState.bFishOnHook = bFishBiting;
+	FishingState.Species = bFishBiting ? (uint16)FMath::Max(PendingCatchSpecies, 0) : 0;
+	if (Phase == EFishingPhase::Casting || Phase == EFishingPhase::HookInFlight)
+	{
+		FishingState.CastPower = FishingNet::QuantizeProgress(CastProgress);
+	}
+	FishingState.PhaseStartTime = GetServerWorldTime();
+
+	OnFishingPhaseChanged(PreviousPhase);
+}
+
+void AFishingGameCharacter::OnFishingPhaseChanged(EFishingPhase PreviousPhase)
+{
+	FISHING_SCOPE(PhaseChange);
+	FISHING_EVENT(TEXT("%s: %s"), *GetName(), FishingNet::GetPhaseName(FishingState.Phase));
+
+	if (FishingState.Phase != EFishingPhase::Idle)
+	{
+		LoadEquipmentBundle(UFishingEquipmentData::FishingBundle);
+	}
+
+	// Bobbing is cosmetic
+	if (FishingState.Phase == EFishingPhase::Fishing && PreviousPhase != EFishingPhase::Fishing)
+	{
+		BobHook();
+	}
+
+	if (!HasAuthority() || GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if (FishingState.Phase == EFishingPhase::Idle)
+	{
+		TimerManager.SetTimer(DormancyTimer, this, &AFishingGameCharacter::CheckNetDormancy, IdleDormancyDelay, false);
+	}
+	else
+	{
+		TimerManager.ClearTimer(DormancyTimer);
+		OnCharacterMovementUpdated.RemoveDynamic(this, &AFishingGameCharacter::OnDormantMovementUpdated);
+	}
+}
+
+void AFishingGameCharacter::CheckNetDormancy()
+{
+	// Pawns of remote players stay awake: their movement RPCs need an open actor channel
+	const APlayerController* PC = Cast<APlayerController>(GetController());
+	const bool bRemotelyControlled = PC && !PC->IsLocalController();
+	if (bRemotelyControlled || FishingState.Phase != EFishingPhase::Idle || NetDormancy > DORM_Awake)
+	{
+		return;
+	}
+
+	// Still walking, it can't have stood idle long enough before another full delay
+	if (!GetVelocity().IsNearlyZero())
+	{
+		GetWorldTimerManager().SetTimer(DormancyTimer, this, &AFishingGameCharacter::CheckNetDormancy, IdleDormancyDelay, false);
+		return;
+	}
+
+	SetNetDormancy(DORM_DormantAll);
+	OnCharacterMovementUpdated.AddUniqueDynamic(this, &AFishingGameCharacter::OnDormantMovementUpdated);
+}
+
+void AFishingGameCharacter::OnDormantMovementUpdated(float DeltaSeconds, FVector OldLocation, FVector OldVelocity)
+{
+	if (GetVelocity().IsNearlyZero() && OldLocation.Equals(GetActorLocation()))
+	{
+		return;
+	}
+
+	// Moving again: wake up now, and only consider going back to sleep once it stood still for the whole delay
+	OnCharacterMovementUpdated.RemoveDynamic(this, &AFishingGameCharacter::OnDormantMovementUpdated);
+	SetNetDormancy(DORM_Awake);
+	GetWorldTimerManager().SetTimer(DormancyTimer, this, &AFishingGameCharacter::CheckNetDormancy, IdleDormancyDelay, false);
+}
+
+void AFishingGameCharacter::OnRep_FishingState(const FFishingNetState& PreviousState)
+{
+	bFishBiting = FishingState.bFishOnHook;
+
+	const bool bWantsBiteFX = bFishBiting && (FishingState.Phase == EFishingPhase::Biting || FishingState.Phase == EFishingPhase::Reeling);
+	if (bWantsBiteFX != (FishBiteFXComp != nullptr))
+	{
+		SetBiteFXActive(bWantsBiteFX);
+	}
+
+	// The reel can arrive before, or without, the animation notify on this machine
+	if (FishingNet::IsHookOut(PreviousState.Phase) && !FishingNet::IsHookOut(FishingState.Phase))
+	{
+		ReelHook();
+	}
+
+	if (FishingState.Phase == EFishingPhase::Charging)
+	{
+		HideCaughtFish();
+	}
+
+	OnFishingPhaseChanged(PreviousState.Phase);
+}
+
+void AFishingGameCharacter::OnRep_HookLaunch()
+{
+	if (!FishingNet::IsHookOut(FishingState.Phase))
+	{
+		return;
+	}
+
+	HookTrajectory = FFishingCastTrajectory(HookLaunch.Origin, HookLaunch.Velocity, GetWorld()->GetGravityZ());
+	HookTrajectory.LandingLocation = HookLaunch.LandingLocation;
+	HookTrajectory.LandingTime = HookLaunch.LandingTime;
+	HookTrajectory.bHasLanding = HookLaunch.bHasLanding;
+
+	// Start as far along the path as the server already is
+	BeginHookFlight(FMath::Max(0.f, GetServerWorldTime() - HookLaunch.LaunchTime));
+}
+
+void AFishingGameCharacter::BeginHookFlight(float ElapsedTime)
+{
+	Hook->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	RodLine->bAttachEnd = true;
+	RodLine->SetAttachEndToComponent(Hook, "HookSocket");
+	HookZone = nullptr;
+	bHookInFlight = true;
+	if (UFishingAnglerUpdateSubsystem* AnglerUpdate = GetWorld()->GetSubsystem<UFishingAnglerUpdateSubsystem>())
+	{
+		AnglerUpdate->BeginFlight(HookUpdateIndex, HookTrajectory, ElapsedTime);
+	}
+}
+
+void AFishingGameCharacter::SetBiteFXActive(bool bActive)
+{
+	if (!bActive)
+	{
+		if (UFishingComponentPool* Pool = GetComponentPool())
+		{
+			Pool->Release(FishBiteFXComp);
+		}
+		RodLine->SetLineTension(FVector::ZeroVector);
+		return;
+	}
+
+	const UFishingScalabilitySubsystem* Scalability = GetWorld()->GetSubsystem<UFishingScalabilitySubsystem>();
+	if (GetNetMode() == NM_DedicatedServer || !bCosmeticsEnabled || (Scalability && !Scalability->AllowsBiteFX()))
+	{
+		return;
+	}
+
+	if (!FishBiteFXComp)
+	{
+		UFishingComponentPool* Pool = GetComponentPool();
+		FishBiteFXComp = Pool ? Pool->Acquire<UParticleSystemComponent>(Hook) : nullptr;
+		if (!FishBiteFXComp)
+		{
+			return;
+		}
+		FishBiteFXComp->SetAutoActivate(false);
+		FishBiteFXComp->SetTemplate(GetFishBiteFX());
+		FishBiteFXComp->SetRelativeScale3D(FVector(5.f, 5.f, 6.f));
+		FishBiteFXComp->SetUsingAbsoluteRotation(true); // Make sure it always face up
+	}
+	FishBiteFXComp->Activate(true);
+	RodLine->SetLineTension(FishLineTension);
+}
+
+void AFishingGameCharacter::SetCosmeticsEnabled(bool bEnabled)
+{
+	if (bEnabled == bCosmeticsEnabled)
+	{
+		return;
+	}
+	bCosmeticsEnabled = bEnabled;
+
+	RodLine->SetVisibility(bEnabled);
+	RodLine->SetComponentTickEnabled(bEnabled);
+	if (bEnabled)
 	{
-		APlayerController* const PC = Cast<APlayerController>(GetController());
-		if (PC)
+		RodLine->WakeLine();
+	}
+
+	const bool bWantsBiteFX = bFishBiting && (FishingState.Phase == EFishingPhase::Biting || FishingState.Phase == EFishingPhase::Reeling);
+	SetBiteFXActive(bEnabled && bWantsBiteFX);
+}
+
+UFishingBiteSubsystem* AFishingGameCharacter::GetBiteSubsystem() const
+{
+	return GetWorld() ? GetWorld()->GetSubsystem<UFishingBiteSubsystem>() : nullptr;
+}
+
+UFishingComponentPool* AFishingGameCharacter::GetComponentPool() const
+{
+	return GetWorld() ? GetWorld()->GetSubsystem<UFishingComponentPool>() : nullptr;
+}
+
+void AFishingGameCharacter::LoadEquipmentBundle(FName Bundle)
+{
+	if (GetNetMode() == NM_DedicatedServer || !UAssetManager::IsValid() || RequestedBundles.Contains(Bundle))
+	{
+		return;
+	}
+	RequestedBundles.Add(Bundle);
+
+	const FStreamableDelegate OnLoaded = FStreamableDelegate::CreateUObject(this, &AFishingGameCharacter::OnEquipmentLoaded);
+	TSharedPtr<FStreamableHandle> Handle;
+	if (HasEquipmentAsset())
+	{
+		// Adds to the bundles already loaded, other anglers share the same requests
+		Handle = UAssetManager::Get().ChangeBundleStateForPrimaryAssets({ EquipmentId }, { Bundle }, {}, false, OnLoaded);
+	}
+	else
+	{
+		TArray<FSoftObjectPath> Paths;
+		GetDefaultBundleAssets(Bundle, Paths);
+		if (Paths.Num() > 0)
+		{
+			Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths, OnLoaded);
+			DefaultAssetHandles.Add(Handle);
+		}
+	}
+
+	if (GFishingSyncAssetLoads && Handle.IsValid())
+	{
+		Handle->WaitUntilComplete();
+	}
+}
+
+bool AFishingGameCharacter::HasEquipmentAsset() const
+{
+	return EquipmentId.IsValid() && UAssetManager::IsValid() && !UAssetManager::Get().GetPrimaryAssetPath(EquipmentId).IsNull();
+}
+
+void AFishingGameCharacter::GetDefaultBundleAssets(FName Bundle, TArray<FSoftObjectPath>& OutPaths) const
+{
+	if (Bundle == UFishingEquipmentData::CursorBundle && !DefaultCursorDecalMaterial.IsNull())
+	{
+		OutPaths.Add(DefaultCursorDecalMaterial.ToSoftObjectPath());
+	}
+	if (Bundle == UFishingEquipmentData::FishingBundle)
+	{
+		if (!DefaultFishSkeletalMesh.IsNull())
 		{
-			FHitResult TraceHitResult;
-			PC->GetHitResultUnderCursor(ECC_Visibility, true, TraceHitResult);
-			FVector CursorFV = TraceHitResult.ImpactNormal;
-			FRotator CursorR = CursorFV.Rotation();
-			CursorToWorld->SetWorldLocation(TraceHitResult.Location);
-			CursorToWorld->SetWorldRotation(CursorR);
+			OutPaths.Add(DefaultFishSkeletalMesh.ToSoftObjectPath());
+		}
+		if (!DefaultFishBiteFX.IsNull())
+		{
+			OutPaths.Add(DefaultFishBiteFX.ToSoftObjectPath());
 		}
 	}
 }
 
+void AFishingGameCharacter::OnEquipmentLoaded()
+{
+	if (HasEquipmentAsset())
+	{
+		Equipment = UAssetManager::Get().GetPrimaryAssetObject<UFishingEquipmentData>(EquipmentId);
+		if (!Equipment)
+		{
+			UE_LOG(LogFishingGame, Warning, TEXT("%s: equipment %s could not be loaded"), *GetName(), *EquipmentId.ToString());
+			return;
+		}
+	}
+
+	if (CursorToWorld && !CursorToWorld->GetDecalMaterial())
+	{
+		CursorToWorld->SetDecalMaterial(GetCursorDecalMaterial());
+	}
+	if (FishBiteFXComp && !FishBiteFXComp->Template)
+	{
+		FishBiteFXComp->SetTemplate(GetFishBiteFX());
+		FishBiteFXComp->Activate(true);
+	}
+	if (FishMesh && !FishMesh->SkeletalMesh)
+	{
+		FishMesh->SetSkeletalMesh(GetFishSkeletalMesh());
+	}
+}
+
+UMaterialInterface* AFishingGameCharacter::GetCursorDecalMaterial() const
+{
+	return Equipment ? Equipment->CursorDecalMaterial.Get() : DefaultCursorDecalMaterial.Get();
+}
+
+USkeletalMesh* AFishingGameCharacter::GetFishSkeletalMesh() const
+{
+	return Equipment ? Equipment->FishSkeletalMesh.Get() : DefaultFishSkeletalMesh.Get();
+}
+
+UParticleSystem* AFishingGameCharacter::GetFishBiteFX() const
+{
+	return Equipment ? Equipment->FishBiteFX.Get() : DefaultFishBiteFX.Get();
+}
+
+void AFishingGameCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// Only the local player's own angler ever shows a cursor decal
+	APlayerController* PC = Cast<APlayerController>(GetController());
+	const bool bWantsCursorDecal = PC && PC->IsLocalController() && PC->GetLocalPlayer();
+
+	UFishingComponentPool* Pool = GetComponentPool();
+	if (bWantsCursorDecal && !CursorToWorld && Pool)
+	{
+		CursorToWorld = Pool->Acquire<UDecalComponent>(RootComponent);
+		if (CursorToWorld)
+		{
+			CursorToWorld->SetDecalMaterial(GetCursorDecalMaterial());
+			CursorToWorld->DecalSize = FVector(16.0f, 32.0f, 32.0f);
+			CursorToWorld->SetRelativeRotation(FRotator(90.0f, 0.0f, 0.0f).Quaternion());
+		}
+	}
+	else if (!bWantsCursorDecal && Pool)
+	{
+		Pool->Release(CursorToWorld);
+	}
+
+	if (bWantsCursorDecal)
+	{
+		LoadEquipmentBundle(UFishingEquipmentData::CursorBundle);
+	}
+}
+
+UFishingZoneSubsystem* AFishingGameCharacter::GetZoneSubsystem() const
+{
+	return GetWorld() ? GetWorld()->GetSubsystem<UFishingZoneSubsystem>() : nullptr;
+}
+
+float AFishingGameCharacter::GetFishingWaitTime() const
+{
+	return HookZone.IsValid() ? HookZone->GetFishingWaitTime(FishingWaitTime) : FishingWaitTime;
+}
+
+void AFishingGameCharacter::WaitForBite()
+{
+	PendingCatchSpecies = INDEX_NONE;
+	PendingCatchSize = FMath::FRandRange(CatchSizeRange.X, CatchSizeRange.Y);
+
+	UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>();
+	if (FishSchools && FishSchools->HasFish(HookZone.Get()))
+	{
+		FishSchools->AddHook(this, Hook->GetComponentLocation(), HookZone.Get());
+		return;
+	}
+
+	// Timed bites pick their fish up front so the species can stretch or shorten the wait
+	float WaitScale = 1.f;
+	FFishingLootRoll Roll;
+	UFishingLootSubsystem* Loot = GetWorld()->GetSubsystem<UFishingLootSubsystem>();
+	if (Loot && Loot->Roll(HookZone.Get(), Roll))
+	{
+		PendingCatchSpecies = Roll.SpeciesId;
+		PendingCatchSize = Roll.Size;
+		WaitScale = Roll.BiteWaitScale;
+	}
+	GetBiteSubsystem()->ArmBite(BiteIndex, GetFishingWaitTime() * WaitScale);
+}
+
+void AFishingGameCharacter::LandHook(const FVector& Location, AFishingZone* Zone)
+{
+	Hook->SetWorldLocation(Location);
+	HookZone = Zone;
+	bHookInFlight = false;
+	FloatHook();
+	FISHING_EVENT(TEXT("%s: Landed"), *GetName());
+
+	// The hook stays Movable throughout, the anim blueprint starts fishing off IsHookLanded
+	if (Zone)
+	{
+		StartFishingOnServer();
+	}
+}
+
+void AFishingGameCharacter::PinHook(AFishingZone* Zone)
+{
+	FISHING_SCOPE(HookLanding);
+	FISHING_EVENT(TEXT("%s: Landed"), *GetName());
+	HookZone = Zone;
+	Hook->SetSimulatePhysics(false);
+	FloatHook();
+	StartFishingOnServer();
+}
+
+void AFishingGameCharacter::StartFishingOnServer()
+{
+	AController* AnglerController = GetController();
+	IFishingAnglerController* Angler = Cast<IFishingAnglerController>(AnglerController);
+	if (!HasAuthority() || !Angler || AnglerController->IsLocalController() || FishingState.Phase != EFishingPhase::HookInFlight)
+	{
+		return;
+	}
+
+	// The replicated phase is what the server goes by, the controller's flags just follow it here
+	Angler->SetInTransition(false);
+	Angler->SetIsFishing(true);
+	StartFishing();
+}
+
+void AFishingGameCharacter::FloatHook()
+{
+	UFishingWaveSubsystem* Water = GetWorld()->GetSubsystem<UFishingWaveSubsystem>();
+	if (!Water || !HookZone.IsValid())
+	{
+		return;
+	}
+
+	const FVector Location = Hook->GetComponentLocation();
+	Hook->SetWorldLocation(FVector(Location.X, Location.Y, Water->GetWaterSurfaceHeight(Location, HookZone->GetWaterLevel())));
+}
+
+void AFishingGameCharacter::BobHook()
+{
+	UFishingWaveSubsystem* Water = GetWorld()->GetSubsystem<UFishingWaveSubsystem>();
+	if (!Water || !HookZone.IsValid() || bHookInFlight || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	Water->AddFloater(Hook, HookZone->GetWaterLevel());
+}
+
+void AFishingGameCharacter::UpdateCursorDecal(const FHitResult& Hit)
+{
+	if (CursorToWorld != nullptr)
+	{
+		FVector CursorFV = Hit.ImpactNormal;
+		FRotator CursorR = CursorFV.Rotation();
+		CursorToWorld->SetWorldLocation(Hit.Location);
+		CursorToWorld->SetWorldRotation(CursorR);
+	}
+}
+
+FFishingCastTrajectory AFishingGameCharacter::PredictCast(float CastingProgress) const
+{
+	FRotator LaunchDirection = GetActorRotation();
+	LaunchDirection.Pitch += PitchAngle;
+	// Set Launch Velocity with a minimum strength of 300.f
+	FVector LaunchVelocity = LaunchDirection.Vector() * FMath::Max(300.f, LaunchStrength * CastingProgress);
+
+	FFishingCastTrajectory Trajectory(Hook->GetComponentLocation(), LaunchVelocity, GetWorld()->GetGravityZ());
+	Trajectory.SolvePlaneLanding(GetActorLocation().Z - GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+	return Trajectory;
+}
+
+void AFishingGameCharacter::GetCastPreview(int32 NumPoints, TArray<FVector>& OutPoints, FVector& OutLanding) const
+{
+	IFishingAnglerController* AnglerController = Cast<IFishingAnglerController>(GetController());
+	const FFishingCastTrajectory Trajectory = PredictCast(AnglerController ? AnglerController->GetCastingProgress() : 0.f);
+	Trajectory.GetPreviewPoints(NumPoints, OutPoints);
+	OutLanding = Trajectory.LandingLocation;
+}
+
 void AFishingGameCharacter::LaunchHook()
 {
-	AFishingGamePlayerController* PController = Cast<AFishingGamePlayerController>(GetController());
-	if (PController)
+	FISHING_SCOPE(LaunchHook);
+
+	IFishingAnglerController* AnglerController = Cast<IFishingAnglerController>(GetController());
+	if (AnglerController)
 	{
-		PController->RemoveCastingWidget();
+		AnglerController->RemoveCastingWidget();
 
-		FRotator LaunchDirection = GetActorRotation();
-		LaunchDirection.Pitch += PitchAngle;
-		// Set Launch Velocity with a minimum strength of 300.f
-		FVector LaunchVelocity = LaunchDirection.Vector() * FMath::Max(300.f, LaunchStrength * PController->GetCastingProgress());
+		// The ground under where the hook comes down streams in ahead of anything else around the player
+		if (IsPlayerControlled() && IsLocallyControlled())
+		{
+			if (UFishingStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UFishingStreamingSubsystem>())
+			{
+				const FFishingCastTrajectory Predicted = PredictCast(AnglerController->GetCastingProgress());
+				if (Predicted.bHasLanding)
+				{
+					Streaming->PrioritizeLocation(Predicted.LandingLocation);
+				}
+			}
+		}
 
+		// Clients fly the hook from the launch parameters the server replicates
+		if (!HasAuthority())
+		{
+			return;
+		}
+
+		const float CastingProgress = AnglerController->GetCastingProgress();
+		HookTrajectory = PredictCast(CastingProgress);
+		HookZone = nullptr;
+
+		if (bKinematicCast)
+		{
+			FCollisionQueryParams Params(SCENE_QUERY_STAT(FishingCastLanding), false, this);
+			HookTrajectory.SolveLanding(GetWorld(), GetActorLocation().Z - GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), ECC_Visibility, Params, GetZoneSubsystem());
+
+			HookLaunch.Origin = HookTrajectory.Origin;
+			HookLaunch.Velocity = HookTrajectory.Velocity;
+			HookLaunch.LandingLocation = HookTrajectory.LandingLocation;
+			HookLaunch.LandingTime = HookTrajectory.LandingTime;
+			HookLaunch.bHasLanding = HookTrajectory.bHasLanding;
+			HookLaunch.LaunchTime = GetServerWorldTime();
+			++HookLaunch.LaunchCount;
+
+			BeginHookFlight(0.f);
+			SetFishingPhase(EFishingPhase::HookInFlight, CastingProgress);
+			return;
+		}
+
+		// The physics cast is simulated on the server only; clients see the hook once it is reeled back in
 		Hook->DetachFromComponent(FDetachmentTransformRules::KeepRelativeTransform);
 		Hook->SetSimulatePhysics(true);
 		RodLine->bAttachEnd = true;
 		RodLine->SetAttachEndToComponent(Hook, "HookSocket");
-		Hook->SetPhysicsLinearVelocity(LaunchVelocity, false);
+		Hook->SetPhysicsLinearVelocity(HookTrajectory.Velocity, false);
+		if (UFishingAnglerUpdateSubsystem* AnglerUpdate = GetWorld()->GetSubsystem<UFishingAnglerUpdateSubsystem>())
+		{
+			AnglerUpdate->BeginPhysicsCast(HookUpdateIndex);
+		}
+		SetFishingPhase(EFishingPhase::HookInFlight, CastingProgress);
 	}
 }
 
 void AFishingGameCharacter::ReelHook()
 {
+	FISHING_SCOPE(ReelHook);
+
+	if (UFishingWaveSubsystem* Water = GetWorld()->GetSubsystem<UFishingWaveSubsystem>())
+	{
+		Water->RemoveFloater(Hook);
+	}
 	RodLine->bAttachEnd = false;
+	bHookInFlight = false;
+	HookZone = nullptr;
+
+	Hook->SetSimulatePhysics(false);
+	Hook->AttachToComponent(RodLine, FAttachmentTransformRules::SnapToTargetNotIncludingScale, "CableEnd");;
+	Hook->SetRelativeLocation(FVector::ZeroVector);
+	Hook->SetRelativeRotation(FRotator::ZeroRotator);
+	if (UFishingAnglerUpdateSubsystem* AnglerUpdate = GetWorld()->GetSubsystem<UFishingAnglerUpdateSubsystem>())
+	{
+		AnglerUpdate->StopHook(HookUpdateIndex);
+	}
+
+	if (bCatchPending && bFishBiting)
+	{
+		RecordCatch();
+	}
+	bCatchPending = false;
+	SetFishingPhase(EFishingPhase::Idle);
 
 	if (bFishBiting)
 	{
-		FishMesh->SetVisibility(true);
+		ShowCaughtFish();
 	}
 	else
 	{
-		FishMesh->SetVisibility(false);
+		HideCaughtFish();
 	}
+}
 
-	Hook->SetSimulatePhysics(false);
-	Hook->AttachToComponent(RodLine, FAttachmentTransformRules::SnapToTargetNotIncludingScale, "CableEnd");;
-	Hook->SetRelativeLocation(FVector::ZeroVector);
-	Hook->SetRelativeRotation(FRotator::ZeroRotator);
+void AFishingGameCharacter::ShowCaughtFish()
+{
+	UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>();
+	AFishSchoolRenderer* Renderer = FishSchools ? FishSchools->GetRenderer() : nullptr;
+
+	if (Renderer && !IsNearLocalView(SkeletalFishDistance))
+	{
+		Renderer->ShowHeldFish(this, Hook, "FishSocket", FishMeshRotation.Quaternion(), FishingState.Species);
+		return;
+	}
+
+	if (!FishMesh)
+	{
+		UFishingComponentPool* Pool = GetComponentPool();
+		FishMesh = Pool ? Pool->Acquire<USkeletalMeshComponent>(Hook, "FishSocket") : nullptr;
+		if (!FishMesh)
+		{
+			return;
+		}
+		FishMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		FishMesh->SetCastShadow(false);
+		FishMesh->SetUsingAbsoluteScale(true);
+		FishMesh->SetRelativeRotation(FishMeshRotation);
+		FishMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		FishMesh->SetSkeletalMesh(GetFishSkeletalMesh());
+	}
+	FishMesh->SetVisibility(true);
+}
+
+void AFishingGameCharacter::HideCaughtFish()
+{
+	if (UFishingComponentPool* Pool = GetComponentPool())
+	{
+		Pool->Release(FishMesh);
+	}
+
+	UFishSchoolSubsystem* FishSchools = GetWorld() ? GetWorld()->GetSubsystem<UFishSchoolSubsystem>() : nullptr;
+	if (AFishSchoolRenderer* Renderer = FishSchools ? FishSchools->GetRenderer() : nullptr)
+	{
+		Renderer->HideHeldFish(this);
+	}
+}
+
+bool AFishingGameCharacter::IsNearLocalView(float Distance) const
+{
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		if (PC && PC->GetLocalPlayer() && PC->PlayerCameraManager && FVector::DistSquared(PC->PlayerCameraManager->GetCameraLocation(), GetActorLocation()) < FMath::Square(Distance))
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 void AFishingGameCharacter::ClearTimersAndVFX()
 {
-	Hook->SetMobility(EComponentMobility::Movable); //SetMobility here instead of ReelHook() to avoid racing condition
-	GetWorldTimerManager().ClearTimer(FishBiteTimerHandle);
-	GetWorldTimerManager().ClearTimer(FailTimerHandle);
-	FishBiteFXComp->Deactivate();
+	if (UFishingBiteSubsystem* BiteSubsystem = GetBiteSubsystem())
+	{
+		BiteSubsystem->Cancel(BiteIndex);
+	}
+	BiteSim.Cancel();
+	if (UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>())
+	{
+		FishSchools->RemoveHook(this);
+	}
+	SetBiteFXActive(false);
 }
 
 void AFishingGameCharacter::StartFishing()
 {
-	AFishingGamePlayerController* PController = Cast<AFishingGamePlayerController>(GetController());
-	if (PController)
+	FISHING_SCOPE(StartFishing);
+
+	IFishingAnglerController* AnglerController = Cast<IFishingAnglerController>(GetController());
+	if (AnglerController)
 	{
-		PController->SetCastingProgress(0.f);
-		if (!bFishBiting && PController->GetIsFishing())
+		AnglerController->SetCastingProgress(0.f);
+
+		// Bites are decided on the server
+		if (!HasAuthority())
+		{
+			return;
+		}
+
+		// Already started when the hook landed, or by the anim blueprint
+		if (!bFishBiting && AnglerController->GetIsFishing() && FishingState.Phase != EFishingPhase::Fishing)
 		{
-			GetWorldTimerManager().SetTimer(FishBiteTimerHandle, this, &AFishingGameCharacter::FishBite, FishingWaitTime, false);
+			SetFishingPhase(EFishingPhase::Fishing);
+			WaitForBite();
 		}
-		else if(bFishBiting && PController->GetIsFishing() && !PController->GetInTransition())
+		else if(bFishBiting && AnglerController->GetIsFishing() && !AnglerController->GetInTransition())
 		{
-			FishBiteFXComp->Deactivate();
+			SetBiteFXActive(false);
 			bFishBiting = false;
-			GetWorldTimerManager().SetTimer(FishBiteTimerHandle, this, &AFishingGameCharacter::FishBite, FishingWaitTime, false);
+			bCatchPending = false;
+			BiteSim.Cancel();
+			SetFishingPhase(EFishingPhase::Fishing);
+			WaitForBite();
 		}
 	}
 }
 
-void AFishingGameCharacter::FishBite()
+void AFishingGameCharacter::FishBite(int32 Species)
 {
-	AFishingGamePlayerController* PController = Cast<AFishingGamePlayerController>(GetController());
-	if (PController)
+	FISHING_SCOPE(FishBite);
+
+	IFishingAnglerController* AnglerController = Cast<IFishingAnglerController>(GetController());
+	if (AnglerController)
 	{
-		if (PController->GetIsFishing())
+		if (AnglerController->GetIsFishing())
 		{
 			bFishBiting = true;
-			FishBiteFXComp->Activate(true);
-			GetWorldTimerManager().SetTimer(FailTimerHandle, this, &AFishingGameCharacter::StartFishing, 2.f, false); // Wait for 2 second until fish swim away
+			bCatchPending = true;
+			if (Species != INDEX_NONE)
+			{
+				FFishingLootRoll Roll;
+				UFishingLootSubsystem* Loot = GetWorld()->GetSubsystem<UFishingLootSubsystem>();
+				PendingCatchSpecies = Species;
+				PendingCatchSize = Loot && Loot->RollSize(HookZone.Get(), Species, Roll) ? Roll.Size : FMath::FRandRange(CatchSizeRange.X, CatchSizeRange.Y);
+			}
+			// A timed bite happened at its deadline, not on the frame the wheel got to it, and the escape window runs from there
+			const double Now = GetWorld()->GetTimeSeconds();
+			const double BiteTime = Species == INDEX_NONE ? FMath::Min(GetBiteSubsystem()->GetDeadlineTime(BiteIndex), Now) : Now;
+			BiteSim.ArmBite(BiteTime, FishEscapeTime);
+			PendingWaitSeconds = GetFishingPhaseTime();
+			PendingZoneId = UFishingCatchJournalSubsystem::GetZoneId(HookZone.Get());
+			SetBiteFXActive(true);
+			SetFishingPhase(EFishingPhase::Biting);
+			GetBiteSubsystem()->ArmEscape(BiteIndex, (float)(BiteSim.GetEscapeTime() - Now)); // Wait until fish swim away
 		}
 	}
 }
+
+void AFishingGameCharacter::ReelIn(double PressTime)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	if (UFishingBiteSubsystem* BiteSubsystem = GetBiteSubsystem())
+	{
+		BiteSubsystem->Cancel(BiteIndex);
+	}
+
+	if (!bFishBiting)
+	{
+		BiteSim.Cancel();
+		return;
+	}
+
+	bool bHooked = false;
+	BiteSim.AddInput(FFishingCastSim::EInput::ReelPressed, PressTime);
+	FFishingCastSim::FEvent Event;
+	while (BiteSim.PopEvent(Event))
+	{
+		if (Event.Type == FFishingCastSim::EEventType::Hooked)
+		{
+			bHooked = true;
+			PendingReactionSeconds = Event.Value;
+		}
+	}
+
+	if (!bHooked)
+	{
+		// Pressed after the fish swam away, its escape just hadn't come up yet
+		SetBiteFXActive(false);
+		bFishBiting = false;
+		bCatchPending = false;
+	}
+}
+
+void AFishingGameCharacter::RecordCatch()
+{
+	FISHING_SCOPE(RecordCatch);
+
+	UFishingCatchJournalSubsystem* Journal = GetGameInstance() ? GetGameInstance()->GetSubsystem<UFishingCatchJournalSubsystem>() : nullptr;
+	if (!Journal || !HasAuthority())
+	{
+		return;
+	}
+
+	FFishingCatchRecord Record;
+	Record.Timestamp = FDateTime::UtcNow().GetTicks();
+	Record.ZoneId = PendingZoneId;
+	Record.AnglerId = GetPlayerState() ? (uint32)GetPlayerState()->GetPlayerId() : 0;
+	Record.Size = PendingCatchSize;
+	Record.CastPower = FishingNet::DequantizeProgress(FishingState.CastPower);
+	Record.CastDistance = FVector::Dist2D(HookTrajectory.Origin, HookTrajectory.LandingLocation);
+	Record.WaitSeconds = PendingWaitSeconds;
+	Record.ReactionSeconds = PendingReactionSeconds;
+	Record.Species = PendingCatchSpecies == INDEX_NONE ? FFishingCatchRecord::UnknownSpecies : (uint16)PendingCatchSpecies;
+	Journal->GetJournal().Append(Record);
+}
\ No newline at end of file
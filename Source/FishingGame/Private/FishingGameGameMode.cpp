@@ -3,14 +3,170 @@
 #include "FishingGameGameMode.h"
 #include "FishingGamePlayerController.h"
 #include "FishingGameCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "FishingGame.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+
+namespace FishingMapLoadBench
+{
+	/** A run reopens the map, so its state outlives every world it measures. */
+	static FString MapName;
+	static int32 RunsLeft = 0;
+	static int32 RunsDone = 0;
+	static double OpenTime = 0.0;
+	static double MapLoadedTime = 0.0;
+	static double TotalMapMs = 0.0;
+	static double TotalPawnMs = 0.0;
+	static TWeakObjectPtr<UWorld> LoadedWorld;
+	static FDelegateHandle PostLoadMapHandle;
+	static FDelegateHandle TickerHandle;
+
+	static constexpr double TimeoutSeconds = 120.0;
+
+	static void OpenMap(UWorld* World)
+	{
+		LoadedWorld = nullptr;
+		OpenTime = FPlatformTime::Seconds();
+		GEngine->Exec(World, *FString::Printf(TEXT("open %s"), *MapName));
+	}
+
+	static void Finish()
+	{
+		if (RunsDone > 0)
+		{
+			UE_LOG(LogFishingGame, Display, TEXT("Fishing map load bench: %s, %s loads, %d runs, map loaded in %.1f ms avg, player pawn in %.1f ms avg"),
+				*MapName, GFishingSyncAssetLoads ? TEXT("synchronous") : TEXT("streamed"), RunsDone, TotalMapMs / RunsDone, TotalPawnMs / RunsDone);
+		}
+
+		FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		PostLoadMapHandle.Reset();
+		TickerHandle.Reset();
+		GFishingSyncAssetLoads = false;
+		RunsLeft = 0;
+	}
+
+	static void OnPostLoadMap(UWorld* World)
+	{
+		MapLoadedTime = FPlatformTime::Seconds();
+		LoadedWorld = World;
+	}
+
+	/** A run ends when the map's first local player has a pawn, which with streaming can be well after the map itself loaded. */
+	static bool Tick(float DeltaTime)
+	{
+		UWorld* World = LoadedWorld.Get();
+		const APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+		if (!PC || !PC->GetPawn())
+		{
+			if (FPlatformTime::Seconds() - OpenTime > TimeoutSeconds)
+			{
+				UE_LOG(LogFishingGame, Warning, TEXT("Fishing map load bench: no local player pawn %.0f s after opening %s, stopping"), TimeoutSeconds, *MapName);
+				Finish();
+				return false;
+			}
+			return true;
+		}
+
+		const double MapMs = (MapLoadedTime - OpenTime) * 1000.0;
+		const double PawnMs = (FPlatformTime::Seconds() - OpenTime) * 1000.0;
+		UE_LOG(LogFishingGame, Display, TEXT("  run %d: map loaded in %.1f ms, player pawn in %.1f ms"), RunsDone + 1, MapMs, PawnMs);
+		TotalMapMs += MapMs;
+		TotalPawnMs += PawnMs;
+		++RunsDone;
+
+		if (--RunsLeft > 0)
+		{
+			OpenMap(World);
+			return true;
+		}
+
+		Finish();
+		return false;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.MapLoadBench"),
+		TEXT("Reopens the current map Runs times and logs how long until it loaded and until the local player had a pawn. With sync, the pawn class and angler equipment load synchronously during map load as the old hard references did. Everything the previous run loaded is garbage collected by the map change, the OS file cache stays warm. Usage: Fishing.MapLoadBench [Runs=3] [sync]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World || RunsLeft > 0)
+			{
+				return;
+			}
+
+			MapName = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+			RunsLeft = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 3;
+			RunsDone = 0;
+			TotalMapMs = 0.0;
+			TotalPawnMs = 0.0;
+			GFishingSyncAssetLoads = Args.Num() > 1 && Args[1] == TEXT("sync");
+
+			PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddStatic(&OnPostLoadMap);
+			TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&Tick));
+			OpenMap(World);
+		}));
+}
 
 AFishingGameGameMode::AFishingGameGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/FishingGame/Blueprints/Character/BP_FishingCharacter"));
-	if (PlayerPawnBPClass.Class != nullptr)
+	// set default pawn class to our Blueprinted character, without loading it with the class default object
+	DefaultPawnSoftClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/FishingGame/Blueprints/Character/BP_FishingCharacter.BP_FishingCharacter_C")));
+	DefaultPawnClass = AFishingGameCharacter::StaticClass();
+}
+
+void AFishingGameGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	// Streams while the rest of the map loads and begins play
+	if (!DefaultPawnSoftClass.IsNull() && !DefaultPawnSoftClass.Get())
+	{
+		PawnClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(DefaultPawnSoftClass.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &AFishingGameGameMode::OnPawnClassLoaded));
+		if (GFishingSyncAssetLoads && PawnClassHandle.IsValid())
+		{
+			PawnClassHandle->WaitUntilComplete();
+		}
+	}
+}
+
+UClass* AFishingGameGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+	if (UClass* PawnClass = DefaultPawnSoftClass.Get())
+	{
+		return PawnClass;
+	}
+	return Super::GetDefaultPawnClassForController_Implementation(InController);
+}
+
+void AFishingGameGameMode::RestartPlayer(AController* NewPlayer)
+{
+	if (NewPlayer && PawnClassHandle.IsValid() && PawnClassHandle->IsLoadingInProgress())
+	{
+		UE_LOG(LogFishingGame, Verbose, TEXT("%s joined before %s finished streaming, spawning it once it has"), *NewPlayer->GetName(), *DefaultPawnSoftClass.ToString());
+		PendingRestarts.AddUnique(NewPlayer);
+		return;
+	}
+
+	Super::RestartPlayer(NewPlayer);
+}
+
+void AFishingGameGameMode::OnPawnClassLoaded()
+{
+	if (!DefaultPawnSoftClass.Get())
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("%s could not be loaded, players get %s"), *DefaultPawnSoftClass.ToString(), *GetNameSafe(DefaultPawnClass));
+	}
+
+	const TArray<TWeakObjectPtr<AController>> Pending = MoveTemp(PendingRestarts);
+	for (const TWeakObjectPtr<AController>& Controller : Pending)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		if (Controller.IsValid() && !Controller->GetPawn())
+		{
+			RestartPlayer(Controller.Get());
+		}
 	}
-}
\ No newline at end of file
+}
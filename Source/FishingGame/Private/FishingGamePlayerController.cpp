@@ -1,26 +1,76 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "FishingGamePlayerController.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
 #include "Runtime/Engine/Classes/Components/DecalComponent.h"
+#include "FishingGame.h"
 #include "FishingGameCharacter.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Engine/World.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Blueprint/UserWidget.h"
+#include "GameFramework/WorldSettings.h"
+#include "FishingCastingBarWidget.h"
+#include "FishingNetTypes.h"
+#include "FishingEquipmentData.h"
+#include "FishingInputReplay.h"
+#include "FishingInputTimestamps.h"
+#include "FishingMoveToComponent.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "Framework/Application/SlateApplication.h"
+#include "GameFramework/PlayerInput.h"
+#include "Misc/App.h"
+#include "TimerManager.h"
+
+namespace FishingPlayerInput
+{
+	static const FName CastAction(TEXT("Throw/ReelCast"));
+}
 
 AFishingGamePlayerController::AFishingGamePlayerController()
 {
 	bShowMouseCursor = true;
 	DefaultMouseCursor = EMouseCursor::Default;
+
+	CursorTraceDelegate.BindUObject(this, &AFishingGamePlayerController::OnCursorTraceDone);
+
+	CastingBarWidgetClass = UFishingCastingBarWidget::StaticClass();
+
+	PathFollowingComponent = CreateDefaultSubobject<UPathFollowingComponent>(TEXT("PathFollowingComponent"));
+	MoveToComponent = CreateDefaultSubobject<UFishingMoveToComponent>(TEXT("MoveToComponent"));
 }
 
 void AFishingGamePlayerController::BeginPlay()
 {
 	Super::BeginPlay();
 
+	FFishingCastSim::FSettings CastSettings;
+	CastSettings.ChargeRate = CastingSpeed;
+	CastSim.Reset(CastSettings, GetWorld()->GetTimeSeconds());
+
+	// Scripted controllers (e.g. Fishing.Soak anglers) have no viewport to put widgets in, nor input or a cursor to tick for
+	if (!GetLocalPlayer())
+	{
+		if (!GetNetConnection())
+		{
+			SetActorTickEnabled(false);
+		}
+		return;
+	}
+
+	if (FSlateApplication::IsInitialized())
+	{
+		InputTimestamps = MakeShared<FFishingInputTimestamps>();
+		FSlateApplication::Get().RegisterInputPreProcessor(InputTimestamps);
+	}
+
+	// A native casting bar lives in the viewport for the whole session and is only collapsed between casts
 	if (CastingBarWidgetClass)
 	{
 		CastingBarWidget = CreateWidget<UUserWidget>(this, CastingBarWidgetClass);
+		if (CastingBarWidget && CastingBarWidget->IsA<UFishingCastingBarWidget>())
+		{
+			CastingBarWidget->AddToViewport();
+		}
 	}
 
 	if (ControlsWidgetClass)
@@ -38,34 +88,157 @@ void AFishingGamePlayerController::BeginPlay()
 	}
 }
 
+void AFishingGamePlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (InputTimestamps.IsValid() && FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().UnregisterInputPreProcessor(InputTimestamps);
+	}
+	InputTimestamps.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AFishingGamePlayerController::PlayerTick(float DeltaSeconds)
 {
+	UFishingInputReplaySubsystem* InputReplay = GetInputReplay();
+	if (InputReplay && InputReplay->IsReplaying())
+	{
+		InputReplay->ReplayFrame(this);
+	}
+
+	// Processes this frame's input, so it has to run every frame
 	Super::PlayerTick(DeltaSeconds);
 
-	if (bMoveToMouseCursor)
+	// Only the cursor trace runs on an idle frame, and it's skipped unless the cursor or the view moved
+	UpdateCursorHit();
+
+	// Everything else waits for a held cast or a click-to-move
+	if (bReadyToFish || bMoveToMouseCursor || IsMovingToDestination())
 	{
-		MoveToMouseCursor();
+		INC_DWORD_STAT(STAT_FishingActorsTicked);
+		++GFishingActorsTicked;
+
+		// After this frame's input, which may have pressed or released the cast
+		if (bReadyToFish)
+		{
+			CastSim.Advance(GetWorld()->GetTimeSeconds());
+			UpdateCharge();
+		}
+
+		if (bMoveToMouseCursor)
+		{
+			MoveToMouseCursor();
+		}
+	}
+
+	if (InputReplay && InputReplay->IsRecording())
+	{
+		FVector2D MousePosition;
+		int32 ViewportX = 0;
+		int32 ViewportY = 0;
+		GetViewportSize(ViewportX, ViewportY);
+		if (GetMousePosition(MousePosition.X, MousePosition.Y) && ViewportX > 0 && ViewportY > 0)
+		{
+			InputReplay->RecordCursor(MousePosition / FVector2D(ViewportX, ViewportY));
+		}
+		InputReplay->EndFrame(FApp::GetDeltaTime());
 	}
+}
 
+UFishingInputReplaySubsystem* AFishingGamePlayerController::GetInputReplay() const
+{
+	UFishingInputReplaySubsystem* InputReplay = GetLocalPlayer() ? GetWorld()->GetSubsystem<UFishingInputReplaySubsystem>() : nullptr;
+	if (InputReplay && (InputReplay->IsRecording() || InputReplay->IsReplaying()) && InputReplay->IsInputOwner(this))
+	{
+		return InputReplay;
+	}
+	return nullptr;
+}
+
+bool AFishingGamePlayerController::GetCursorPosition(FVector2D& OutPosition) const
+{
+	const UFishingInputReplaySubsystem* InputReplay = GetInputReplay();
+	if (InputReplay && InputReplay->IsReplaying())
+	{
+		int32 ViewportX = 0;
+		int32 ViewportY = 0;
+		GetViewportSize(ViewportX, ViewportY);
+		OutPosition = InputReplay->GetReplayCursor() * FVector2D(ViewportX, ViewportY);
+		return ViewportX > 0 && ViewportY > 0;
+	}
+	return GetMousePosition(OutPosition.X, OutPosition.Y);
+}
+
+void AFishingGamePlayerController::OnInput(EFishingInput Input, float Value)
+{
+	if (UFishingInputReplaySubsystem* InputReplay = GetInputReplay())
+	{
+		if (InputReplay->IsReplaying())
+		{
+			return;
+		}
+		InputReplay->RecordInput(Input, Value);
+	}
+	ApplyInput(Input, Value);
+}
+
+void AFishingGamePlayerController::ApplyInput(EFishingInput Input, float Value)
+{
+	switch (Input)
+	{
+	case EFishingInput::SetDestinationPressed:
+		OnSetDestinationPressed();
+		break;
+	case EFishingInput::SetDestinationReleased:
+		OnSetDestinationReleased();
+		break;
+	case EFishingInput::ThrowCastPressed:
+		ReadyThrowCast();
+		break;
+	case EFishingInput::ThrowCastReleased:
+		ThrowCast();
+		break;
+	case EFishingInput::MoveForward:
+		MoveForward(Value);
+		break;
+	case EFishingInput::MoveRight:
+		MoveRight(Value);
+		break;
+	case EFishingInput::RotateCamera:
+		RotateCamera(Value);
+		break;
+	case EFishingInput::ZoomCamera:
+		ZoomCamera(Value);
+		break;
+	default:
+		break;
+	}
+}
+
+float AFishingGamePlayerController::GetCastingProgress() const
+{
 	if (bReadyToFish)
 	{
-		CastingProgress = FMath::FInterpConstantTo(CastingProgress, 1.f, DeltaSeconds, CastingSpeed);
+		return CastSim.GetCharge();
 	}
+	return CastingProgress;
 }
 
 void AFishingGamePlayerController::SetupInputComponent()
 {
 	Super::SetupInputComponent();
 
-	InputComponent->BindAction("SetDestination", IE_Pressed, this, &AFishingGamePlayerController::OnSetDestinationPressed);
-	InputComponent->BindAction("SetDestination", IE_Released, this, &AFishingGamePlayerController::OnSetDestinationReleased);
-	InputComponent->BindAction("Throw/ReelCast", IE_Pressed, this, &AFishingGamePlayerController::ReadyThrowCast);
-	InputComponent->BindAction("Throw/ReelCast", IE_Released, this, &AFishingGamePlayerController::ThrowCast);
+	// Routed through OnInput so it can be recorded and replayed
+	InputComponent->BindAction("SetDestination", IE_Pressed, this, &AFishingGamePlayerController::OnInputAction<EFishingInput::SetDestinationPressed>);
+	InputComponent->BindAction("SetDestination", IE_Released, this, &AFishingGamePlayerController::OnInputAction<EFishingInput::SetDestinationReleased>);
+	InputComponent->BindAction(FishingPlayerInput::CastAction, IE_Pressed, this, &AFishingGamePlayerController::OnInputAction<EFishingInput::ThrowCastPressed>);
+	InputComponent->BindAction(FishingPlayerInput::CastAction, IE_Released, this, &AFishingGamePlayerController::OnInputAction<EFishingInput::ThrowCastReleased>);
 	InputComponent->BindAction("PauseGame", IE_Pressed, this, &AFishingGamePlayerController::TogglePauseMenu);
-	InputComponent->BindAxis("MoveForward", this, &AFishingGamePlayerController::MoveForward);
-	InputComponent->BindAxis("MoveRight", this, &AFishingGamePlayerController::MoveRight);
-	InputComponent->BindAxis("RotateCamera", this, &AFishingGamePlayerController::RotateCamera);
-	InputComponent->BindAxis("ZoomCamera", this, &AFishingGamePlayerController::ZoomCamera);
+	InputComponent->BindAxis("MoveForward", this, &AFishingGamePlayerController::OnInputAxis<EFishingInput::MoveForward>);
+	InputComponent->BindAxis("MoveRight", this, &AFishingGamePlayerController::OnInputAxis<EFishingInput::MoveRight>);
+	InputComponent->BindAxis("RotateCamera", this, &AFishingGamePlayerController::OnInputAxis<EFishingInput::RotateCamera>);
+	InputComponent->BindAxis("ZoomCamera", this, &AFishingGamePlayerController::OnInputAxis<EFishingInput::ZoomCamera>);
 }
 
 void AFishingGamePlayerController::MoveForward(float Value)
@@ -75,7 +248,7 @@ void AFishingGamePlayerController::MoveForward(float Value)
 		AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter());
 		if (PlayerCharacter)
 		{
-			if (IsFollowingAPath()) StopMovement();
+			if (IsMovingToDestination()) StopMovement();
 
 			USpringArmComponent* CameraBoom = PlayerCharacter->GetCameraBoom();
 			if (CameraBoom)
@@ -97,7 +270,7 @@ void AFishingGamePlayerController::MoveRight(float Value)
 		AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter());
 		if (PlayerCharacter)
 		{
-			if (IsFollowingAPath()) StopMovement();
+			if (IsMovingToDestination()) StopMovement();
 
 			USpringArmComponent* CameraBoom = PlayerCharacter->GetCameraBoom();
 			if (CameraBoom)
@@ -114,12 +287,80 @@ void AFishingGamePlayerController::MoveRight(float Value)
 
 void AFishingGamePlayerController::MoveToMouseCursor()
 {
-	FHitResult Hit;
-	GetHitResultUnderCursor(ECC_Visibility, false, Hit);
+	if (CursorHit.bBlockingHit)
+	{
+		SetNewMoveDestination(CursorHit.ImpactPoint);
+	}
+}
+
+bool AFishingGamePlayerController::IsMovingToDestination() const
+{
+	return IsFollowingAPath() || MoveToComponent->IsMovePending();
+}
+
+void AFishingGamePlayerController::StopMovement()
+{
+	MoveToComponent->StopMove();
+
+	Super::StopMovement();
+}
 
-	if (Hit.bBlockingHit)
+void AFishingGamePlayerController::UpdateCursorHit()
+{
+	FISHING_SCOPE(CursorTrace);
+
+	// Previous trace hasn't come back yet, it will be delivered at the start of next frame
+	if (CursorTraceHandle.IsValid() && GetWorld()->IsTraceHandleValid(CursorTraceHandle, false))
+	{
+		return;
+	}
+
+	FVector2D MousePosition;
+	if (!GetCursorPosition(MousePosition) || !PlayerCameraManager)
 	{
-		SetNewMoveDestination(Hit.ImpactPoint);
+		return;
+	}
+
+	const FVector ViewLocation = PlayerCameraManager->GetCameraLocation();
+	const FRotator ViewRotation = PlayerCameraManager->GetCameraRotation();
+
+	// Nothing moved since the last trace, the cached hit is still valid
+	if (CursorHitFrame != 0 && MousePosition.Equals(LastCursorPosition) && ViewLocation.Equals(LastCursorViewLocation) && ViewRotation.Equals(LastCursorViewRotation))
+	{
+		return;
+	}
+
+	FVector WorldOrigin;
+	FVector WorldDirection;
+	if (!DeprojectScreenPositionToWorld(MousePosition.X, MousePosition.Y, WorldOrigin, WorldDirection))
+	{
+		return;
+	}
+
+	LastCursorPosition = MousePosition;
+	LastCursorViewLocation = ViewLocation;
+	LastCursorViewRotation = ViewRotation;
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(FishingCursorTrace), bTraceCursorComplex);
+	CursorTraceHandle = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, WorldOrigin, WorldOrigin + WorldDirection * HitResultTraceDistance, ECC_Visibility, Params, FCollisionResponseParams::DefaultResponseParam, &CursorTraceDelegate);
+}
+
+void AFishingGamePlayerController::OnCursorTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (TraceHandle != CursorTraceHandle)
+	{
+		return;
+	}
+
+	FISHING_SCOPE(CursorTrace);
+
+	CursorTraceHandle = FTraceHandle();
+	CursorHit = TraceDatum.OutHits.Num() > 0 ? TraceDatum.OutHits[0] : FHitResult();
+	CursorHitFrame = GFrameCounter;
+
+	if (AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter()))
+	{
+		PlayerCharacter->UpdateCursorDecal(CursorHit);
 	}
 }
 
@@ -158,44 +399,172 @@ void AFishingGamePlayerController::ZoomCamera(float Value)
 
 void AFishingGamePlayerController::ReadyThrowCast()
 {
+	FISHING_SCOPE(ReadyThrowCast);
+
 	CastingProgress = 0.f;
 	if (bFail) bFail = false;
-	if (IsFollowingAPath()) StopMovement();
+	if (IsMovingToDestination()) StopMovement();
 	if (!bFishing && !bTransition)
 	{
-		if (CastingBarWidget)
+		CastSim.AddInput(FFishingCastSim::EInput::CastPressed, GetCastInputTime(true));
+		bReadyToFish = true;
+
+		if (UFishingCastingBarWidget* CastingBar = Cast<UFishingCastingBarWidget>(CastingBarWidget))
+		{
+			CastingBar->StartCharging();
+			UpdateCharge();
+		}
+		else if (CastingBarWidget)
 		{
 			CastingBarWidget->AddToViewport();
 		}
-		bReadyToFish = true;
 
 		AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter());
-		if (PlayerCharacter && PlayerCharacter->GetFishMesh() && PlayerCharacter->GetFishMesh()->IsVisible())
+		if (PlayerCharacter)
 		{
-			PlayerCharacter->GetFishMesh()->SetVisibility(false);
+			PlayerCharacter->HideCaughtFish();
+			PlayerCharacter->LoadEquipmentBundle(UFishingEquipmentData::FishingBundle);
+			PlayerCharacter->SetFishingPhase(EFishingPhase::Charging);
 		}
 	}
 	else if(bFishing && !bTransition)
 	{
 		bFishing = false;
 		bTransition = true;
+
+		if (AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter()))
+		{
+			PlayerCharacter->ReelIn(GetCastInputTime(true));
+			PlayerCharacter->SetFishingPhase(EFishingPhase::Reeling);
+		}
+
+		if (HasAuthority() && !IsLocalController())
+		{
+			GetWorldTimerManager().SetTimer(RemoteCastTimer, this, &AFishingGamePlayerController::FinishRemoteReel, RemoteReelDuration, false);
+		}
+	}
+
+	// Run locally for a responsive bar and animation, the server decides what actually happens
+	if (!HasAuthority())
+	{
+		ServerReadyThrowCast();
 	}
 }
 
 void AFishingGamePlayerController::ThrowCast()
 {
+	ThrowCastAt(ReleaseCharge());
+}
+
+void AFishingGamePlayerController::ThrowCastAt(float Progress)
+{
+	FISHING_SCOPE(ThrowCast);
+
 	if (!bFishing && bReadyToFish && !bTransition)
 	{
+		CastingProgress = FMath::Clamp(Progress, 0.f, 1.f);
 		bReadyToFish = false;
 		bTransition = true;
+
+		if (!HasAuthority())
+		{
+			ServerThrowCast(FishingNet::QuantizeProgress(CastingProgress));
+		}
+		else if (AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter()))
+		{
+			PlayerCharacter->SetFishingPhase(EFishingPhase::Casting, CastingProgress);
+		}
+	}
+}
+
+void AFishingGamePlayerController::ServerReadyThrowCast_Implementation()
+{
+	ReadyThrowCast();
+}
+
+void AFishingGamePlayerController::ServerThrowCast_Implementation(uint8 ClientCastPower)
+{
+	// Both RPCs travel the same path, so the server's charge time only differs from the player's by jitter
+	const float ServerProgress = ReleaseCharge();
+	ThrowCastAt(FMath::Clamp(FishingNet::DequantizeProgress(ClientCastPower), ServerProgress - CastProgressTolerance, ServerProgress + CastProgressTolerance));
+
+	const AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter());
+	if (PlayerCharacter && PlayerCharacter->GetFishingPhase() == EFishingPhase::Casting)
+	{
+		GetWorldTimerManager().SetTimer(RemoteCastTimer, this, &AFishingGamePlayerController::LaunchRemoteHook, RemoteLaunchDelay, false);
 	}
 }
 
+void AFishingGamePlayerController::LaunchRemoteHook()
+{
+	AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter());
+	if (PlayerCharacter && PlayerCharacter->GetFishingPhase() == EFishingPhase::Casting)
+	{
+		PlayerCharacter->LaunchHook();
+	}
+}
+
+void AFishingGamePlayerController::FinishRemoteReel()
+{
+	AFishingGameCharacter* PlayerCharacter = Cast<AFishingGameCharacter>(GetCharacter());
+	if (PlayerCharacter && PlayerCharacter->GetFishingPhase() == EFishingPhase::Reeling)
+	{
+		PlayerCharacter->ReelHook();
+		PlayerCharacter->ClearTimersAndVFX();
+	}
+	bTransition = false;
+}
+
 bool AFishingGamePlayerController::CheckIsFishing() const
 {
 	return (bReadyToFish || bFishing || bTransition);
 }
 
+double AFishingGamePlayerController::GetCastInputTime(bool bPressed) const
+{
+	const UFishingInputReplaySubsystem* InputReplay = GetInputReplay();
+	if (!InputTimestamps.IsValid() || !PlayerInput || (InputReplay && InputReplay->IsReplaying()))
+	{
+		return GetWorld()->GetTimeSeconds();
+	}
+
+	// Whichever key bound to the cast moved last is the one that fired it
+	double PlatformTime = 0.0;
+	for (const FInputActionKeyMapping& Mapping : PlayerInput->GetKeysForAction(FishingPlayerInput::CastAction))
+	{
+		PlatformTime = FMath::Max(PlatformTime, InputTimestamps->GetEventTime(Mapping.Key, bPressed));
+	}
+	return PlatformTime > 0.0 ? FFishingInputTimestamps::ToWorldTime(GetWorld(), PlatformTime) : GetWorld()->GetTimeSeconds();
+}
+
+float AFishingGamePlayerController::ReleaseCharge()
+{
+	CastSim.AddInput(FFishingCastSim::EInput::CastReleased, GetCastInputTime(false));
+
+	float Power = CastingProgress;
+	FFishingCastSim::FEvent Event;
+	while (CastSim.PopEvent(Event))
+	{
+		if (Event.Type == FFishingCastSim::EEventType::Thrown)
+		{
+			Power = Event.Value;
+		}
+	}
+	return Power;
+}
+
+void AFishingGamePlayerController::UpdateCharge()
+{
+	CastingProgress = CastSim.GetCharge();
+
+	if (UFishingCastingBarWidget* CastingBar = Cast<UFishingCastingBarWidget>(CastingBarWidget))
+	{
+		// The charge follows the world's clock, so it stands still while paused and slows down with time dilation
+		const float FillRate = IsPaused() ? 0.f : CastingSpeed * GetWorldSettings()->GetEffectiveTimeDilation();
+		CastingBar->SyncCharge(CastingProgress, CastingProgress < 1.f ? FillRate : 0.f);
+	}
+}
+
 void AFishingGamePlayerController::TogglePauseMenu()
 {
 	if (PauseWidget)
@@ -215,7 +584,11 @@ void AFishingGamePlayerController::TogglePauseMenu()
 
 void AFishingGamePlayerController::RemoveCastingWidget()
 {
-	if (CastingBarWidget)
+	if (UFishingCastingBarWidget* CastingBar = Cast<UFishingCastingBarWidget>(CastingBarWidget))
+	{
+		CastingBar->StopCharging();
+	}
+	else if (CastingBarWidget)
 	{
 		CastingBarWidget->RemoveFromParent();
 	}
@@ -229,7 +602,7 @@ void AFishingGamePlayerController::SetNewMoveDestination(const FVector DestLocat
 
 		if ((Distance > 120.0f))
 		{
-			UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, DestLocation);
+			MoveToComponent->MoveTo(DestLocation);
 		}
 	}
 }
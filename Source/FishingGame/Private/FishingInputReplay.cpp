@@ -0,0 +1,468 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingInputReplay.h"
+#include "FishingGame.h"
+#include "FishingGamePlayerController.h"
+#include "FishingLootTable.h"
+#include "FishSchoolSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace FishingInputReplay
+{
+	static constexpr int32 CursorSteps = 65535;
+
+	/** Command line recordings and replays belong to the first game world only. */
+	static bool bCheckedCommandLine = false;
+
+	static FORCEINLINE uint32 ZigZag(int32 Value)
+	{
+		return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+	}
+
+	static FORCEINLINE int32 UnZigZag(uint32 Value)
+	{
+		return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	}
+
+	static void WriteAxis(FArchive& Ar, float Value)
+	{
+		const float Steps = Value * UFishingInputReplaySubsystem::AxisScale;
+		const int32 Quantized = FMath::RoundToInt(Steps);
+		if ((float)Quantized == Steps && FMath::Abs(Quantized) < (1 << 29))
+		{
+			uint32 Packed = ZigZag(Quantized) << 1;
+			Ar.SerializeIntPacked(Packed);
+			return;
+		}
+
+		// Off the grid, e.g. a mouse axis. Stored as is so the replay runs on exactly the recorded value
+		uint32 Packed = 1;
+		Ar.SerializeIntPacked(Packed);
+		Ar << Value;
+	}
+
+	static float ReadAxis(FArchive& Ar)
+	{
+		uint32 Packed = 0;
+		Ar.SerializeIntPacked(Packed);
+		if (Packed & 1)
+		{
+			float Value = 0.f;
+			Ar << Value;
+			return Value;
+		}
+		return UnZigZag(Packed >> 1) / UFishingInputReplaySubsystem::AxisScale;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs RecordCommand(
+		TEXT("Fishing.RecordInput"),
+		TEXT("Records the local player's input. Usage: Fishing.RecordInput <Name> to start, Fishing.RecordInput to stop and write Saved/FishingInput/<Name>.fir"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (UFishingInputReplaySubsystem* InputReplay = World ? World->GetSubsystem<UFishingInputReplaySubsystem>() : nullptr)
+			{
+				if (Args.Num() > 0)
+				{
+					InputReplay->StartRecording(Args[0]);
+				}
+				else
+				{
+					InputReplay->StopRecording();
+				}
+			}
+		}));
+
+	static FAutoConsoleCommandWithWorldAndArgs ReplayCommand(
+		TEXT("Fishing.ReplayInput"),
+		TEXT("Replays recorded input. Only lines up with the recording when started from the command line with -FishingReplayInput=<Name>. Usage: Fishing.ReplayInput <Name>"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingInputReplaySubsystem* InputReplay = World ? World->GetSubsystem<UFishingInputReplaySubsystem>() : nullptr;
+			if (InputReplay && Args.Num() > 0)
+			{
+				InputReplay->StartReplay(Args[0]);
+			}
+		}));
+}
+
+FString UFishingInputReplaySubsystem::GetRecordingPath(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("FishingInput") / (Name + TEXT(".fir"));
+}
+
+void UFishingInputReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	// Seeds are applied on top of what these read from the command line
+	Collection.InitializeDependency(UFishSchoolSubsystem::StaticClass());
+	Collection.InitializeDependency(UFishingLootSubsystem::StaticClass());
+
+	Super::Initialize(Collection);
+
+	if (FishingInputReplay::bCheckedCommandLine || !GetWorld()->IsGameWorld())
+	{
+		return;
+	}
+	FishingInputReplay::bCheckedCommandLine = true;
+
+	FString Name;
+	if (FParse::Value(FCommandLine::Get(), TEXT("FishingReplayInput="), Name))
+	{
+		StartReplay(Name);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("FishingRecordInput="), Name))
+	{
+		StartRecording(Name);
+	}
+}
+
+void UFishingInputReplaySubsystem::Deinitialize()
+{
+	StopRecording();
+	StopReplay();
+
+	Super::Deinitialize();
+}
+
+bool UFishingInputReplaySubsystem::StartRecording(const FString& Name)
+{
+	if (IsRecording() || IsReplaying() || Name.IsEmpty())
+	{
+		return false;
+	}
+
+	const UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>();
+
+	Header = FHeader();
+	Header.RandomSeed = (int32)FPlatformTime::Cycles();
+	FParse::Value(FCommandLine::Get(), TEXT("FishingRandomSeed="), Header.RandomSeed);
+	Header.FishSeed = FishSchools ? FishSchools->Seed : 0;
+	Header.MapName = GetWorld()->GetMapName();
+	ApplySeeds(Header.RandomSeed, Header.FishSeed);
+
+	Data.Reset();
+	FrameEvents.Reset();
+	NumFrameEvents = 0;
+	NumFrames = 0;
+	DeltaMicros = 0;
+	FMemory::Memzero(Axes);
+	CursorSteps = FIntPoint::ZeroValue;
+	InputOwner = nullptr;
+	RecordingName = Name;
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing input: recording %s"), *GetRecordingPath(Name));
+	return true;
+}
+
+void UFishingInputReplaySubsystem::StopRecording()
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	Header.NumFrames = NumFrames;
+
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData, true);
+	Writer << Header;
+	FileData.Append(Data);
+
+	const FString Path = GetRecordingPath(RecordingName);
+	if (FFileHelper::SaveArrayToFile(FileData, *Path))
+	{
+		UE_LOG(LogFishingGame, Display, TEXT("Fishing input: %d frames in %d bytes written to %s"), NumFrames, FileData.Num(), *Path);
+	}
+	else
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing input: could not write %s"), *Path);
+	}
+
+	RecordingName.Empty();
+	Data.Empty();
+	InputOwner = nullptr;
+}
+
+bool UFishingInputReplaySubsystem::StartReplay(const FString& Name)
+{
+	if (IsRecording() || IsReplaying() || Name.IsEmpty())
+	{
+		return false;
+	}
+
+	const FString Path = GetRecordingPath(Name);
+	if (!FFileHelper::LoadFileToArray(Data, *Path))
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing input: could not read %s"), *Path);
+		return false;
+	}
+
+	FMemoryReader Reader(Data, true);
+	Header = FHeader();
+	Reader << Header;
+	if (Reader.IsError() || Header.Magic != FileMagic || Header.Version != FileVersion)
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing input: %s is not a version %u input recording"), *Path, FileVersion);
+		Data.Empty();
+		return false;
+	}
+	if (Header.MapName != GetWorld()->GetMapName())
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing input: %s was recorded on %s, replaying it on %s"), *Path, *Header.MapName, *GetWorld()->GetMapName());
+	}
+
+	ReadOffset = Reader.Tell();
+	NumFrames = 0;
+	PendingEvents = 0;
+	DeltaMicros = 0;
+	FMemory::Memzero(Axes);
+	CursorSteps = FIntPoint::ZeroValue;
+	Cursor = FVector2D::ZeroVector;
+	InputOwner = nullptr;
+	ApplySeeds(Header.RandomSeed, Header.FishSeed);
+
+	bUsedFixedTimeStep = FApp::UseFixedTimeStep();
+	FixedDeltaTimeBefore = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	ReplayName = Name;
+
+	if (!ReadFrameHeader())
+	{
+		StopReplay();
+		return false;
+	}
+
+#if CSV_PROFILER
+	if (!FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture(-1, FPaths::ProfilingDir() / TEXT("FishingInput"), FString::Printf(TEXT("%s-%s.csv"), *Name, *FDateTime::Now().ToString()));
+		bCapturingCsv = true;
+	}
+#endif
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing input: replaying %u frames from %s"), Header.NumFrames, *Path);
+	return true;
+}
+
+void UFishingInputReplaySubsystem::StopReplay()
+{
+	if (!IsReplaying())
+	{
+		return;
+	}
+
+	FApp::SetUseFixedTimeStep(bUsedFixedTimeStep);
+	FApp::SetFixedDeltaTime(FixedDeltaTimeBefore);
+	EndCsvCapture();
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing input: replayed %d of %u frames of %s"), NumFrames, Header.NumFrames, *ReplayName);
+
+	ReplayName.Empty();
+	Data.Empty();
+	InputOwner = nullptr;
+}
+
+bool UFishingInputReplaySubsystem::IsInputOwner(const AFishingGamePlayerController* Controller)
+{
+	if (!InputOwner.IsValid())
+	{
+		InputOwner = Controller;
+	}
+	return InputOwner == Controller;
+}
+
+void UFishingInputReplaySubsystem::ApplySeeds(int32 RandomSeed, int32 FishSeed)
+{
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	if (UFishingLootSubsystem* Loot = GetWorld()->GetSubsystem<UFishingLootSubsystem>())
+	{
+		Loot->SetSeed(RandomSeed);
+	}
+	if (UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>())
+	{
+		FishSchools->Seed = FishSeed;
+	}
+}
+
+void UFishingInputReplaySubsystem::RecordInput(EFishingInput Input, float Value)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	if (FishingInput::IsAxis(Input))
+	{
+		float& LastValue = Axes[(uint8)Input - FishingInput::FirstAxis];
+		if (LastValue == Value)
+		{
+			return;
+		}
+		LastValue = Value;
+	}
+
+	FMemoryWriter Writer(FrameEvents, false, true);
+	uint8 Code = (uint8)Input;
+	Writer << Code;
+	if (FishingInput::IsAxis(Input))
+	{
+		FishingInputReplay::WriteAxis(Writer, Value);
+	}
+	++NumFrameEvents;
+}
+
+void UFishingInputReplaySubsystem::RecordCursor(const FVector2D& Position)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	const FIntPoint Steps(FMath::RoundToInt(FMath::Clamp(Position.X, 0.f, 1.f) * FishingInputReplay::CursorSteps), FMath::RoundToInt(FMath::Clamp(Position.Y, 0.f, 1.f) * FishingInputReplay::CursorSteps));
+	if (Steps == CursorSteps)
+	{
+		return;
+	}
+
+	FMemoryWriter Writer(FrameEvents, false, true);
+	uint8 Code = (uint8)EFishingInput::Cursor;
+	uint32 MoveX = FishingInputReplay::ZigZag(Steps.X - CursorSteps.X);
+	uint32 MoveY = FishingInputReplay::ZigZag(Steps.Y - CursorSteps.Y);
+	Writer << Code;
+	Writer.SerializeIntPacked(MoveX);
+	Writer.SerializeIntPacked(MoveY);
+	CursorSteps = Steps;
+	++NumFrameEvents;
+}
+
+void UFishingInputReplaySubsystem::EndFrame(float DeltaTime)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	const uint32 Micros = (uint32)FMath::RoundToInt(DeltaTime * 1000000.f);
+	const bool bDeltaTimeChanged = Micros != DeltaMicros;
+
+	FMemoryWriter Writer(Data, false, true);
+	uint32 FrameHeader = ((uint32)NumFrameEvents << 1) | (bDeltaTimeChanged ? 1 : 0);
+	Writer.SerializeIntPacked(FrameHeader);
+	if (bDeltaTimeChanged)
+	{
+		uint32 Change = FishingInputReplay::ZigZag((int32)Micros - (int32)DeltaMicros);
+		Writer.SerializeIntPacked(Change);
+		DeltaMicros = Micros;
+	}
+	Writer.Serialize(FrameEvents.GetData(), FrameEvents.Num());
+
+	FrameEvents.Reset();
+	NumFrameEvents = 0;
+	++NumFrames;
+}
+
+bool UFishingInputReplaySubsystem::ReadFrameHeader()
+{
+	if (ReadOffset >= Data.Num())
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data, true);
+	Reader.Seek(ReadOffset);
+
+	uint32 FrameHeader = 0;
+	Reader.SerializeIntPacked(FrameHeader);
+	if (FrameHeader & 1)
+	{
+		uint32 Change = 0;
+		Reader.SerializeIntPacked(Change);
+		DeltaMicros = (uint32)((int32)DeltaMicros + FishingInputReplay::UnZigZag(Change));
+	}
+	PendingEvents = FrameHeader >> 1;
+	ReadOffset = Reader.Tell();
+
+	if (Reader.IsError())
+	{
+		return false;
+	}
+
+	// The engine picks it up as the length of the frame this input is replayed on
+	FApp::SetFixedDeltaTime(DeltaMicros / 1000000.0);
+	return true;
+}
+
+void UFishingInputReplaySubsystem::ReplayFrame(AFishingGamePlayerController* Controller)
+{
+	if (!IsReplaying())
+	{
+		return;
+	}
+
+	FMemoryReader Reader(Data, true);
+	Reader.Seek(ReadOffset);
+
+	for (int32 Event = 0; Event < PendingEvents && !Reader.IsError(); ++Event)
+	{
+		uint8 Code = 0;
+		Reader << Code;
+		const EFishingInput Input = (EFishingInput)Code;
+
+		if (Input == EFishingInput::Cursor)
+		{
+			uint32 MoveX = 0;
+			uint32 MoveY = 0;
+			Reader.SerializeIntPacked(MoveX);
+			Reader.SerializeIntPacked(MoveY);
+			CursorSteps += FIntPoint(FishingInputReplay::UnZigZag(MoveX), FishingInputReplay::UnZigZag(MoveY));
+			Cursor = FVector2D(CursorSteps) / FishingInputReplay::CursorSteps;
+		}
+		else if (FishingInput::IsAxis(Input))
+		{
+			Axes[Code - FishingInput::FirstAxis] = FishingInputReplay::ReadAxis(Reader);
+		}
+		else if (Code < (uint8)EFishingInput::Num)
+		{
+			Controller->ApplyInput(Input);
+		}
+	}
+	ReadOffset = Reader.Tell();
+	PendingEvents = 0;
+	++NumFrames;
+
+	// Axis bindings run every frame, recorded or not
+	for (uint8 Axis = 0; Axis < FishingInput::NumAxes; ++Axis)
+	{
+		Controller->ApplyInput((EFishingInput)(FishingInput::FirstAxis + Axis), Axes[Axis]);
+	}
+
+	if (Reader.IsError() || !ReadFrameHeader())
+	{
+		StopReplay();
+
+		if (FApp::IsUnattended())
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+}
+
+void UFishingInputReplaySubsystem::EndCsvCapture()
+{
+#if CSV_PROFILER
+	if (bCapturingCsv)
+	{
+		FCsvProfiler::Get()->EndCapture();
+		bCapturingCsv = false;
+	}
+#endif
+}
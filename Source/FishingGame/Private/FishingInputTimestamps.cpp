@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingInputTimestamps.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Input/Events.h"
+#include "Misc/App.h"
+
+bool FFishingInputTimestamps::HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent)
+{
+	// Held keys repeat, the press is the first one
+	if (!InKeyEvent.IsRepeat())
+	{
+		Stamp(InKeyEvent.GetKey(), true);
+	}
+	return false;
+}
+
+bool FFishingInputTimestamps::HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent)
+{
+	Stamp(InKeyEvent.GetKey(), false);
+	return false;
+}
+
+bool FFishingInputTimestamps::HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent)
+{
+	Stamp(MouseEvent.GetEffectingButton(), true);
+	return false;
+}
+
+bool FFishingInputTimestamps::HandleMouseButtonUpEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent)
+{
+	Stamp(MouseEvent.GetEffectingButton(), false);
+	return false;
+}
+
+bool FFishingInputTimestamps::HandleMouseButtonDoubleClickEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent)
+{
+	// The second press of a double click only comes as this
+	Stamp(MouseEvent.GetEffectingButton(), true);
+	return false;
+}
+
+double FFishingInputTimestamps::GetEventTime(const FKey& Key, bool bPressed) const
+{
+	const double* Time = (bPressed ? PressTimes : ReleaseTimes).Find(Key);
+	return Time ? *Time : 0.0;
+}
+
+double FFishingInputTimestamps::ToWorldTime(const UWorld* World, double PlatformTime)
+{
+	const double Now = World->GetTimeSeconds();
+	const AWorldSettings* WorldSettings = World->GetWorldSettings();
+	const float TimeDilation = World->IsPaused() ? 0.f : (WorldSettings ? WorldSettings->GetEffectiveTimeDilation() : 1.f);
+
+	// FApp's current time is the platform time this frame's world time was taken at
+	const double WorldTime = Now - (FApp::GetCurrentTime() - PlatformTime) * TimeDilation;
+	return FMath::Clamp(WorldTime, Now - World->GetDeltaSeconds(), Now);
+}
+
+void FFishingInputTimestamps::Stamp(const FKey& Key, bool bPressed)
+{
+	(bPressed ? PressTimes : ReleaseTimes).Add(Key, FPlatformTime::Seconds());
+}
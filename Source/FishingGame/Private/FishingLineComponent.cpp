@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingLineComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
+
+namespace FishingLine
+{
+	/** Screen size must clear a LOD's threshold by this fraction before the line moves up to it, so it doesn't flicker on the boundary. */
+	constexpr float LODHysteresis = 0.15f;
+
+	/** A line that has been out of sight for longer than this stops simulating. */
+	constexpr float RenderedTolerance = 0.2f;
+}
+
+double UFishingLineComponent::SolveSeconds = 0.0;
+int32 UFishingLineComponent::SimulatedLines = 0;
+int32 UFishingLineComponent::LODBias = 0;
+
+UFishingLineComponent::UFishingLineComponent()
+{
+	LODs.Add(FFishingLineLOD(0.25f, 10, 2));
+	LODs.Add(FFishingLineLOD(0.05f, 6, 1));
+	LODs.Add(FFishingLineLOD(0.f, 3, 1));
+}
+
+void UFishingLineComponent::OnRegister()
+{
+	if (!LODs.IsValidIndex(CurrentLOD) && LODs.Num() > 0)
+	{
+		CurrentLOD = 0;
+	}
+	if (LODs.IsValidIndex(CurrentLOD))
+	{
+		NumSegments = LODs[CurrentLOD].NumSegments;
+		SolverIterations = LODs[CurrentLOD].SolverIterations;
+	}
+
+	Super::OnRegister();
+
+	GetLineEndPoints(LastStart, LastEnd);
+	bLastAttachEnd = bAttachEnd;
+	StillTime = 0.f;
+	bSleeping = false;
+}
+
+void UFishingLineComponent::SetLineTension(const FVector& Force)
+{
+	CableForce += Force - Tension;
+	Tension = Force;
+	WakeLine();
+}
+
+void UFishingLineComponent::WakeLine()
+{
+	StillTime = 0.f;
+}
+
+void UFishingLineComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	FVector Start, End;
+	GetLineEndPoints(Start, End);
+
+	const bool bMoved = !Start.Equals(LastStart, SleepDistance) || (bAttachEnd && !End.Equals(LastEnd, SleepDistance)) || bAttachEnd != bLastAttachEnd || !Tension.IsNearlyZero();
+	LastStart = Start;
+	LastEnd = End;
+	bLastAttachEnd = bAttachEnd;
+	StillTime = bMoved ? 0.f : StillTime + DeltaTime;
+
+	float Distance = 0.f;
+	const float ScreenSize = GetScreenSize(Start, End, Distance);
+
+	if (StillTime >= SleepDelay || Distance > MaxSimulationDistance || !WasRecentlyRendered(FishingLine::RenderedTolerance))
+	{
+		// Skip the cable solver, but keep the culling bounds on the catenary so the line is drawn again as soon as it comes into view
+		if (!bSleeping || bMoved)
+		{
+			bSleeping = true;
+			UpdateBounds();
+			MarkRenderTransformDirty();
+		}
+		UMeshComponent::TickComponent(DeltaTime, TickType, ThisTickFunction);
+		return;
+	}
+
+	if (bSleeping)
+	{
+		bSleeping = false;
+		UpdateBounds();
+	}
+
+	int32 DesiredLOD = SelectLOD(ScreenSize);
+	if (DesiredLOD < CurrentLOD && SelectLOD(ScreenSize * (1.f - FishingLine::LODHysteresis)) >= CurrentLOD)
+	{
+		DesiredLOD = CurrentLOD;
+	}
+	if (DesiredLOD != CurrentLOD && LODs.IsValidIndex(DesiredLOD))
+	{
+		if (LODs[DesiredLOD].NumSegments == NumSegments)
+		{
+			CurrentLOD = DesiredLOD;
+			SolverIterations = LODs[CurrentLOD].SolverIterations;
+		}
+		else if (PendingLOD == INDEX_NONE)
+		{
+			// The cable sizes its particles and render buffers on register, so a new segment count has to wait for a re-register outside of our own tick
+			PendingLOD = DesiredLOD;
+			GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UFishingLineComponent::ApplyPendingLOD);
+		}
+	}
+
+	const double SolveStart = FPlatformTime::Seconds();
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	SolveSeconds += FPlatformTime::Seconds() - SolveStart;
+	++SimulatedLines;
+}
+
+void UFishingLineComponent::ApplyPendingLOD()
+{
+	if (LODs.IsValidIndex(PendingLOD))
+	{
+		CurrentLOD = PendingLOD;
+		if (IsRegistered())
+		{
+			ReregisterComponent();
+		}
+	}
+	PendingLOD = INDEX_NONE;
+}
+
+FBoxSphereBounds UFishingLineComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if (!bSleeping)
+	{
+		return Super::CalcBounds(LocalToWorld);
+	}
+
+	FBox LineBox(ForceInit);
+	LineBox += GetCatenaryLocation(0.f);
+	LineBox += GetCatenaryLocation(0.5f);
+	LineBox += GetCatenaryLocation(1.f);
+	return FBoxSphereBounds(LineBox.ExpandBy(CableWidth * 0.5f));
+}
+
+FVector UFishingLineComponent::GetCatenaryLocation(float Alpha) const
+{
+	FVector Start, End;
+	GetLineEndPoints(Start, End);
+
+	const float Chord = FVector::Dist(Start, End);
+	if (!bAttachEnd || Chord >= CableLength)
+	{
+		// A free end hangs straight down, a stretched line runs straight
+		return FMath::Lerp(Start, End, Alpha);
+	}
+
+	// Parabolic approximation of the catenary sag, which tends to half the length as the ends meet
+	const float Sag = FMath::Max(FMath::Sqrt(3.f * Chord * (CableLength - Chord) / 8.f), (CableLength - Chord) * 0.5f);
+	return FMath::Lerp(Start, End, Alpha) - FVector(0.f, 0.f, 4.f * Sag * Alpha * (1.f - Alpha));
+}
+
+void UFishingLineComponent::ConsumeSolveStats(double& OutSolveMs, int32& OutSimulatedLines)
+{
+	OutSolveMs = SolveSeconds * 1000.0;
+	OutSimulatedLines = SimulatedLines;
+	SolveSeconds = 0.0;
+	SimulatedLines = 0;
+}
+
+void UFishingLineComponent::GetLineEndPoints(FVector& OutStart, FVector& OutEnd) const
+{
+	OutStart = GetComponentLocation();
+
+	if (!bAttachEnd)
+	{
+		OutEnd = OutStart - FVector(0.f, 0.f, CableLength);
+		return;
+	}
+
+	// Same end point the cable solver uses
+	const USceneComponent* EndComponent = Cast<USceneComponent>(AttachEndTo.GetComponent(GetOwner()));
+	if (EndComponent == nullptr)
+	{
+		EndComponent = this;
+	}
+	OutEnd = AttachEndToSocketName != NAME_None
+		? EndComponent->GetSocketTransform(AttachEndToSocketName).TransformPosition(EndLocation)
+		: EndComponent->GetComponentTransform().TransformPosition(EndLocation);
+}
+
+float UFishingLineComponent::GetScreenSize(const FVector& Start, const FVector& End, float& OutDistance) const
+{
+	const FVector Center = (Start + End) * 0.5f;
+	const float Radius = FMath::Max(FVector::Dist(Start, End), CableLength) * 0.5f;
+
+	float ScreenSize = 0.f;
+	OutDistance = BIG_NUMBER;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		if (PC && PC->GetLocalPlayer() && PC->PlayerCameraManager)
+		{
+			const float Distance = FMath::Max(FVector::Dist(PC->PlayerCameraManager->GetCameraLocation(), Center), 1.f);
+			const float HalfFOVTan = FMath::Tan(FMath::DegreesToRadians(PC->PlayerCameraManager->GetFOVAngle() * 0.5f));
+			ScreenSize = FMath::Max(ScreenSize, Radius / (Distance * HalfFOVTan));
+			OutDistance = FMath::Min(OutDistance, Distance);
+		}
+	}
+	return ScreenSize;
+}
+
+int32 UFishingLineComponent::SelectLOD(float ScreenSize) const
+{
+	for (int32 LODIndex = 0; LODIndex < LODs.Num(); ++LODIndex)
+	{
+		if (ScreenSize >= LODs[LODIndex].MinScreenSize)
+		{
+			return FMath::Min(LODIndex + LODBias, LODs.Num() - 1);
+		}
+	}
+	return LODs.Num() - 1;
+}
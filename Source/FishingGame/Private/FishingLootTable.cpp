@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingLootTable.h"
+#include "FishingGame.h"
+#include "FishingZone.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+float FFishSpeciesRow::GetWeightAt(float Hour) const
+{
+	float Scaled = Weight;
+	for (const FFishSpeciesTimeWindow& Window : TimeWindows)
+	{
+		if (Window.Contains(Hour))
+		{
+			Scaled *= Window.WeightScale;
+		}
+	}
+	return Scaled;
+}
+
+void FFishingAliasTable::Build(TArrayView<const float> Weights)
+{
+	Probability.Reset();
+	Alias.Reset();
+
+	const int32 Num = Weights.Num();
+	double Total = 0.0;
+	for (float Weight : Weights)
+	{
+		Total += FMath::Max(Weight, 0.f);
+	}
+	if (Num == 0 || Total <= 0.0)
+	{
+		return;
+	}
+
+	Probability.SetNumUninitialized(Num);
+	Alias.SetNumUninitialized(Num);
+
+	// Scale so the average column holds exactly 1, then let every underfull column borrow the rest from an overfull one
+	TArray<double> Scaled;
+	Scaled.SetNumUninitialized(Num);
+	TArray<int32> Small;
+	TArray<int32> Large;
+	Small.Reserve(Num);
+	Large.Reserve(Num);
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		Scaled[Index] = FMath::Max(Weights[Index], 0.f) * Num / Total;
+		Alias[Index] = Index;
+		(Scaled[Index] < 1.0 ? Small : Large).Add(Index);
+	}
+
+	while (Small.Num() > 0 && Large.Num() > 0)
+	{
+		const int32 Less = Small.Pop(false);
+		const int32 More = Large.Pop(false);
+
+		Probability[Less] = (float)Scaled[Less];
+		Alias[Less] = More;
+
+		Scaled[More] = (Scaled[More] + Scaled[Less]) - 1.0;
+		(Scaled[More] < 1.0 ? Small : Large).Add(More);
+	}
+
+	// Whatever is left is full up to rounding error
+	for (int32 Index : Large)
+	{
+		Probability[Index] = 1.f;
+	}
+	for (int32 Index : Small)
+	{
+		Probability[Index] = 1.f;
+	}
+}
+
+void UFishingLootSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Random.GenerateNewSeed();
+}
+
+void UFishingLootSubsystem::Deinitialize()
+{
+	Tables.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFishingLootSubsystem::PrepareTable(const UDataTable* Table)
+{
+	if (!Table || Tables.Contains(Table))
+	{
+		return;
+	}
+
+	if (Table->GetRowStruct() == nullptr || !Table->GetRowStruct()->IsChildOf(FFishSpeciesRow::StaticStruct()))
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Loot table %s doesn't use FishSpeciesRow rows, ignoring it"), *Table->GetName());
+		return;
+	}
+
+	FCompiledTable& Compiled = Tables.Add(Table);
+	Table->ForeachRow<FFishSpeciesRow>(TEXT("UFishingLootSubsystem::PrepareTable"), [&Compiled](const FName& RowName, const FFishSpeciesRow& Row)
+	{
+		Compiled.RowBySpecies.Add(Row.SpeciesId, Compiled.Rows.Num());
+		Compiled.Rows.Add(Row);
+	});
+
+	BuildAlias(Compiled);
+}
+
+void UFishingLootSubsystem::BuildAlias(FCompiledTable& Compiled)
+{
+	TArray<float> Weights;
+	Weights.Reserve(Compiled.Rows.Num());
+	for (const FFishSpeciesRow& Row : Compiled.Rows)
+	{
+		Weights.Add(Row.GetWeightAt(TimeOfDay));
+	}
+
+	Compiled.Alias.Build(Weights);
+	GetOpenWindows(Compiled, Compiled.OpenWindows);
+	++NumCompiles;
+}
+
+void UFishingLootSubsystem::GetOpenWindows(const FCompiledTable& Compiled, TBitArray<>& OutOpen) const
+{
+	OutOpen.Empty();
+	for (const FFishSpeciesRow& Row : Compiled.Rows)
+	{
+		for (const FFishSpeciesTimeWindow& Window : Row.TimeWindows)
+		{
+			OutOpen.Add(Window.Contains(TimeOfDay));
+		}
+	}
+}
+
+void UFishingLootSubsystem::SetTimeOfDay(float Hours)
+{
+	TimeOfDay = FMath::Fmod(FMath::Fmod(Hours, 24.f) + 24.f, 24.f);
+
+	TBitArray<> OpenWindows;
+	for (TPair<TObjectKey<UDataTable>, FCompiledTable>& Table : Tables)
+	{
+		FCompiledTable& Compiled = Table.Value;
+		if (Compiled.OpenWindows.Num() == 0)
+		{
+			continue;
+		}
+
+		GetOpenWindows(Compiled, OpenWindows);
+		if (OpenWindows != Compiled.OpenWindows)
+		{
+			BuildAlias(Compiled);
+		}
+	}
+}
+
+const UFishingLootSubsystem::FCompiledTable* UFishingLootSubsystem::FindTable(const AFishingZone* Zone)
+{
+	const UDataTable* Table = Zone ? Zone->GetLootTable() : nullptr;
+	if (!Table)
+	{
+		return nullptr;
+	}
+
+	PrepareTable(Table);
+	return Tables.Find(Table);
+}
+
+bool UFishingLootSubsystem::Roll(const AFishingZone* Zone, FFishingLootRoll& OutRoll)
+{
+	return Roll(Zone, Random, OutRoll);
+}
+
+bool UFishingLootSubsystem::Roll(const AFishingZone* Zone, FRandomStream& InRandom, FFishingLootRoll& OutRoll)
+{
+	const FCompiledTable* Compiled = FindTable(Zone);
+	const int32 Row = Compiled ? Compiled->Alias.Sample(InRandom) : INDEX_NONE;
+	if (Row == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FFishSpeciesRow& Species = Compiled->Rows[Row];
+	OutRoll.SpeciesId = Species.SpeciesId;
+	OutRoll.Size = Species.SampleSize(InRandom.GetFraction());
+	OutRoll.BiteWaitScale = Species.BiteWaitScale;
+	return true;
+}
+
+bool UFishingLootSubsystem::RollSize(const AFishingZone* Zone, int32 SpeciesId, FFishingLootRoll& OutRoll)
+{
+	const FCompiledTable* Compiled = FindTable(Zone);
+	const int32* Row = Compiled ? Compiled->RowBySpecies.Find(SpeciesId) : nullptr;
+	if (!Row)
+	{
+		return false;
+	}
+
+	const FFishSpeciesRow& Species = Compiled->Rows[*Row];
+	OutRoll.SpeciesId = SpeciesId;
+	OutRoll.Size = Species.SampleSize(Random.GetFraction());
+	OutRoll.BiteWaitScale = Species.BiteWaitScale;
+	return true;
+}
+
+namespace FishingLoot
+{
+	static FAutoConsoleCommandWithWorldAndArgs TimeOfDayCommand(
+		TEXT("Fishing.TimeOfDay"),
+		TEXT("Sets the hour loot tables are weighted for. Usage: Fishing.TimeOfDay <Hours>"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingLootSubsystem* Loot = World ? World->GetSubsystem<UFishingLootSubsystem>() : nullptr;
+			if (Loot && Args.Num() > 0)
+			{
+				const int32 CompilesBefore = Loot->GetNumCompiles();
+				Loot->SetTimeOfDay(FCString::Atof(*Args[0]));
+				UE_LOG(LogFishingGame, Display, TEXT("Loot time of day %.2f, %d tables recompiled"), Loot->GetTimeOfDay(), Loot->GetNumCompiles() - CompilesBefore);
+			}
+		}));
+
+	static FAutoConsoleCommand BenchCommand(
+		TEXT("Fishing.LootBench"),
+		TEXT("Samples a random alias table and checks the results against its weights. Usage: Fishing.LootBench [Species=10000] [Samples=10000000]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumSpecies = FMath::Max(2, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000);
+			const int32 NumSamples = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000000);
+
+			// Skewed weights, so rare species are exercised as well as common ones
+			FRandomStream Random(0x5EED);
+			TArray<float> Weights;
+			double TotalWeight = 0.0;
+			for (int32 Index = 0; Index < NumSpecies; ++Index)
+			{
+				Weights.Add(FMath::Cube(Random.FRandRange(0.2f, 1.f)));
+				TotalWeight += Weights.Last();
+			}
+
+			FFishingAliasTable Table;
+			const double BuildStart = FPlatformTime::Seconds();
+			Table.Build(Weights);
+			const double BuildMs = (FPlatformTime::Seconds() - BuildStart) * 1000.0;
+
+			TArray<int32> Counts;
+			Counts.SetNumZeroed(NumSpecies);
+			const double SampleStart = FPlatformTime::Seconds();
+			for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+			{
+				++Counts[Table.Sample(Random)];
+			}
+			const double SampleNs = (FPlatformTime::Seconds() - SampleStart) * 1e9 / NumSamples;
+
+			// Pearson's chi-square against the authored weights, z-scored for NumSpecies - 1 degrees of freedom
+			double ChiSquare = 0.0;
+			for (int32 Index = 0; Index < NumSpecies; ++Index)
+			{
+				const double Expected = NumSamples * Weights[Index] / TotalWeight;
+				ChiSquare += FMath::Square(Counts[Index] - Expected) / Expected;
+			}
+			const double Dof = NumSpecies - 1;
+			const double Z = (ChiSquare - Dof) / FMath::Sqrt(2.0 * Dof);
+
+			UE_LOG(LogFishingGame, Display, TEXT("Loot bench: %d species, %d samples, build %.2f ms, %.1f ns per sample, chi-square %.0f for %.0f dof (z %.2f): %s"),
+				NumSpecies, NumSamples, BuildMs, SampleNs, ChiSquare, Dof, Z, FMath::Abs(Z) < 5.0 ? TEXT("matches weights") : TEXT("DOES NOT MATCH WEIGHTS"));
+		}));
+}
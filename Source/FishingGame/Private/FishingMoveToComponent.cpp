@@ -0,0 +1,370 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingMoveToComponent.h"
+#include "FishingGame.h"
+#include "FishingInputReplay.h"
+#include "AITypes.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationSystem.h"
+
+namespace FishingMoveTo
+{
+	/** Frame rate the benchmark feeds goals at, as if the mouse button was held that long. */
+	constexpr float BenchFrameRate = 60.f;
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.PathBench"),
+		TEXT("Compares a path query per frame of held click with the throttled path updates, from the local pawn. Usage: Fishing.PathBench [HeldSeconds=10] [Radius=1500]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World)
+			{
+				return;
+			}
+
+			const float HeldSeconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.f;
+			const float Radius = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1500.f;
+			for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+			{
+				const APlayerController* Controller = It->Get();
+				UFishingMoveToComponent* MoveTo = Controller && Controller->IsLocalController() ? Controller->FindComponentByClass<UFishingMoveToComponent>() : nullptr;
+				if (MoveTo)
+				{
+					MoveTo->RunBenchmark(HeldSeconds, Radius);
+					return;
+				}
+			}
+			UE_LOG(LogFishingGame, Warning, TEXT("Fishing path bench: no local player controller moves with a UFishingMoveToComponent"));
+		}));
+}
+
+UFishingMoveToComponent::UFishingMoveToComponent()
+{
+	// Only ticks while a goal waits for its query
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	QueryDelegate.BindUObject(this, &UFishingMoveToComponent::OnQueryDone);
+}
+
+void UFishingMoveToComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopMove();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFishingMoveToComponent::MoveTo(const FVector& Goal)
+{
+	FISHING_SCOPE(MoveTo);
+
+	UPathFollowingComponent* PathFollowing = GetPathFollowing();
+	if (!PathFollowing)
+	{
+		return;
+	}
+
+	const bool bQueryInFlight = QueryId != INVALID_NAVQUERYID;
+	const bool bMoving = bHasMoveGoal && (bQueryInFlight || PathFollowing->GetStatus() == EPathFollowingStatus::Moving);
+	const bool bCanQuery = !bQueryInFlight && GetWorld()->GetTimeSeconds() - LastQueryTime >= MinQueryInterval;
+
+	EGoalUpdate Update = ClassifyGoal(Goal, MoveGoal, bMoving, bCanQuery);
+	if (Update == EGoalUpdate::Patch)
+	{
+		// The path of a query in flight isn't there to patch yet, the goal waits for it instead
+		FNavigationPath* Path = bQueryInFlight ? nullptr : PathFollowing->GetPath().Get();
+		if (Path && PatchPath(*Path, Goal))
+		{
+			MoveGoal = Goal;
+			bHasPendingGoal = false;
+			return;
+		}
+		Update = bCanQuery ? EGoalUpdate::Query : EGoalUpdate::Defer;
+	}
+
+	switch (Update)
+	{
+	case EGoalUpdate::Keep:
+		bHasPendingGoal = false;
+		break;
+	case EGoalUpdate::Query:
+		bHasPendingGoal = false;
+		StartQuery(Goal);
+		break;
+	default:
+		PendingGoal = Goal;
+		bHasPendingGoal = true;
+		SetComponentTickEnabled(true);
+		break;
+	}
+}
+
+void UFishingMoveToComponent::StopMove()
+{
+	if (QueryId != INVALID_NAVQUERYID)
+	{
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->AbortAsyncFindPathRequest(QueryId);
+		}
+		QueryId = INVALID_NAVQUERYID;
+	}
+
+	bHasMoveGoal = false;
+	bHasPendingGoal = false;
+	SetComponentTickEnabled(false);
+}
+
+void UFishingMoveToComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Sends the latest goal once it may be queried, even after the mouse button was let go
+	if (!bHasPendingGoal)
+	{
+		SetComponentTickEnabled(false);
+	}
+	else if (QueryId == INVALID_NAVQUERYID && GetWorld()->GetTimeSeconds() - LastQueryTime >= MinQueryInterval)
+	{
+		bHasPendingGoal = false;
+		SetComponentTickEnabled(false);
+		MoveTo(PendingGoal);
+	}
+}
+
+UFishingMoveToComponent::EGoalUpdate UFishingMoveToComponent::ClassifyGoal(const FVector& Goal, const FVector& CurrentGoal, bool bMoving, bool bCanQuery) const
+{
+	if (bMoving)
+	{
+		const float DistanceSquared = FVector::DistSquared(Goal, CurrentGoal);
+		if (DistanceSquared < FMath::Square(KeepDistance))
+		{
+			return EGoalUpdate::Keep;
+		}
+		if (DistanceSquared < FMath::Square(PatchDistance))
+		{
+			return EGoalUpdate::Patch;
+		}
+	}
+	return bCanQuery ? EGoalUpdate::Query : EGoalUpdate::Defer;
+}
+
+bool UFishingMoveToComponent::PatchPath(FNavigationPath& Path, const FVector& Goal) const
+{
+	TArray<FNavPathPoint>& Points = Path.GetPathPoints();
+	const ANavigationData* NavData = Path.GetNavigationDataUsed();
+	if (Points.Num() < 2 || !NavData)
+	{
+		return false;
+	}
+
+	FNavLocation GoalOnNavMesh;
+	if (!NavData->ProjectPoint(Goal, GoalOnNavMesh, NavData->GetDefaultQueryExtent(), Path.GetFilter(), GetOwner()))
+	{
+		return false;
+	}
+
+	// The last leg is a straight line on the navmesh, so it can swing to the new goal as long as nothing blocks the way from its start
+	const FVector LegStart = Points[Points.Num() - 2].Location;
+	FVector HitLocation;
+	if (NavData->Raycast(LegStart, GoalOnNavMesh.Location, HitLocation, Path.GetFilter(), GetOwner()))
+	{
+		return false;
+	}
+
+	Points.Last() = FNavPathPoint(GoalOnNavMesh.Location, GoalOnNavMesh.NodeRef);
+
+	// Path following picks the moved end up from here
+	Path.DoneUpdating(ENavPathUpdateType::GoalMoved);
+	return true;
+}
+
+void UFishingMoveToComponent::StartQuery(const FVector& Goal)
+{
+	UWorld* World = GetWorld();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	FPathFindingQuery Query;
+	if (!NavSys || !MakeQuery(Goal, Query))
+	{
+		return;
+	}
+
+	MoveGoal = Goal;
+	bHasMoveGoal = true;
+	LastQueryTime = World->GetTimeSeconds();
+
+	// Replays answer on the spot, so the pawn sets off on the same frame every run
+	const UFishingInputReplaySubsystem* InputReplay = World->GetSubsystem<UFishingInputReplaySubsystem>();
+	if (InputReplay && InputReplay->IsReplaying())
+	{
+		const FPathFindingResult Result = NavSys->FindPathSync(Query);
+		OnQueryDone(INVALID_NAVQUERYID, Result.Result, Result.Path);
+		return;
+	}
+
+	QueryId = NavSys->FindPathAsync(GetPawn()->GetNavAgentPropertiesRef(), Query, QueryDelegate);
+}
+
+void UFishingMoveToComponent::OnQueryDone(uint32 InQueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	// Stopped or superseded meanwhile
+	if (InQueryId != QueryId)
+	{
+		return;
+	}
+	QueryId = INVALID_NAVQUERYID;
+
+	UPathFollowingComponent* PathFollowing = GetPathFollowing();
+	if (!PathFollowing || !GetPawn())
+	{
+		return;
+	}
+
+	if (Result != ENavigationQueryResult::Success || !Path.IsValid())
+	{
+		bHasMoveGoal = false;
+		if (PathFollowing->GetStatus() != EPathFollowingStatus::Idle)
+		{
+			PathFollowing->RequestMoveWithImmediateFinish(EPathFollowingResult::Invalid);
+		}
+		return;
+	}
+
+	// One move at a time, as SimpleMoveToLocation does, keeping the pawn's speed into the new path
+	if (PathFollowing->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		PathFollowing->AbortMove(*this, FPathFollowingResultFlags::ForcedScript | FPathFollowingResultFlags::NewRequest,
+			FAIRequestID::AnyRequest, EPathFollowingVelocityMode::Keep);
+	}
+	PathFollowing->RequestMove(FAIMoveRequest(MoveGoal), Path);
+}
+
+bool UFishingMoveToComponent::MakeQuery(const FVector& Goal, FPathFindingQuery& OutQuery) const
+{
+	const APawn* Pawn = GetPawn();
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = Pawn && NavSys ? NavSys->GetNavDataForProps(Pawn->GetNavAgentPropertiesRef(), Pawn->GetNavAgentLocation()) : nullptr;
+	if (!NavData)
+	{
+		return false;
+	}
+
+	OutQuery = FPathFindingQuery(GetOwner(), *NavData, Pawn->GetNavAgentLocation(), Goal, UNavigationQueryFilter::GetQueryFilter(*NavData, GetOwner(), nullptr));
+	return true;
+}
+
+APawn* UFishingMoveToComponent::GetPawn() const
+{
+	const AController* Controller = Cast<AController>(GetOwner());
+	return Controller ? Controller->GetPawn() : nullptr;
+}
+
+UPathFollowingComponent* UFishingMoveToComponent::GetPathFollowing() const
+{
+	return GetOwner() ? GetOwner()->FindComponentByClass<UPathFollowingComponent>() : nullptr;
+}
+
+void UFishingMoveToComponent::RunBenchmark(float HeldSeconds, float Radius)
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const APawn* Pawn = GetPawn();
+	FPathFindingQuery Query;
+	if (!NavSys || !Pawn || !MakeQuery(Pawn->GetNavAgentLocation(), Query))
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing path bench: the local pawn isn't on a navmesh"));
+		return;
+	}
+
+	const FVector Start = Query.StartLocation;
+	const int32 NumFrames = FMath::Max(1, FMath::RoundToInt(HeldSeconds * FishingMoveTo::BenchFrameRate));
+	const float DeltaTime = 1.f / FishingMoveTo::BenchFrameRate;
+
+	// The cursor circles the pawn while drifting in and out, like dragging the destination around the screen
+	auto GoalAt = [&Start, Radius, DeltaTime](int32 Frame)
+	{
+		const float Time = Frame * DeltaTime;
+		const float Distance = Radius * (0.6f + 0.4f * FMath::Sin(Time * 0.7f));
+		return Start + FVector(FMath::Cos(Time * 1.3f), FMath::Sin(Time * 1.3f), 0.f) * Distance;
+	};
+
+	// What SimpleMoveToLocation did: a synchronous query every frame
+	double PerFrameSeconds = 0.0;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		Query.EndLocation = GoalAt(Frame);
+		const double QueryStart = FPlatformTime::Seconds();
+		NavSys->FindPathSync(Query);
+		PerFrameSeconds += FPlatformTime::Seconds() - QueryStart;
+	}
+
+	// The same goals through the throttled updates. Queries run synchronously here to be timed, live they run on the navigation
+	// system's async worker and cost the game thread nothing; a goal deferred by the interval is superseded by the next frame's
+	FNavPathSharedPtr Path;
+	FVector CurrentGoal = FVector::ZeroVector;
+	float LastBenchQueryTime = -BIG_NUMBER;
+	int32 NumQueries = 0;
+	int32 NumPatches = 0;
+	int32 NumKept = 0;
+	int32 NumDeferred = 0;
+	double QuerySeconds = 0.0;
+	double GameThreadSeconds = 0.0;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const FVector Goal = GoalAt(Frame);
+		const float Now = Frame * DeltaTime;
+		const bool bCanQuery = Now - LastBenchQueryTime >= MinQueryInterval;
+
+		const double UpdateStart = FPlatformTime::Seconds();
+		EGoalUpdate Update = ClassifyGoal(Goal, CurrentGoal, Path.IsValid(), bCanQuery);
+		if (Update == EGoalUpdate::Patch)
+		{
+			if (PatchPath(*Path, Goal))
+			{
+				CurrentGoal = Goal;
+				++NumPatches;
+			}
+			else
+			{
+				Update = bCanQuery ? EGoalUpdate::Query : EGoalUpdate::Defer;
+			}
+		}
+		GameThreadSeconds += FPlatformTime::Seconds() - UpdateStart;
+
+		if (Update == EGoalUpdate::Keep)
+		{
+			++NumKept;
+		}
+		else if (Update == EGoalUpdate::Defer)
+		{
+			++NumDeferred;
+		}
+		else if (Update == EGoalUpdate::Query)
+		{
+			Query.EndLocation = Goal;
+			const double QueryStart = FPlatformTime::Seconds();
+			const FPathFindingResult Result = NavSys->FindPathSync(Query);
+			QuerySeconds += FPlatformTime::Seconds() - QueryStart;
+
+			Path = Result.IsSuccessful() ? Result.Path : FNavPathSharedPtr();
+			CurrentGoal = Goal;
+			LastBenchQueryTime = Now;
+			++NumQueries;
+		}
+	}
+
+	const float Held = NumFrames * DeltaTime;
+	UE_LOG(LogFishingGame, Log, TEXT("Fishing path bench: %s, %.1f s held at %.0f Hz, goals up to %.0f cm away"),
+		*GetWorld()->GetMapName(), Held, FishingMoveTo::BenchFrameRate, Radius);
+	UE_LOG(LogFishingGame, Log, TEXT("  query per frame: %d queries, %.3f ms per second held on the game thread"),
+		NumFrames, PerFrameSeconds * 1000.0 / Held);
+	UE_LOG(LogFishingGame, Log, TEXT("  throttled: %d queries (%.3f ms per second held, off the game thread), %d patches, %d kept, %d deferred, %.3f ms per second held on the game thread"),
+		NumQueries, QuerySeconds * 1000.0 / Held, NumPatches, NumKept, NumDeferred, GameThreadSeconds * 1000.0 / Held);
+}
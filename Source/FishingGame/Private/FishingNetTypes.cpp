@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingNetTypes.h"
+
+const TCHAR* FishingNet::GetPhaseName(EFishingPhase Phase)
+{
+	switch (Phase)
+	{
+	case EFishingPhase::Idle:			return TEXT("Idle");
+	case EFishingPhase::Charging:		return TEXT("Charging");
+	case EFishingPhase::Casting:		return TEXT("Casting");
+	case EFishingPhase::HookInFlight:	return TEXT("HookInFlight");
+	case EFishingPhase::Fishing:		return TEXT("Fishing");
+	case EFishingPhase::Biting:			return TEXT("Biting");
+	case EFishingPhase::Reeling:		return TEXT("Reeling");
+	default:							return TEXT("Unknown");
+	}
+}
+
+bool FFishingNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PhaseBits = (uint32)Phase;
+	Ar.SerializeBits(&PhaseBits, 3);
+
+	uint8 FishOnHookBit = bFishOnHook ? 1 : 0;
+	Ar.SerializeBits(&FishOnHookBit, 1);
+
+	Ar << CastPower;
+
+	// Centiseconds are plenty to line up animation and the casting bar, and pack to three bytes for the first few hours of a session
+	uint32 StartCentiseconds = (uint32)FMath::Max(0, FMath::RoundToInt(PhaseStartTime * 100.f));
+	Ar.SerializeIntPacked(StartCentiseconds);
+
+	uint32 SpeciesValue = FishOnHookBit ? Species : 0;
+	if (FishOnHookBit)
+	{
+		Ar.SerializeIntPacked(SpeciesValue);
+	}
+
+	if (Ar.IsLoading())
+	{
+		Phase = (EFishingPhase)FMath::Min<uint32>(PhaseBits, (uint32)EFishingPhase::Reeling);
+		bFishOnHook = FishOnHookBit != 0;
+		PhaseStartTime = StartCentiseconds / 100.f;
+		Species = (uint16)FMath::Min<uint32>(SpeciesValue, MAX_uint16);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
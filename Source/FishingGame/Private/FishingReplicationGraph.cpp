@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingReplicationGraph.h"
+#include "FishingGame.h"
+#include "FishingGameCharacter.h"
+#include "FishingZone.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace FishingReplication
+{
+	static FAutoConsoleCommandWithWorldAndArgs NetReportCommand(
+		TEXT("Fishing.NetReport"),
+		TEXT("On a server running the fishing replication graph, logs the time spent replicating per net tick and the outgoing bandwidth over the next Seconds. Usage: Fishing.NetReport [Seconds=10]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+			UFishingReplicationGraph* Graph = NetDriver ? Cast<UFishingReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+			if (!Graph)
+			{
+				UE_LOG(LogFishingGame, Warning, TEXT("Fishing net report: no fishing replication graph on this world, \"stat net\" covers the default replication path"));
+				return;
+			}
+			Graph->StartReport(Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 1.f) : 10.f);
+		}));
+}
+
+void UFishingReplicationGraphNode_AnglerFrequency::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	if (!Buckets || Buckets->Num() == 0 || (Params.ReplicationFrameNum + Offset) % RefreshPeriod != 0)
+	{
+		return;
+	}
+
+	// Only the anglers the grid already gathered for this connection, the rest don't replicate to it anyway
+	for (const auto& List : Params.OutGatheredReplicationLists.GetLists(EActorRepListTypeFlags::Default))
+	{
+		for (int32 Index = 0; Index < List.Num(); ++Index)
+		{
+			AActor* Actor = List[Index];
+			if (!Actor->IsA<AFishingGameCharacter>())
+			{
+				continue;
+			}
+
+			const FVector Location = Actor->GetActorLocation();
+			float DistSquared = MAX_flt;
+			for (const FNetViewer& Viewer : Params.Viewers)
+			{
+				DistSquared = FMath::Min(DistSquared, FVector::DistSquared(Viewer.ViewLocation, Location));
+			}
+
+			int32 Period = Buckets->Last().ReplicationPeriodFrame;
+			for (const FFishingReplicationBucket& Bucket : *Buckets)
+			{
+				if (DistSquared <= FMath::Square(Bucket.Distance))
+				{
+					Period = Bucket.ReplicationPeriodFrame;
+					break;
+				}
+			}
+
+			// Takes effect from the angler's next replication to this connection
+			Params.ConnectionManager.ActorInfoMap.FindOrAdd(Actor).ReplicationPeriodFrame = (uint16)FMath::Clamp(Period, 1, (int32)MAX_uint16);
+		}
+	}
+}
+
+UFishingReplicationGraph::UFishingReplicationGraph()
+{
+	Buckets.SetNum(3);
+	Buckets[0].Distance = 3000.f;
+	Buckets[0].ReplicationPeriodFrame = 1;
+	Buckets[1].Distance = 8000.f;
+	Buckets[1].ReplicationPeriodFrame = 2;
+	Buckets[2].Distance = 15000.f;
+	Buckets[2].ReplicationPeriodFrame = 4;
+}
+
+void UFishingReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	FClassReplicationInfo AnglerInfo;
+	AnglerInfo.SetCullDistanceSquared(FMath::Square(AnglerCullDistance));
+	AnglerInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(GetDefault<AFishingGameCharacter>()->NetUpdateFrequency);
+	GlobalActorReplicationInfoMap.SetClassInfo(AFishingGameCharacter::StaticClass(), AnglerInfo);
+}
+
+void UFishingReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+}
+
+void UFishingReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	UFishingReplicationGraphNode_AnglerFrequency* FrequencyNode = CreateNewNode<UFishingReplicationGraphNode_AnglerFrequency>();
+	FrequencyNode->Buckets = &Buckets;
+	FrequencyNode->RefreshPeriod = (uint32)FMath::Max(BucketRefreshPeriod, 1);
+	FrequencyNode->Offset = NumConnectionNodes++;
+	AddConnectionGraphNode(FrequencyNode, ConnectionManager);
+}
+
+void UFishingReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	// Zones carry state the whole lake shares, wherever the viewer is
+	if (ActorInfo.Actor->IsA<AFishingZone>())
+	{
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		return;
+	}
+
+	Super::RouteAddNetworkActorToNodes(ActorInfo, GlobalInfo);
+
+	if (ActorInfo.Actor->IsA<AFishingGameCharacter>())
+	{
+		++NumAnglers;
+	}
+}
+
+void UFishingReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (ActorInfo.Actor->IsA<AFishingZone>())
+	{
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		return;
+	}
+
+	Super::RouteRemoveNetworkActorToNodes(ActorInfo);
+
+	if (ActorInfo.Actor->IsA<AFishingGameCharacter>())
+	{
+		--NumAnglers;
+	}
+}
+
+int32 UFishingReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	FISHING_SCOPE(Replication);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+
+	if (Report.IsSet())
+	{
+		const double Now = FPlatformTime::Seconds();
+		const double TickMs = (Now - StartTime) * 1000.0;
+		++Report->NetTicks;
+		Report->TotalMs += TickMs;
+		Report->PeakMs = FMath::Max(Report->PeakMs, TickMs);
+		if (Now >= Report->EndTime)
+		{
+			FinishReport();
+		}
+	}
+
+	return NumReplicated;
+}
+
+void UFishingReplicationGraph::StartReport(float Seconds)
+{
+	Report.Emplace();
+	Report->StartTime = FPlatformTime::Seconds();
+	Report->EndTime = Report->StartTime + Seconds;
+	Report->StartOutBytes = NetDriver ? NetDriver->OutTotalBytes : 0;
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing net report: measuring %.0f s over %d connections and %d anglers"), Seconds, Connections.Num(), NumAnglers);
+}
+
+void UFishingReplicationGraph::FinishReport()
+{
+	const double Elapsed = FMath::Max(FPlatformTime::Seconds() - Report->StartTime, 0.001);
+	const uint32 OutBytes = NetDriver ? NetDriver->OutTotalBytes - Report->StartOutBytes : 0;
+	const int32 NetTicks = FMath::Max(Report->NetTicks, 1);
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing net report: %d net ticks in %.1f s, replicating took %.3f ms avg, %.3f ms peak per net tick"),
+		Report->NetTicks, Elapsed, Report->TotalMs / NetTicks, Report->PeakMs);
+	UE_LOG(LogFishingGame, Display, TEXT("  %.1f KB/s out to %d connections (%.2f KB/s each), %d anglers"),
+		OutBytes / 1024.0 / Elapsed, Connections.Num(), OutBytes / 1024.0 / Elapsed / FMath::Max(Connections.Num(), 1), NumAnglers);
+
+	Report.Reset();
+}
@@ -0,0 +1,410 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingScalabilitySubsystem.h"
+#include "FishingGame.h"
+#include "FishingLineComponent.h"
+#include "Components/MeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Misc/App.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+namespace FishingScalability
+{
+	static const TCHAR* LakeMaterialDir = TEXT("/Game/CartoonWaterShader/Materials/Water/Lake/");
+
+	static FSoftObjectPath LakeMaterial(const TCHAR* Name)
+	{
+		return FSoftObjectPath(FString::Printf(TEXT("%s%s.%s"), LakeMaterialDir, Name, Name));
+	}
+
+	static IConsoleVariable* FoliageDensityScale()
+	{
+		static IConsoleVariable* const Variable = IConsoleManager::Get().FindConsoleVariable(TEXT("foliage.DensityScale"));
+		return Variable;
+	}
+
+	static IConsoleVariable* GrassDensityScale()
+	{
+		static IConsoleVariable* const Variable = IConsoleManager::Get().FindConsoleVariable(TEXT("grass.DensityScale"));
+		return Variable;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs GovernorCommand(
+		TEXT("Fishing.Governor"),
+		TEXT("Pins the scalability tier, or hands it back to the frame time governor with -1. Usage: Fishing.Governor <Tier | -1>"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingScalabilitySubsystem* Scalability = World ? World->GetSubsystem<UFishingScalabilitySubsystem>() : nullptr;
+			if (Scalability && Args.Num() > 0)
+			{
+				Scalability->ForceTier(FCString::Atoi(*Args[0]));
+			}
+		}));
+
+	/** Tier changes of a governor sim scenario, with the time each happened at. */
+	struct FScenarioResult
+	{
+		TArray<TPair<int32, float>> Changes;
+		int32 StartTier = 0;
+		int32 LowestTier = 0;
+
+		int32 GetFinalTier() const { return Changes.Num() > 0 ? Changes.Last().Key : StartTier; }
+
+		int32 GetNumUpgrades() const
+		{
+			int32 NumUpgrades = 0;
+			for (int32 Index = 0; Index < Changes.Num(); ++Index)
+			{
+				NumUpgrades += Changes[Index].Key > (Index > 0 ? Changes[Index - 1].Key : StartTier);
+			}
+			return NumUpgrades;
+		}
+	};
+
+	/**
+	 * Runs the governor through synthetic frames, each as long as it costs, FrameMs(Time, Tier), logs the tiers it went through
+	 * and checks them with Expect.
+	 */
+	static bool RunScenario(const TCHAR* Name, const FFishingFrameGovernor::FSettings& Settings, int32 NumTiers, float Seconds, TFunctionRef<float(float, int32)> FrameMs,
+		TFunctionRef<bool(const FScenarioResult&)> Expect)
+	{
+		FFishingFrameGovernor Governor;
+		Governor.Reset(Settings, NumTiers, NumTiers - 1);
+
+		FScenarioResult Result;
+		Result.StartTier = Result.LowestTier = Governor.GetTier();
+		FString Path = FString::FromInt(Governor.GetTier());
+		for (float Time = 0.f; Time < Seconds;)
+		{
+			const float Frame = FrameMs(Time, Governor.GetTier());
+			Time += Frame / 1000.f;
+			if (Governor.AddFrame(Frame, Frame / 1000.f))
+			{
+				Result.Changes.Emplace(Governor.GetTier(), Time);
+				Result.LowestTier = FMath::Min(Result.LowestTier, Governor.GetTier());
+				Path += FString::Printf(TEXT(" %d@%.1fs"), Governor.GetTier(), Time);
+			}
+		}
+
+		const bool bPassed = Expect(Result);
+		UE_LOG(LogFishingGame, Display, TEXT("Fishing governor sim: %-10s %2d changes, tiers %s: %s"), Name, Result.Changes.Num(), *Path, bPassed ? TEXT("as expected") : TEXT("UNEXPECTED"));
+		return bPassed;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs GovernorSimCommand(
+		TEXT("Fishing.GovernorSim"),
+		TEXT("Feeds synthetic frame times through the scalability governor with this world's settings and checks the tiers it picks."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const UFishingScalabilitySubsystem* Scalability = World ? World->GetSubsystem<UFishingScalabilitySubsystem>() : nullptr;
+			const UFishingScalabilitySubsystem* Defaults = GetDefault<UFishingScalabilitySubsystem>();
+			const FFishingFrameGovernor::FSettings Settings = (Scalability ? Scalability : Defaults)->GetGovernorSettings();
+			const int32 NumTiers = (Scalability ? Scalability : Defaults)->Tiers.Num();
+			const float Target = Settings.TargetFrameMs;
+			const int32 TopTier = NumTiers - 1;
+
+			bool bPassed = true;
+
+			// Each tier down saves a fifth of the top tier's cost, so it settles three tiers down, at exactly the budget
+			bPassed &= RunScenario(TEXT("heavy"), Settings, NumTiers, 30.f, [Target, TopTier](float, int32 Tier) { return Target * (1.6f - 0.2f * (TopTier - Tier)); },
+				[TopTier](const FScenarioResult& Result) { return Result.GetFinalTier() == FMath::Max(TopTier - 3, 0) && Result.GetNumUpgrades() == 0; });
+			bPassed &= RunScenario(TEXT("light"), Settings, NumTiers, 30.f, [Target](float, int32) { return Target * 0.5f; },
+				[](const FScenarioResult& Result) { return Result.Changes.Num() == 0; });
+			// Top tier just over budget, the one below well under it: every failed try at the top tier should come later than the last
+			bPassed &= RunScenario(TEXT("boundary"), Settings, NumTiers, 300.f, [Target, TopTier](float, int32 Tier) { return Target * (Tier == TopTier ? 1.15f : 0.7f); },
+				[TopTier](const FScenarioResult& Result)
+				{
+					float LastGap = 0.f;
+					for (int32 Index = 1; Index < Result.Changes.Num(); Index += 2)
+					{
+						const float Gap = Result.Changes[Index].Value - Result.Changes[Index - 1].Value;
+						if (Result.Changes[Index].Key != TopTier || Gap < LastGap)
+						{
+							return false;
+						}
+						LastGap = Gap;
+					}
+					return Result.LowestTier == FMath::Max(TopTier - 1, 0);
+				});
+			// A 100 ms hitch every half second stays out of the 90th percentile
+			bPassed &= RunScenario(TEXT("hitches"), Settings, NumTiers, 30.f, [Target](float Time, int32) { return FMath::Fmod(Time, 0.5f) < Target / 1000.f ? 100.f : Target * 0.9f; },
+				[](const FScenarioResult& Result) { return Result.Changes.Num() == 0; });
+			// Heavy for 20 s, then light again: all the way down, then all the way back up
+			bPassed &= RunScenario(TEXT("recover"), Settings, NumTiers, 120.f, [Target](float Time, int32) { return Target * (Time < 20.f ? 1.5f : 0.5f); },
+				[TopTier](const FScenarioResult& Result) { return Result.LowestTier == 0 && Result.GetFinalTier() == TopTier; });
+
+			if (bPassed)
+			{
+				UE_LOG(LogFishingGame, Display, TEXT("Fishing governor sim: every scenario picked the expected tiers"));
+			}
+			else
+			{
+				UE_LOG(LogFishingGame, Warning, TEXT("Fishing governor sim: some scenarios picked unexpected tiers"));
+			}
+		}));
+}
+
+UFishingScalabilitySubsystem::UFishingScalabilitySubsystem()
+{
+	Tiers.SetNum(4);
+	Tiers[0].LineLODBias = 2;
+	Tiers[0].bBiteFX = false;
+	Tiers[0].FoliageDensity = 0.25f;
+	Tiers[1].LineLODBias = 1;
+	Tiers[1].FoliageDensity = 0.5f;
+	Tiers[2].FoliageDensity = 0.75f;
+
+	FFishingWaterMaterialTiers& Lake = WaterMaterials.AddDefaulted_GetRef();
+	Lake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_UNLIT_Transparent_NonTessellated"))));
+	Lake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_Mobile_Transparent"))));
+	Lake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_PBR_Transparent_NonTessellated"))));
+	Lake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_PBR_Transparent_Tessellated"))));
+
+	// What FishingLake's BP_CartoonWater_Lake uses
+	FFishingWaterMaterialTiers& OpaqueLake = WaterMaterials.AddDefaulted_GetRef();
+	OpaqueLake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_UNLIT_NonTransparent_NonTessellated"))));
+	OpaqueLake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_Mobile_NonTransparent"))));
+	OpaqueLake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_PBR_NonTransparent_NonTessellated"))));
+	OpaqueLake.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_PBR_NonTransparent_Tessellated"))));
+
+	// The depth pass only comes with and without tessellation, and has to follow the surface's
+	FFishingWaterMaterialTiers& LakeDepth = WaterMaterials.AddDefaulted_GetRef();
+	LakeDepth.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_NoTessellation_Depth"))));
+	LakeDepth.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_NoTessellation_Depth"))));
+	LakeDepth.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_NoTessellation_Depth"))));
+	LakeDepth.Materials.Add(TSoftObjectPtr<UMaterialInterface>(FishingScalability::LakeMaterial(TEXT("MI_Lake_Tesselated_WaterDepth"))));
+}
+
+FFishingFrameGovernor::FSettings UFishingScalabilitySubsystem::GetGovernorSettings() const
+{
+	FFishingFrameGovernor::FSettings Settings;
+	Settings.TargetFrameMs = TargetFrameMs;
+	Settings.Percentile = Percentile;
+	Settings.WindowFrames = WindowFrames;
+	Settings.DowngradeThreshold = DowngradeThreshold;
+	Settings.UpgradeThreshold = UpgradeThreshold;
+	Settings.DowngradeDelay = DowngradeDelay;
+	Settings.UpgradeDelay = UpgradeDelay;
+	Settings.ChangeCooldown = ChangeCooldown;
+	Settings.UpgradeProbation = UpgradeProbation;
+	Settings.MaxUpgradeBackoff = MaxUpgradeBackoff;
+	return Settings;
+}
+
+void UFishingScalabilitySubsystem::ForceTier(int32 Tier)
+{
+	if (Tiers.IsValidIndex(Tier))
+	{
+		ForcedTier = Tier;
+		ApplyTier(Tier);
+		return;
+	}
+
+	// The governor takes over from wherever the world is
+	ForcedTier = INDEX_NONE;
+	Governor.Reset(GetGovernorSettings(), Tiers.Num(), AppliedTier != INDEX_NONE ? AppliedTier : Tiers.Num() - 1);
+}
+
+bool UFishingScalabilitySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nothing to scale without rendering: dedicated servers, -nullrhi runs and editor worlds
+	const UWorld* World = Cast<UWorld>(Outer);
+	return FApp::CanEverRender() && World && World->IsGameWorld() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UFishingScalabilitySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Governor.Reset(GetGovernorSettings(), Tiers.Num(), Tiers.Num() - 1);
+
+	// What the FoliageQuality scalability group chose, for the tiers to scale down from
+	if (IConsoleVariable* FoliageDensityScale = FishingScalability::FoliageDensityScale())
+	{
+		BaseFoliageDensityScale = FoliageDensityScale->GetFloat();
+	}
+	if (IConsoleVariable* GrassDensityScale = FishingScalability::GrassDensityScale())
+	{
+		BaseGrassDensityScale = GrassDensityScale->GetFloat();
+	}
+
+	TArray<FSoftObjectPath> Variants;
+	for (int32 Family = 0; Family < WaterMaterials.Num(); ++Family)
+	{
+		for (const TSoftObjectPtr<UMaterialInterface>& Material : WaterMaterials[Family].Materials)
+		{
+			WaterFamilyByMaterial.Add(Material.ToSoftObjectPath(), Family);
+			Variants.Add(Material.ToSoftObjectPath());
+		}
+	}
+	if (Variants.Num() > 0 && UAssetManager::IsValid())
+	{
+		WaterMaterialsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Variants);
+	}
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UFishingScalabilitySubsystem::OnLevelAdded);
+}
+
+void UFishingScalabilitySubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	if (WaterMaterialsHandle.IsValid())
+	{
+		WaterMaterialsHandle->ReleaseHandle();
+		WaterMaterialsHandle.Reset();
+	}
+	WaterSlots.Empty();
+
+	// Leave the next world the density the scalability settings chose
+	if (AppliedTier != INDEX_NONE)
+	{
+		SetFoliageDensity(1.f);
+	}
+
+	Super::Deinitialize();
+}
+
+void UFishingScalabilitySubsystem::Tick(float DeltaTime)
+{
+	// Whichever of the game thread, render thread and GPU is the bottleneck
+	const float FrameMs = FMath::Max3(FPlatformTime::ToMilliseconds(GGameThreadTime), FPlatformTime::ToMilliseconds(GRenderThreadTime), FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles()));
+	if (ForcedTier == INDEX_NONE && FrameMs > 0.f && Governor.AddFrame(FrameMs, FApp::GetDeltaTime()))
+	{
+		UE_LOG(LogFishingGame, Log, TEXT("Fishing scalability: tier %d, %.0fth percentile frame at %.1f ms for a %.1f ms budget"),
+			Governor.GetTier(), Percentile * 100.f, Governor.GetPercentileMs(), TargetFrameMs);
+		FISHING_EVENT(TEXT("ScalabilityTier %d"), Governor.GetTier());
+		ApplyTier(Governor.GetTier());
+	}
+
+	// Water in levels streamed in since gets the current tier too
+	if (bWaterSlotsDirty && AppliedTier != INDEX_NONE)
+	{
+		ApplyWaterTier(AppliedTier);
+	}
+}
+
+TStatId UFishingScalabilitySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingScalabilitySubsystem, STATGROUP_Tickables);
+}
+
+void UFishingScalabilitySubsystem::ApplyTier(int32 Tier)
+{
+	FISHING_SCOPE(Scalability);
+
+	const FFishingScalabilityTier& Settings = Tiers[Tier];
+
+	UFishingLineComponent::SetLODBias(Settings.LineLODBias);
+
+	SetFoliageDensity(Settings.FoliageDensity);
+
+	ApplyWaterTier(Tier);
+	AppliedTier = Tier;
+}
+
+void UFishingScalabilitySubsystem::SetFoliageDensity(float Density)
+{
+	if (IConsoleVariable* FoliageDensityScale = FishingScalability::FoliageDensityScale())
+	{
+		FoliageDensityScale->Set(BaseFoliageDensityScale * Density, ECVF_SetByCode);
+	}
+	if (IConsoleVariable* GrassDensityScale = FishingScalability::GrassDensityScale())
+	{
+		GrassDensityScale->Set(BaseGrassDensityScale * Density, ECVF_SetByCode);
+	}
+}
+
+void UFishingScalabilitySubsystem::ApplyWaterTier(int32 Tier)
+{
+	if (bWaterSlotsDirty)
+	{
+		CollectWaterSlots();
+	}
+
+	for (const FWaterSlot& WaterSlot : WaterSlots)
+	{
+		UMeshComponent* Mesh = WaterSlot.Component.Get();
+		const TArray<TSoftObjectPtr<UMaterialInterface>>& Variants = WaterMaterials[WaterSlot.Family].Materials;
+		UMaterialInterface* Target = Mesh ? Variants[FMath::Min(Tier, Variants.Num() - 1)].Get() : nullptr;
+		if (!Target)
+		{
+			continue;
+		}
+
+		UMaterialInterface* Current = Mesh->GetMaterial(WaterSlot.Slot);
+		if (UMaterialInstanceDynamic* Dynamic = Cast<UMaterialInstanceDynamic>(Current))
+		{
+			// Keeps whatever parameters the water blueprint set at runtime
+			if (Dynamic->Parent != Target)
+			{
+				UMaterialInstanceDynamic* Swapped = UMaterialInstanceDynamic::Create(Target, Mesh);
+				Swapped->CopyParameterOverrides(Dynamic);
+				Mesh->SetMaterial(WaterSlot.Slot, Swapped);
+			}
+		}
+		else if (Current != Target)
+		{
+			Mesh->SetMaterial(WaterSlot.Slot, Target);
+		}
+	}
+}
+
+void UFishingScalabilitySubsystem::CollectWaterSlots()
+{
+	bWaterSlotsDirty = false;
+	WaterSlots.Reset();
+	if (WaterFamilyByMaterial.Num() == 0)
+	{
+		return;
+	}
+
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		TInlineComponentArray<UMeshComponent*> Meshes(*It);
+		for (UMeshComponent* Mesh : Meshes)
+		{
+			for (int32 Slot = 0; Slot < Mesh->GetNumMaterials(); ++Slot)
+			{
+				const int32 Family = FindWaterFamily(Mesh->GetMaterial(Slot));
+				if (Family != INDEX_NONE)
+				{
+					FWaterSlot& WaterSlot = WaterSlots.AddDefaulted_GetRef();
+					WaterSlot.Component = Mesh;
+					WaterSlot.Slot = Slot;
+					WaterSlot.Family = Family;
+				}
+			}
+		}
+	}
+}
+
+int32 UFishingScalabilitySubsystem::FindWaterFamily(const UMaterialInterface* Material) const
+{
+	// Dynamic instances made at runtime are looked through to what they were made from
+	while (Material)
+	{
+		if (const int32* Family = WaterFamilyByMaterial.Find(FSoftObjectPath(Material)))
+		{
+			return *Family;
+		}
+
+		const UMaterialInstanceDynamic* Dynamic = Cast<UMaterialInstanceDynamic>(Material);
+		Material = Dynamic ? Dynamic->Parent : nullptr;
+	}
+	return INDEX_NONE;
+}
+
+void UFishingScalabilitySubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		bWaterSlotsDirty = true;
+	}
+}
@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingSignificanceSubsystem.h"
+#include "FishingAIController.h"
+#include "FishingGame.h"
+#include "FishingGameCharacter.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+namespace FishingSignificance
+{
+	static FAutoConsoleCommandWithWorldAndArgs ForceCommand(
+		TEXT("Fishing.Significance"),
+		TEXT("Forces every NPC angler to a significance level. Usage: Fishing.Significance <0 Full | 1 Reduced | 2 Low | 3 Culled | -1 scored>"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingSignificanceSubsystem* Significance = World ? World->GetSubsystem<UFishingSignificanceSubsystem>() : nullptr;
+			if (Significance && Args.Num() > 0)
+			{
+				const int32 Level = FCString::Atoi(*Args[0]);
+				Significance->ForceSignificance(Level >= 0 && Level < (int32)EFishingSignificance::Num ? (EFishingSignificance)Level : EFishingSignificance::Num);
+			}
+		}));
+}
+
+void UFishingSignificanceSubsystem::RegisterAngler(AFishingGameCharacter* Character)
+{
+	if (!Character)
+	{
+		return;
+	}
+
+	UnregisterAngler(Character);
+
+	FSignificantAngler& Angler = Anglers.AddDefaulted_GetRef();
+	Angler.Character = Character;
+	Angler.AnimTickOption = Character->GetMesh()->VisibilityBasedAnimTickOption;
+
+	// Scored on the next tick
+	ScoreTime = 0.f;
+}
+
+void UFishingSignificanceSubsystem::UnregisterAngler(AFishingGameCharacter* Character)
+{
+	const int32 Index = Anglers.IndexOfByPredicate([Character](const FSignificantAngler& Angler) { return Angler.Character == Character; });
+	if (Index != INDEX_NONE)
+	{
+		Anglers.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+void UFishingSignificanceSubsystem::ForceSignificance(EFishingSignificance Level)
+{
+	ForcedLevel = Level;
+	ScoreTime = 0.f;
+}
+
+float UFishingSignificanceSubsystem::GetInterval(EFishingSignificance Level) const
+{
+	switch (Level)
+	{
+	case EFishingSignificance::Reduced:
+		return ReducedInterval;
+	case EFishingSignificance::Low:
+		return LowInterval;
+	case EFishingSignificance::Culled:
+		return CulledInterval;
+	default:
+		return 0.f;
+	}
+}
+
+void UFishingSignificanceSubsystem::Deinitialize()
+{
+	Anglers.Empty();
+	SortedAnglers.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFishingSignificanceSubsystem::Tick(float DeltaTime)
+{
+	ScoreTime -= DeltaTime;
+	if (ScoreTime <= 0.f)
+	{
+		ScoreTime = ScoreInterval;
+		UpdateSignificance();
+	}
+
+	StepDecisions(DeltaTime);
+}
+
+void UFishingSignificanceSubsystem::UpdateSignificance()
+{
+	FISHING_SCOPE(Significance);
+
+	Anglers.RemoveAllSwap([](const FSignificantAngler& Angler) { return !Angler.Character.IsValid(); }, false);
+
+	// Clients only have their own controllers, servers have every player's
+	ViewLocations.Reset();
+	RemoteViews.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		const bool bRemote = PC && !PC->GetLocalPlayer() && PC->GetNetConnection();
+		if (PC && PC->PlayerCameraManager && (PC->GetLocalPlayer() || bRemote))
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+			RemoteViews.Add(bRemote);
+		}
+	}
+
+	const float FullDistanceSq = FMath::Square(FullDistance);
+	const float ReducedDistanceSq = FMath::Square(ReducedDistance);
+
+	SortedAnglers.Reset(Anglers.Num());
+	TArray<float, TInlineAllocator<256>> DistancesSq;
+	TBitArray<TInlineAllocator<8>> Visible;
+	DistancesSq.SetNumUninitialized(Anglers.Num());
+	Visible.Init(false, Anglers.Num());
+
+	FMemory::Memzero(NumAtLevel);
+	for (int32 Index = 0; Index < Anglers.Num(); ++Index)
+	{
+		FSignificantAngler& Angler = Anglers[Index];
+		AFishingGameCharacter* Character = Angler.Character.Get();
+
+		// Player anglers aren't part of the crowd and never count against its budget
+		if (Character->IsPlayerControlled())
+		{
+			if (Angler.Level != EFishingSignificance::Full)
+			{
+				Angler.Level = EFishingSignificance::Full;
+				ApplySignificance(Angler, EFishingSignificance::Full);
+			}
+			continue;
+		}
+
+		const FVector Location = Character->GetActorLocation();
+		float DistanceSq = MAX_flt;
+		bool bClosestRemote = false;
+		for (int32 View = 0; View < ViewLocations.Num(); ++View)
+		{
+			const float ViewDistanceSq = FVector::DistSquared(ViewLocations[View], Location);
+			if (ViewDistanceSq < DistanceSq)
+			{
+				DistanceSq = ViewDistanceSq;
+				bClosestRemote = RemoteViews[View];
+			}
+		}
+		const bool bVisible = ViewLocations.Num() > 0 && (bClosestRemote || Character->WasRecentlyRendered(VisibilityTimeout));
+
+		DistancesSq[Index] = DistanceSq;
+		Visible[Index] = bVisible;
+		Angler.Score = (bVisible ? 1.f : HiddenScoreScale) / FMath::Max(FMath::Sqrt(DistanceSq), 1.f);
+		SortedAnglers.Add(Index);
+	}
+
+	SortedAnglers.Sort([this](int32 A, int32 B) { return Anglers[A].Score > Anglers[B].Score; });
+
+	for (int32 Index : SortedAnglers)
+	{
+		FSignificantAngler& Angler = Anglers[Index];
+
+		EFishingSignificance Level = ForcedLevel;
+		if (Level == EFishingSignificance::Num)
+		{
+			const bool bVisible = Visible[Index];
+			if (bVisible && DistancesSq[Index] < FullDistanceSq && NumAtLevel[(uint8)EFishingSignificance::Full] < MaxFullAnglers)
+			{
+				Level = EFishingSignificance::Full;
+			}
+			else if (bVisible && DistancesSq[Index] < ReducedDistanceSq && NumAtLevel[(uint8)EFishingSignificance::Reduced] < MaxReducedAnglers)
+			{
+				Level = EFishingSignificance::Reduced;
+			}
+			else if (bVisible || DistancesSq[Index] < ReducedDistanceSq)
+			{
+				Level = EFishingSignificance::Low;
+			}
+			else
+			{
+				Level = EFishingSignificance::Culled;
+			}
+		}
+		++NumAtLevel[(uint8)Level];
+
+		if (Level != Angler.Level)
+		{
+			Angler.Level = Level;
+			ApplySignificance(Angler, Level);
+		}
+	}
+}
+
+void UFishingSignificanceSubsystem::StepDecisions(float DeltaTime)
+{
+	FISHING_SCOPE(CrowdDecisions);
+
+	for (FSignificantAngler& Angler : Anglers)
+	{
+		Angler.DecisionTime += DeltaTime;
+		if (Angler.DecisionTime < GetInterval(Angler.Level))
+		{
+			continue;
+		}
+
+		// Only the server has the controllers
+		AFishingGameCharacter* Character = Angler.Character.Get();
+		if (AFishingAIController* Controller = Character ? Cast<AFishingAIController>(Character->GetController()) : nullptr)
+		{
+			Controller->StepFishing(Angler.DecisionTime);
+		}
+		Angler.DecisionTime = 0.f;
+	}
+}
+
+void UFishingSignificanceSubsystem::ApplySignificance(const FSignificantAngler& Angler, EFishingSignificance Level) const
+{
+	AFishingGameCharacter* Character = Angler.Character.Get();
+	const float Interval = GetInterval(Level);
+
+	// The actor only ticks while its hook moves, and keeps the interval for when it does
+	Character->SetActorTickInterval(Interval);
+	Character->GetCharacterMovement()->SetComponentTickInterval(Interval);
+
+	// Close meshes are left to the update rate optimizations, which already skip frames by screen size
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	Mesh->SetComponentTickInterval(Level <= EFishingSignificance::Reduced ? 0.f : Interval);
+
+	// Casts and reels advance on anim notifies, so player anglers and dedicated servers, which never render, keep the mesh's own option
+	const bool bKeepTickOption = Level == EFishingSignificance::Full || Character->IsPlayerControlled() || GetWorld()->GetNetMode() == NM_DedicatedServer;
+	if (bKeepTickOption)
+	{
+		Mesh->VisibilityBasedAnimTickOption = Angler.AnimTickOption;
+	}
+	else
+	{
+		Mesh->VisibilityBasedAnimTickOption = Level == EFishingSignificance::Culled ? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered : EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	}
+
+	Character->SetCosmeticsEnabled(Level <= EFishingSignificance::Reduced);
+}
+
+TStatId UFishingSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingSignificanceSubsystem, STATGROUP_Tickables);
+}
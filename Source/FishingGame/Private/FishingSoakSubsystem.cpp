@@ -0,0 +1,556 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingSoakSubsystem.h"
+#include "FishingGame.h"
+#include "FishingAIController.h"
+#include "FishingGameCharacter.h"
+#include "FishingGamePlayerController.h"
+#include "FishingLineComponent.h"
+#include "FishingSignificanceSubsystem.h"
+#include "FishingZone.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+
+namespace FishingSoak
+{
+	static TArray<int32> ParseAnglerCounts(const FString& CountsString)
+	{
+		TArray<FString> Tokens;
+		CountsString.ParseIntoArray(Tokens, TEXT(","));
+
+		TArray<int32> Counts;
+		for (const FString& Token : Tokens)
+		{
+			const int32 Count = FCString::Atoi(*Token);
+			if (Count > 0)
+			{
+				Counts.Add(Count);
+			}
+		}
+		return Counts;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs SoakCommand(
+		TEXT("Fishing.Soak"),
+		TEXT("Runs the headless fishing soak test. Usage: Fishing.Soak <AnglerCounts, e.g. 1,16,128,512> [SecondsPerRun]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingSoakSubsystem* Soak = World ? World->GetSubsystem<UFishingSoakSubsystem>() : nullptr;
+			if (Soak && Args.Num() > 0)
+			{
+				Soak->StartSoak(ParseAnglerCounts(Args[0]), Args.Num() > 1 ? FCString::Atof(*Args[1]) : 30.f);
+			}
+		}));
+
+	static FAutoConsoleCommandWithWorldAndArgs CrowdSoakCommand(
+		TEXT("Fishing.CrowdSoak"),
+		TEXT("Runs the headless fishing soak test with NPC anglers. Usage: Fishing.CrowdSoak <AnglerCounts, e.g. 16,128,512> [SecondsPerRun]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingSoakSubsystem* Soak = World ? World->GetSubsystem<UFishingSoakSubsystem>() : nullptr;
+			if (Soak && Args.Num() > 0)
+			{
+				Soak->StartSoak(ParseAnglerCounts(Args[0]), Args.Num() > 1 ? FCString::Atof(*Args[1]) : 30.f, true);
+			}
+		}));
+
+	/** Frames at the start of each run that are left out of the averages while spawned anglers settle. */
+	static constexpr float WarmupSeconds = 2.f;
+}
+
+void FFishingSoakPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->OnPhysicsTick(bStart);
+	}
+}
+
+void UFishingSoakSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Random.Initialize(0xF15);
+
+	StartPhysicsTick.Target = this;
+	StartPhysicsTick.bStart = true;
+	StartPhysicsTick.TickGroup = TG_StartPhysics;
+	StartPhysicsTick.bCanEverTick = true;
+
+	EndPhysicsTick.Target = this;
+	EndPhysicsTick.bStart = false;
+	EndPhysicsTick.TickGroup = TG_EndPhysics;
+	EndPhysicsTick.bCanEverTick = true;
+}
+
+void UFishingSoakSubsystem::Deinitialize()
+{
+	StartPhysicsTick.UnRegisterTickFunction();
+	EndPhysicsTick.UnRegisterTickFunction();
+	EndCsvCapture();
+
+	Super::Deinitialize();
+}
+
+void UFishingSoakSubsystem::StartSoak(const TArray<int32>& InAnglerCounts, float InSecondsPerRun, bool bInCrowd)
+{
+	if (IsRunning() || InAnglerCounts.Num() == 0)
+	{
+		return;
+	}
+
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing soak: anglers are spawned by the server, run the soak there"));
+		return;
+	}
+
+	AnglerCounts = InAnglerCounts;
+	bCrowd = bInCrowd;
+	SecondsPerRun = FMath::Max(InSecondsPerRun, FishingSoak::WarmupSeconds + 1.f);
+	Results.Reset();
+	RunIndex = 0;
+
+	if (!StartPhysicsTick.IsTickFunctionRegistered())
+	{
+		StartPhysicsTick.RegisterTickFunction(GetWorld()->PersistentLevel);
+		EndPhysicsTick.RegisterTickFunction(GetWorld()->PersistentLevel);
+	}
+
+	BeginRun();
+}
+
+void UFishingSoakSubsystem::OnPhysicsTick(bool bStart)
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	if (bStart)
+	{
+		PhysicsStartTime = FPlatformTime::Seconds();
+	}
+	else if (RunTime > FishingSoak::WarmupSeconds)
+	{
+		PhysicsMsTotal += (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0;
+	}
+}
+
+ETickableTickType UFishingSoakSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool UFishingSoakSubsystem::IsTickable() const
+{
+	return GetWorld() && GetWorld()->IsGameWorld() && (IsRunning() || !bCheckedCommandLine || PendingCounts.Num() > 0);
+}
+
+void UFishingSoakSubsystem::Tick(float DeltaTime)
+{
+	if (!bCheckedCommandLine)
+	{
+		bCheckedCommandLine = true;
+
+		FString CountsString;
+		if (FParse::Value(FCommandLine::Get(), TEXT("FishingSoak="), CountsString))
+		{
+			float Seconds = 30.f;
+			FParse::Value(FCommandLine::Get(), TEXT("FishingSoakSeconds="), Seconds);
+			FParse::Value(FCommandLine::Get(), TEXT("FishingSoakDelay="), StartDelay);
+			PendingCounts = FishingSoak::ParseAnglerCounts(CountsString);
+			PendingSeconds = Seconds;
+			bPendingCrowd = FParse::Param(FCommandLine::Get(), TEXT("FishingCrowd"));
+		}
+		return;
+	}
+
+	// Gives clients time to connect before a networked soak starts
+	if (PendingCounts.Num() > 0)
+	{
+		StartDelay -= DeltaTime;
+		if (StartDelay <= 0.f)
+		{
+			StartSoak(PendingCounts, PendingSeconds, bPendingCrowd);
+			PendingCounts.Reset();
+		}
+		return;
+	}
+
+	RunTime += DeltaTime;
+
+	for (FSoakAngler& Angler : Anglers)
+	{
+		StepAngler(Angler, DeltaTime);
+	}
+
+	// Per-frame counters are read every frame so nothing from the warmup leaks into the first measured one
+	double LineSolveMs = 0.0;
+	int32 SimulatedLines = 0;
+	UFishingLineComponent::ConsumeSolveStats(LineSolveMs, SimulatedLines);
+	const int32 ActorsTicked = GFishingActorsTicked;
+	GFishingActorsTicked = 0;
+
+	if (RunTime > FishingSoak::WarmupSeconds)
+	{
+		++CurrentRun.Frames;
+		FrameMsTotal += FApp::GetDeltaTime() * 1000.0;
+		GameThreadMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+		LineSolveMsTotal += LineSolveMs;
+		SimulatedLinesTotal += SimulatedLines;
+
+		ActorsTickedTotal += ActorsTicked;
+
+		if (const UFishingSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UFishingSignificanceSubsystem>())
+		{
+			SignificantAnglersTotal += Significance->GetNumAnglersAt(EFishingSignificance::Full) + Significance->GetNumAnglersAt(EFishingSignificance::Reduced);
+		}
+
+		if (CurrentRun.Frames == 1)
+		{
+			const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+			NetOutBytesAtStart = NetDriver ? NetDriver->OutTotalBytes : 0;
+			NetMeasureStartTime = FPlatformTime::Seconds();
+		}
+		CurrentRun.PeakUsedMB = FMath::Max(CurrentRun.PeakUsedMB, FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0));
+	}
+
+	if (RunTime >= SecondsPerRun)
+	{
+		EndRun();
+	}
+}
+
+void UFishingSoakSubsystem::BeginRun()
+{
+	CurrentRun = FSoakRunResult();
+	CurrentRun.Anglers = AnglerCounts[RunIndex];
+	CurrentRun.bCrowd = bCrowd;
+	RunTime = 0.f;
+	FrameMsTotal = 0.0;
+	PhysicsMsTotal = 0.0;
+	LineSolveMsTotal = 0.0;
+	SimulatedLinesTotal = 0;
+	ActorsTickedTotal = 0;
+	SignificantAnglersTotal = 0;
+	GameThreadMs.Reset();
+
+	const uint64 UsedBeforeSpawn = FPlatformMemory::GetStats().UsedPhysical;
+	const double SpawnStart = FPlatformTime::Seconds();
+
+	SpawnAnglers(CurrentRun.Anglers);
+
+	CurrentRun.SpawnMsPerAngler = (FPlatformTime::Seconds() - SpawnStart) * 1000.0 / CurrentRun.Anglers;
+	UsedPhysicalAtStart = FPlatformMemory::GetStats().UsedPhysical;
+	CurrentRun.MemoryKBPerAngler = ((double)UsedPhysicalAtStart - (double)UsedBeforeSpawn) / 1024.0 / CurrentRun.Anglers;
+
+#if CSV_PROFILER
+	if (!bCapturingCsv && !FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture(-1, FPaths::ProfilingDir() / TEXT("FishingSoak"), FString::Printf(TEXT("FishingSoakCsv-%s.csv"), *FDateTime::Now().ToString()));
+		bCapturingCsv = true;
+	}
+#endif
+	FISHING_EVENT(TEXT("Soak %d anglers"), CurrentRun.Anglers);
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing soak: running %d %s anglers for %.0f seconds"), CurrentRun.Anglers, bCrowd ? TEXT("NPC") : TEXT("scripted"), SecondsPerRun);
+}
+
+void UFishingSoakSubsystem::EndRun()
+{
+	if (CurrentRun.Frames > 0)
+	{
+		CurrentRun.AvgFrameMs = FrameMsTotal / CurrentRun.Frames;
+		CurrentRun.AvgPhysicsMs = PhysicsMsTotal / CurrentRun.Frames;
+		CurrentRun.AvgLineSolveMs = LineSolveMsTotal / CurrentRun.Frames;
+		CurrentRun.AvgSimulatedLines = (double)SimulatedLinesTotal / CurrentRun.Frames;
+		CurrentRun.AvgActorsTicked = (double)ActorsTickedTotal / CurrentRun.Frames;
+		CurrentRun.AvgSignificantAnglers = (double)SignificantAnglersTotal / CurrentRun.Frames;
+
+		const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+		const double NetSeconds = FPlatformTime::Seconds() - NetMeasureStartTime;
+		if (NetDriver && NetSeconds > 0.0)
+		{
+			CurrentRun.NetClients = NetDriver->ClientConnections.Num();
+			CurrentRun.NetBytesPerSecPerAngler = (NetDriver->OutTotalBytes - NetOutBytesAtStart) / NetSeconds / CurrentRun.Anglers / FMath::Max(1, CurrentRun.NetClients);
+		}
+
+		double GameThreadTotal = 0.0;
+		for (float Ms : GameThreadMs)
+		{
+			GameThreadTotal += Ms;
+		}
+		CurrentRun.AvgGameThreadMs = GameThreadTotal / GameThreadMs.Num();
+
+		GameThreadMs.Sort();
+		CurrentRun.P95GameThreadMs = GameThreadMs[FMath::Min(GameThreadMs.Num() - 1, FMath::FloorToInt(GameThreadMs.Num() * 0.95f))];
+	}
+
+	// NPC anglers keep their own count, scripted ones are counted as they are stepped
+	for (const FSoakAngler& Angler : Anglers)
+	{
+		if (const AFishingAIController* AIController = Cast<AFishingAIController>(Angler.Controller.Get()))
+		{
+			CurrentRun.Casts += AIController->GetNumCasts();
+			CurrentRun.Catches += AIController->GetNumCatches();
+		}
+	}
+
+	if (CurrentRun.Casts > 0)
+	{
+		CurrentRun.UsedMBPerCast = ((double)FPlatformMemory::GetStats().UsedPhysical - (double)UsedPhysicalAtStart) / (1024.0 * 1024.0) / CurrentRun.Casts;
+	}
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing soak: %d anglers, %.2f ms game thread (p95 %.2f), %.2f ms physics, %.3f ms line solver (%.1f lines), %.1f fishing actors ticked, %.1f significant NPCs, %.1f B/s per angler and client (%d clients), %d casts, %d catches"),
+		CurrentRun.Anglers, CurrentRun.AvgGameThreadMs, CurrentRun.P95GameThreadMs, CurrentRun.AvgPhysicsMs, CurrentRun.AvgLineSolveMs, CurrentRun.AvgSimulatedLines, CurrentRun.AvgActorsTicked, CurrentRun.AvgSignificantAnglers, CurrentRun.NetBytesPerSecPerAngler, CurrentRun.NetClients, CurrentRun.Casts, CurrentRun.Catches);
+
+	Results.Add(CurrentRun);
+	DestroyAnglers();
+
+	if (AnglerCounts.IsValidIndex(++RunIndex))
+	{
+		BeginRun();
+		return;
+	}
+
+	RunIndex = INDEX_NONE;
+	StartPhysicsTick.UnRegisterTickFunction();
+	EndPhysicsTick.UnRegisterTickFunction();
+	EndCsvCapture();
+	WriteReport();
+
+	if (FApp::IsUnattended())
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UFishingSoakSubsystem::SpawnAnglers(int32 Count)
+{
+	UWorld* World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+
+	UClass* PawnClass = AFishingGameCharacter::StaticClass();
+	UClass* GameModePawnClass = GameMode ? GameMode->GetDefaultPawnClassForController(nullptr) : nullptr;
+	if (GameModePawnClass && GameModePawnClass->IsChildOf(AFishingGameCharacter::StaticClass()))
+	{
+		PawnClass = GameModePawnClass;
+	}
+
+	UClass* ControllerClass = AFishingGamePlayerController::StaticClass();
+	if (bCrowd)
+	{
+		const APawn* PawnCDO = PawnClass->GetDefaultObject<APawn>();
+		ControllerClass = PawnCDO->AIControllerClass && PawnCDO->AIControllerClass->IsChildOf(AFishingAIController::StaticClass()) ? PawnCDO->AIControllerClass.Get() : AFishingAIController::StaticClass();
+	}
+	else if (GameMode && GameMode->PlayerControllerClass && GameMode->PlayerControllerClass->IsChildOf(AFishingGamePlayerController::StaticClass()))
+	{
+		ControllerClass = GameMode->PlayerControllerClass;
+	}
+
+	// Anglers stand in rings around the fishing zones, facing the water
+	TArray<FBox> ZoneBounds;
+	for (TActorIterator<AFishingZone> It(World); It; ++It)
+	{
+		ZoneBounds.Add(It->GetComponentsBoundingBox());
+	}
+	if (ZoneBounds.Num() == 0)
+	{
+		ZoneBounds.Add(FBox(FVector(-500.f), FVector(500.f)));
+	}
+
+	constexpr int32 AnglersPerRing = 32;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FBox& Zone = ZoneBounds[Index % ZoneBounds.Num()];
+		const int32 Slot = Index / ZoneBounds.Num();
+		const float Radius = Zone.GetExtent().Size2D() + 300.f + (Slot / AnglersPerRing) * 150.f;
+		const float Angle = (2.f * PI * (Slot % AnglersPerRing)) / AnglersPerRing;
+
+		FVector Location = Zone.GetCenter() + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius;
+		FHitResult GroundHit;
+		if (World->LineTraceSingleByChannel(GroundHit, Location + FVector(0.f, 0.f, 5000.f), Location - FVector(0.f, 0.f, 5000.f), ECC_Visibility))
+		{
+			Location = GroundHit.Location + FVector(0.f, 0.f, 100.f);
+		}
+		const FRotator Facing = (Zone.GetCenter() - Location).GetSafeNormal2D().Rotation();
+
+		AFishingGameCharacter* Character = World->SpawnActor<AFishingGameCharacter>(PawnClass, Location, Facing, SpawnParams);
+		AController* Controller = World->SpawnActor<AController>(ControllerClass, Location, Facing, SpawnParams);
+		if (Character && Controller)
+		{
+			Controller->Possess(Character);
+
+			FSoakAngler& Angler = Anglers.AddDefaulted_GetRef();
+			Angler.Character = Character;
+			Angler.Controller = Controller;
+			Angler.StepDuration = Random.FRandRange(0.f, 1.f);
+		}
+	}
+}
+
+void UFishingSoakSubsystem::DestroyAnglers()
+{
+	for (FSoakAngler& Angler : Anglers)
+	{
+		if (AFishingGameCharacter* Character = Angler.Character.Get())
+		{
+			Character->Destroy();
+		}
+		if (AController* Controller = Angler.Controller.Get())
+		{
+			Controller->Destroy();
+		}
+	}
+	Anglers.Reset();
+}
+
+void UFishingSoakSubsystem::StepAngler(FSoakAngler& Angler, float DeltaTime)
+{
+	AFishingGameCharacter* Character = Angler.Character.Get();
+	// NPC anglers are stepped by UFishingSignificanceSubsystem
+	AFishingGamePlayerController* Controller = Cast<AFishingGamePlayerController>(Angler.Controller.Get());
+	if (!Character || !Controller)
+	{
+		return;
+	}
+
+	Angler.StepTime += DeltaTime;
+	const bool bStepElapsed = Angler.StepTime >= Angler.StepDuration;
+
+	auto NextStep = [&Angler](EAnglerStep Step, float Duration)
+	{
+		Angler.Step = Step;
+		Angler.StepTime = 0.f;
+		Angler.StepDuration = Duration;
+	};
+
+	// Stands in for both the player's input and the notifies the animation Blueprint would send
+	switch (Angler.Step)
+	{
+	case EAnglerStep::Idle:
+		if (bStepElapsed)
+		{
+			Controller->ReadyThrowCast();
+			NextStep(EAnglerStep::Charging, Random.FRandRange(0.3f, 2.f));
+		}
+		break;
+
+	case EAnglerStep::Charging:
+		if (bStepElapsed)
+		{
+			Controller->ThrowCast();
+			++CurrentRun.Casts;
+			NextStep(EAnglerStep::Launching, 0.5f);
+		}
+		break;
+
+	case EAnglerStep::Launching:
+		if (bStepElapsed)
+		{
+			if (Character->GetHookMesh()->GetAttachParent())
+			{
+				Character->LaunchHook();
+			}
+			NextStep(EAnglerStep::HookInFlight, 4.f);
+		}
+		break;
+
+	case EAnglerStep::HookInFlight:
+		if (Character->IsHookLanded())
+		{
+			Controller->SetInTransition(false);
+			Controller->SetIsFishing(true);
+			Character->StartFishing();
+			NextStep(EAnglerStep::WaitingForBite, 0.f);
+		}
+		else if (bStepElapsed)
+		{
+			// Missed the water, reel back in and try again
+			Controller->SetInTransition(false);
+			Character->ReelHook();
+			Character->ClearTimersAndVFX();
+			NextStep(EAnglerStep::Idle, Random.FRandRange(0.2f, 1.f));
+		}
+		break;
+
+	case EAnglerStep::WaitingForBite:
+		if (Character->IsFishBiting())
+		{
+			// Some reactions are slower than the escape window so the miss path gets exercised too
+			NextStep(EAnglerStep::Reacting, Random.FRandRange(0.2f, 2.5f));
+		}
+		break;
+
+	case EAnglerStep::Reacting:
+		if (bStepElapsed)
+		{
+			if (Character->IsFishBiting())
+			{
+				++CurrentRun.Catches;
+			}
+			Controller->ReadyThrowCast();
+			Character->ReelHook();
+			Character->ClearTimersAndVFX();
+			Controller->SetInTransition(false);
+			NextStep(EAnglerStep::Idle, Random.FRandRange(0.2f, 1.f));
+		}
+		break;
+	}
+}
+
+void UFishingSoakSubsystem::WriteReport() const
+{
+	const FString BaseName = FPaths::ProfilingDir() / TEXT("FishingSoak") / FString::Printf(TEXT("FishingSoak-%s"), *FDateTime::Now().ToString());
+
+	FString Csv = TEXT("Anglers,Crowd,Frames,SpawnMsPerAngler,MemoryKBPerAngler,AvgFrameMs,AvgGameThreadMs,P95GameThreadMs,AvgPhysicsMs,AvgLineSolveMs,AvgSimulatedLines,AvgActorsTicked,AvgSignificantAnglers,NetClients,NetBytesPerSecPerAngler,Casts,Catches,UsedMBPerCast,PeakUsedMB\n");
+	FString Json = TEXT("[\n");
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const FSoakRunResult& Run = Results[Index];
+		Csv += FString::Printf(TEXT("%d,%d,%d,%.4f,%.2f,%.4f,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%d,%.2f,%d,%d,%.6f,%.2f\n"),
+			Run.Anglers, Run.bCrowd ? 1 : 0, Run.Frames, Run.SpawnMsPerAngler, Run.MemoryKBPerAngler, Run.AvgFrameMs, Run.AvgGameThreadMs, Run.P95GameThreadMs, Run.AvgPhysicsMs, Run.AvgLineSolveMs, Run.AvgSimulatedLines, Run.AvgActorsTicked, Run.AvgSignificantAnglers, Run.NetClients, Run.NetBytesPerSecPerAngler, Run.Casts, Run.Catches, Run.UsedMBPerCast, Run.PeakUsedMB);
+		Json += FString::Printf(TEXT("\t{ \"anglers\": %d, \"crowd\": %s, \"frames\": %d, \"spawnMsPerAngler\": %.4f, \"memoryKBPerAngler\": %.2f, \"avgFrameMs\": %.4f, \"avgGameThreadMs\": %.4f, \"p95GameThreadMs\": %.4f, \"avgPhysicsMs\": %.4f, \"avgLineSolveMs\": %.4f, \"avgSimulatedLines\": %.2f, \"avgActorsTicked\": %.2f, \"avgSignificantAnglers\": %.2f, \"netClients\": %d, \"netBytesPerSecPerAngler\": %.2f, \"casts\": %d, \"catches\": %d, \"usedMBPerCast\": %.6f, \"peakUsedMB\": %.2f }%s\n"),
+			Run.Anglers, Run.bCrowd ? TEXT("true") : TEXT("false"), Run.Frames, Run.SpawnMsPerAngler, Run.MemoryKBPerAngler, Run.AvgFrameMs, Run.AvgGameThreadMs, Run.P95GameThreadMs, Run.AvgPhysicsMs, Run.AvgLineSolveMs, Run.AvgSimulatedLines, Run.AvgActorsTicked, Run.AvgSignificantAnglers, Run.NetClients, Run.NetBytesPerSecPerAngler, Run.Casts, Run.Catches, Run.UsedMBPerCast, Run.PeakUsedMB,
+			Index + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+	Json += TEXT("]\n");
+
+	FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+	FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing soak: report written to %s.csv/.json"), *BaseName);
+}
+
+void UFishingSoakSubsystem::EndCsvCapture()
+{
+#if CSV_PROFILER
+	if (bCapturingCsv)
+	{
+		FCsvProfiler::Get()->EndCapture();
+		bCapturingCsv = false;
+	}
+#endif
+}
+
+TStatId UFishingSoakSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingSoakSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,400 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingStreamingSubsystem.h"
+#include "FishingGame.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+namespace FishingStreaming
+{
+	static const TCHAR* CellTag = TEXT("_Cell_");
+
+	/** How far ahead along the lap the walking pawn aims, in radians. */
+	constexpr float LapLookAhead = 0.2f;
+
+	static FAutoConsoleCommandWithWorldAndArgs LapCommand(
+		TEXT("Fishing.StreamingLap"),
+		TEXT("Walks the local pawn a lap of the streamed lake and reports resident memory and load stalls. Usage: Fishing.StreamingLap [Radius=0 fits the cell grid] [MaxSeconds=900]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (UFishingStreamingSubsystem* Streaming = World ? World->GetSubsystem<UFishingStreamingSubsystem>() : nullptr)
+			{
+				Streaming->StartLap(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.f, Args.Num() > 1 ? FCString::Atof(*Args[1]) : 900.f);
+			}
+		}));
+}
+
+void UFishingStreamingSubsystem::PrioritizeLocation(const FVector& Location)
+{
+	FHint& Hint = Hints.AddDefaulted_GetRef();
+	Hint.Location = FVector2D(Location);
+	Hint.ExpireTime = GetWorld()->GetTimeSeconds() + HintDuration;
+
+	// Queued on the spot rather than at the next update, the hook is already flying
+	UpdateTime = 0.f;
+}
+
+void UFishingStreamingSubsystem::Deinitialize()
+{
+	EndLap();
+
+	Cells.Empty();
+	Hints.Empty();
+	LoadQueue.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFishingStreamingSubsystem::Tick(float DeltaTime)
+{
+	if (!bDiscovered)
+	{
+		DiscoverCells();
+	}
+	if (Cells.Num() == 0)
+	{
+		return;
+	}
+
+	if (Lap.IsSet())
+	{
+		StepLap(DeltaTime);
+	}
+
+	GetPawnLocations(PawnLocations, NumLocalPawns);
+
+	UpdateTime -= DeltaTime;
+	if (UpdateTime <= 0.f)
+	{
+		UpdateTime = UpdateInterval;
+		UpdateStreaming();
+	}
+
+	FlushCellsUnderPawns();
+
+	if (Lap.IsSet())
+	{
+		const double UsedMB = FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+		++Lap->Frames;
+		Lap->SumUsedMB += UsedMB;
+		Lap->PeakUsedMB = FMath::Max(Lap->PeakUsedMB, UsedMB);
+		Lap->SumLoadedCells += NumLoaded;
+		Lap->PeakLoadedCells = FMath::Max(Lap->PeakLoadedCells, NumLoaded);
+	}
+}
+
+TStatId UFishingStreamingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingStreamingSubsystem, STATGROUP_Tickables);
+}
+
+void UFishingStreamingSubsystem::DiscoverCells()
+{
+	bDiscovered = true;
+
+	UWorld* World = GetWorld();
+	if (!World->IsGameWorld())
+	{
+		return;
+	}
+
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		// Only dynamic (Blueprint) streaming levels can be loaded and unloaded at will
+		ULevelStreamingDynamic* Level = Cast<ULevelStreamingDynamic>(StreamingLevel);
+		if (!Level)
+		{
+			continue;
+		}
+
+		// Named <Map>_Cell_<X>_<Y>, under a PIE prefix in the editor
+		FString Coordinates;
+		FString X;
+		FString Y;
+		const FString Name = FPackageName::GetShortName(Level->GetWorldAssetPackageName());
+		if (!Name.Split(FishingStreaming::CellTag, nullptr, &Coordinates, ESearchCase::IgnoreCase, ESearchDir::FromEnd)
+			|| !Coordinates.Split(TEXT("_"), &X, &Y) || !X.IsNumeric() || !Y.IsNumeric())
+		{
+			continue;
+		}
+
+		const FIntPoint Key(FCString::Atoi(*X), FCString::Atoi(*Y));
+		FStreamingCell& Cell = Cells.Add(Key);
+		Cell.Level = Level;
+		Cell.Bounds = FBox2D(FVector2D(Key) * CellSize, FVector2D(Key + FIntPoint(1, 1)) * CellSize);
+	}
+
+	if (Cells.Num() > 0)
+	{
+		UE_LOG(LogFishingGame, Log, TEXT("Fishing streaming: %d cells of %.0f m in %s"), Cells.Num(), CellSize / 100.f, *World->GetMapName());
+	}
+}
+
+void UFishingStreamingSubsystem::UpdateStreaming()
+{
+	FISHING_SCOPE(Streaming);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	Hints.RemoveAllSwap([Now](const FHint& Hint) { return Hint.ExpireTime <= Now; }, false);
+
+	// Nobody to stream for yet, e.g. before the pawn spawned: whatever is loaded stays
+	if (PawnLocations.Num() == 0)
+	{
+		return;
+	}
+
+	const float LoadRadiusSq = FMath::Square(LoadRadius);
+	const float UnloadRadiusSq = FMath::Square(UnloadRadius);
+	const float HintRadiusSq = FMath::Square(HintRadius);
+
+	LoadQueue.Reset();
+	NumLoaded = 0;
+	int32 NumPending = 0;
+	for (TPair<FIntPoint, FStreamingCell>& Pair : Cells)
+	{
+		FStreamingCell& Cell = Pair.Value;
+		ULevelStreamingDynamic* Level = Cell.Level.Get();
+		if (!Level)
+		{
+			continue;
+		}
+
+		Cell.DistanceSq = MAX_flt;
+		for (const FVector2D& Location : PawnLocations)
+		{
+			Cell.DistanceSq = FMath::Min(Cell.DistanceSq, Cell.Bounds.ComputeSquaredDistanceToPoint(Location));
+		}
+		Cell.bHinted = false;
+		for (const FHint& Hint : Hints)
+		{
+			Cell.bHinted |= Cell.Bounds.ComputeSquaredDistanceToPoint(Hint.Location) < HintRadiusSq;
+		}
+
+		if (Level->ShouldBeLoaded())
+		{
+			// Past UnloadRadius rather than LoadRadius, so a pawn pacing along the edge doesn't reload the cell every few steps
+			if (Cell.DistanceSq > UnloadRadiusSq && !Cell.bHinted)
+			{
+				Level->SetShouldBeLoaded(false);
+				Level->SetShouldBeVisible(false);
+				if (Lap.IsSet())
+				{
+					++Lap->CellUnloads;
+				}
+				continue;
+			}
+
+			++NumLoaded;
+			if (!Level->IsLevelVisible())
+			{
+				++NumPending;
+			}
+		}
+		else if (Cell.DistanceSq < LoadRadiusSq || Cell.bHinted)
+		{
+			LoadQueue.Add(&Cell);
+		}
+	}
+
+	// Where the hook lands first, then closest first
+	LoadQueue.Sort([](const FStreamingCell& A, const FStreamingCell& B)
+	{
+		return A.bHinted != B.bHinted ? A.bHinted : A.DistanceSq < B.DistanceSq;
+	});
+
+	for (FStreamingCell* Cell : LoadQueue)
+	{
+		if (NumPending >= MaxPendingLoads)
+		{
+			break;
+		}
+
+		ULevelStreamingDynamic* Level = Cell->Level.Get();
+		Level->SetShouldBeLoaded(true);
+		Level->SetShouldBeVisible(true);
+		++NumPending;
+		++NumLoaded;
+		if (Lap.IsSet())
+		{
+			++Lap->CellLoads;
+		}
+	}
+}
+
+void UFishingStreamingSubsystem::FlushCellsUnderPawns()
+{
+	// Remote pawns only get their cells streamed, a server must not hitch every other player for one who walked too fast
+	for (int32 Index = 0; Index < NumLocalPawns; ++Index)
+	{
+		const FStreamingCell* Cell = FindCellAt(PawnLocations[Index]);
+		ULevelStreamingDynamic* Level = Cell ? Cell->Level.Get() : nullptr;
+		if (!Level || Level->IsLevelVisible())
+		{
+			continue;
+		}
+
+		// Streaming fell behind and the pawn would fall through the ground: wait for it
+		if (!Level->ShouldBeLoaded())
+		{
+			Level->SetShouldBeLoaded(true);
+			Level->SetShouldBeVisible(true);
+			++NumLoaded;
+		}
+
+		const double StallStart = FPlatformTime::Seconds();
+		GetWorld()->FlushLevelStreaming(EFlushLevelStreamingType::Visibility);
+		const double StallSeconds = FPlatformTime::Seconds() - StallStart;
+
+		// Nothing was streamed in before the pawn first showed up, waiting for its cell is just part of loading the map
+		if (!bStartCellsLoaded)
+		{
+			UE_LOG(LogFishingGame, Log, TEXT("Fishing streaming: loaded start cell %s in %.1f ms"), *FPackageName::GetShortName(Level->GetWorldAssetPackageName()), StallSeconds * 1000.0);
+			continue;
+		}
+
+		FISHING_EVENT(TEXT("StreamingStall"));
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing streaming: stalled %.1f ms on %s"), StallSeconds * 1000.0, *FPackageName::GetShortName(Level->GetWorldAssetPackageName()));
+
+		if (Lap.IsSet())
+		{
+			++Lap->Stalls;
+			Lap->StallSeconds += StallSeconds;
+			Lap->MaxStallSeconds = FMath::Max(Lap->MaxStallSeconds, StallSeconds);
+		}
+	}
+
+	bStartCellsLoaded |= NumLocalPawns > 0;
+}
+
+void UFishingStreamingSubsystem::GetPawnLocations(TArray<FVector2D>& OutLocations, int32& OutNumLocal) const
+{
+	// Every player pawn this world simulates: a client's own, all of them on a server. Locally controlled ones first
+	OutLocations.Reset();
+	OutNumLocal = 0;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		if (const APawn* Pawn = PC ? PC->GetPawn() : nullptr)
+		{
+			if (PC->IsLocalController())
+			{
+				OutLocations.Insert(FVector2D(Pawn->GetActorLocation()), OutNumLocal++);
+			}
+			else
+			{
+				OutLocations.Add(FVector2D(Pawn->GetActorLocation()));
+			}
+		}
+	}
+}
+
+const UFishingStreamingSubsystem::FStreamingCell* UFishingStreamingSubsystem::FindCellAt(const FVector2D& Location) const
+{
+	const FIntPoint Key(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	return Cells.Find(Key);
+}
+
+void UFishingStreamingSubsystem::StartLap(float Radius, float MaxSeconds)
+{
+	if (Lap.IsSet())
+	{
+		return;
+	}
+
+	const APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = PC ? PC->GetPawn() : nullptr;
+	if (Cells.Num() == 0 || !Pawn)
+	{
+		UE_LOG(LogFishingGame, Warning, TEXT("Fishing streaming: a lap needs streamed cells and a local pawn"));
+		return;
+	}
+
+	FBox2D Grid(ForceInit);
+	for (const TPair<FIntPoint, FStreamingCell>& Pair : Cells)
+	{
+		Grid += Pair.Value.Bounds;
+	}
+
+	Lap.Emplace();
+	FLap& NewLap = *Lap;
+	NewLap.Center = Grid.GetCenter();
+	NewLap.Radius = Radius > 0.f ? Radius : 0.4f * FMath::Min(Grid.GetSize().X, Grid.GetSize().Y);
+	NewLap.MaxTime = MaxSeconds;
+	NewLap.Pawn = Pawn;
+
+	const FVector2D Offset = FVector2D(Pawn->GetActorLocation()) - NewLap.Center;
+	NewLap.Angle = FMath::Atan2(Offset.Y, Offset.X);
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing streaming: walking a lap of %.0f m around %s"), NewLap.Radius / 100.f, *NewLap.Center.ToString());
+
+#if CSV_PROFILER
+	if (!FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture(-1, FPaths::ProfilingDir() / TEXT("FishingStreaming"), FString::Printf(TEXT("FishingStreamingLap-%s.csv"), *FDateTime::Now().ToString()));
+		bCapturingCsv = true;
+	}
+#endif
+}
+
+void UFishingStreamingSubsystem::StepLap(float DeltaTime)
+{
+	FLap& Current = *Lap;
+	APawn* Pawn = Current.Pawn.Get();
+	if (!Pawn)
+	{
+		EndLap();
+		return;
+	}
+
+	// Progress is the angle swept around the center, however far the pawn strayed from the circle to get around obstacles
+	const FVector2D Offset = FVector2D(Pawn->GetActorLocation()) - Current.Center;
+	const float Angle = FMath::Atan2(Offset.Y, Offset.X);
+	Current.Travelled += FMath::FindDeltaAngleRadians(Current.Angle, Angle);
+	Current.Angle = Angle;
+	Current.Time += DeltaTime;
+	if (FMath::Abs(Current.Travelled) >= 2.f * PI || Current.Time >= Current.MaxTime)
+	{
+		EndLap();
+		return;
+	}
+
+	const float Ahead = Angle + FishingStreaming::LapLookAhead;
+	const FVector2D Target = Current.Center + FVector2D(FMath::Cos(Ahead), FMath::Sin(Ahead)) * Current.Radius;
+	Pawn->AddMovementInput(FVector(Target - FVector2D(Pawn->GetActorLocation()), 0.f).GetSafeNormal());
+}
+
+void UFishingStreamingSubsystem::EndLap()
+{
+	if (!Lap.IsSet())
+	{
+		return;
+	}
+
+#if CSV_PROFILER
+	if (bCapturingCsv)
+	{
+		FCsvProfiler::Get()->EndCapture();
+		bCapturingCsv = false;
+	}
+#endif
+
+	const FLap& Done = *Lap;
+	const int32 Frames = FMath::Max(Done.Frames, 1);
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing streaming lap: %s after %.1f s (%.0f of 360 degrees) over %d cells"),
+		FMath::Abs(Done.Travelled) >= 2.f * PI ? TEXT("done") : TEXT("gave up"), Done.Time, FMath::RadiansToDegrees(FMath::Abs(Done.Travelled)), Cells.Num());
+	UE_LOG(LogFishingGame, Display, TEXT("  %d loads, %d unloads, cells resident avg %.1f peak %d, used memory avg %.0f MB peak %.0f MB"),
+		Done.CellLoads, Done.CellUnloads, (float)Done.SumLoadedCells / Frames, Done.PeakLoadedCells, Done.SumUsedMB / Frames, Done.PeakUsedMB);
+	UE_LOG(LogFishingGame, Display, TEXT("  %d load stalls, %.1f ms in total, worst %.1f ms"),
+		Done.Stalls, Done.StallSeconds * 1000.0, Done.MaxStallSeconds * 1000.0);
+
+	Lap.Reset();
+}
@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingWaveSubsystem.h"
+#include "FishingGame.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+
+namespace FishingWaves
+{
+	// Parameter names as authored in MPC_Lake, including the trailing space of the speed
+	static const FName AmplitudeName(TEXT("Amplitude"));
+	static const FName SteepnessName(TEXT("Steepness"));
+	static const FName WaveLengthName(TEXT("Wave Length"));
+	static const FName WaveSpeedName(TEXT("Gerstner Wave Speed "));
+	static const FName GlobalSpeedName(TEXT("Wave Speed Global"));
+	static const FName NumWavesName(TEXT("Number of Summed Waves"));
+	static const FName WindDirectionName(TEXT("Wind Direction"));
+
+	static FFishingWaveComponent MakeWave(float DirectionX, float DirectionY, float WaveLengthScale, float SpeedScale, float AmplitudeScale)
+	{
+		FFishingWaveComponent Wave;
+		Wave.Direction = FVector2D(DirectionX, DirectionY);
+		Wave.WaveLengthScale = WaveLengthScale;
+		Wave.SpeedScale = SpeedScale;
+		Wave.AmplitudeScale = AmplitudeScale;
+		return Wave;
+	}
+}
+
+UFishingWaveSubsystem::UFishingWaveSubsystem()
+{
+	WaveCollection = TSoftObjectPtr<UMaterialParameterCollection>(FSoftObjectPath(TEXT("/Game/CartoonWaterShader/Materials/MaterialCollections/MPC_Lake.MPC_Lake")));
+
+	// The twelve MF_GerstnerWave calls of MF_GerstnerWave_Combined: Direction, then the Wavelength, WaveSpeed and Amplitude multipliers
+	Waves.Add(FishingWaves::MakeWave(0.7f, 0.7f, 100.f, 1.24f, 15.9f));
+	Waves.Add(FishingWaves::MakeWave(0.1f, 0.7f, 70.f, 1.04f, 11.1f));
+	Waves.Add(FishingWaves::MakeWave(0.75f, 0.2f, 130.f, 1.42f, 20.6f));
+	Waves.Add(FishingWaves::MakeWave(0.7f, 0.15f, 85.f, 1.15f, 13.5f));
+	Waves.Add(FishingWaves::MakeWave(0.75f, 0.45f, 39.f, 2.4f, 6.2f));
+	Waves.Add(FishingWaves::MakeWave(0.4f, 0.85f, 68.f, 3.2f, 10.8f));
+	Waves.Add(FishingWaves::MakeWave(0.45f, 0.7f, 47.f, 2.7f, 7.4f));
+	Waves.Add(FishingWaves::MakeWave(0.6f, 0.8f, 55.f, 2.9f, 8.7f));
+	Waves.Add(FishingWaves::MakeWave(0.4f, -0.2f, 31.f, 2.1f, 4.9f));
+	Waves.Add(FishingWaves::MakeWave(0.9f, 0.65f, 25.f, 1.9f, 3.9f));
+	Waves.Add(FishingWaves::MakeWave(0.45f, 0.9f, 16.f, 1.5f, 2.5f));
+	Waves.Add(FishingWaves::MakeWave(0.15f, -0.15f, 20.f, 1.76f, 3.1f));
+}
+
+void UFishingWaveSubsystem::Initialize(FSubsystemCollectionBase& SubsystemCollection)
+{
+	Super::Initialize(SubsystemCollection);
+
+	// With the map rather than on the first hook that lands
+	if (!WaveCollection.IsNull())
+	{
+		Collection = WaveCollection.LoadSynchronous();
+	}
+}
+
+void UFishingWaveSubsystem::Deinitialize()
+{
+	Floaters.Empty();
+	Collection = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UFishingWaveSubsystem::Refresh()
+{
+	UWorld* World = GetWorld();
+	if (RefreshFrame == GFrameCounter || !World)
+	{
+		return;
+	}
+	RefreshFrame = GFrameCounter;
+
+	// Same clock as the material's Time node
+	WaveTime = World->GetTimeSeconds();
+
+	if (UMaterialParameterCollectionInstance* Instance = Collection ? World->GetParameterCollectionInstance(Collection) : nullptr)
+	{
+		float WaveSpeed = 1.f;
+		float GlobalSpeed = 1.f;
+		Instance->GetScalarParameterValue(FishingWaves::AmplitudeName, Params.Amplitude);
+		Instance->GetScalarParameterValue(FishingWaves::SteepnessName, Params.Steepness);
+		Instance->GetScalarParameterValue(FishingWaves::WaveLengthName, Params.WaveLength);
+		Instance->GetScalarParameterValue(FishingWaves::WaveSpeedName, WaveSpeed);
+		Instance->GetScalarParameterValue(FishingWaves::GlobalSpeedName, GlobalSpeed);
+		Instance->GetScalarParameterValue(FishingWaves::NumWavesName, Params.NumWaves);
+		Instance->GetScalarParameterValue(FishingWaves::WindDirectionName, Params.WindDirection);
+
+		Params.Speed = WaveSpeed * GlobalSpeed;
+		Params.WaveLength = FMath::Max(Params.WaveLength, KINDA_SMALL_NUMBER);
+		Params.NumWaves = FMath::Max(Params.NumWaves, 1.f);
+	}
+
+	WaveLanes.Reset(Waves.Num());
+	for (const FFishingWaveComponent& Wave : Waves)
+	{
+		const FVector2D Direction = Wave.Direction.GetRotated(Params.WindDirection * 360.f).GetSafeNormal();
+		const double DirX = Direction.X;
+		const double DirY = Direction.Y;
+		const double Amplitude = Params.Amplitude * Wave.AmplitudeScale;
+		const double K = 2.0 * PI / (Params.WaveLength * Wave.WaveLengthScale);
+		const double Omega = K * Params.Speed * Wave.SpeedScale;
+		const double QA = Amplitude > 0.0 ? Params.Steepness / (K * Params.NumWaves) : 0.0;
+
+		// Reduce the time term here in double precision, the lanes only see a phase within one turn
+		const double PhaseShift = FMath::Fmod(Omega * WaveTime, 2.0 * PI);
+
+		FWaveLanes& Lanes = WaveLanes.AddDefaulted_GetRef();
+		Lanes.KDirX = VectorSetFloat1((float)(K * DirX));
+		Lanes.KDirY = VectorSetFloat1((float)(K * DirY));
+		Lanes.PhaseShift = VectorSetFloat1((float)PhaseShift);
+		Lanes.QADirX = VectorSetFloat1((float)(QA * DirX));
+		Lanes.QADirY = VectorSetFloat1((float)(QA * DirY));
+		Lanes.Amplitude = VectorSetFloat1((float)Amplitude);
+	}
+}
+
+FVector UFishingWaveSubsystem::GetReferenceDisplacement(const FVector2D& Point, double Time)
+{
+	Refresh();
+
+	// MF_GerstnerWave_Combined adds up one MF_GerstnerWave per wave, its inputs scaled by the wave's constants
+	FVector Displacement = FVector::ZeroVector;
+	for (const FFishingWaveComponent& Wave : Waves)
+	{
+		const double Wavelength = (double)Params.WaveLength * Wave.WaveLengthScale;
+		const double WaveSpeed = (double)Params.Speed * Wave.SpeedScale;
+		const double Amplitude = (double)Params.Amplitude * Wave.AmplitudeScale;
+
+		// CustomRotator around (0, 0) by a fraction of a turn, then Normalize
+		const double Rotation = Params.WindDirection * 2.0 * PI;
+		const double RotatedX = Wave.Direction.X * FMath::Cos(Rotation) - Wave.Direction.Y * FMath::Sin(Rotation);
+		const double RotatedY = Wave.Direction.X * FMath::Sin(Rotation) + Wave.Direction.Y * FMath::Cos(Rotation);
+		const double Length = FMath::Sqrt(RotatedX * RotatedX + RotatedY * RotatedY);
+		const double DirX = RotatedX / Length;
+		const double DirY = RotatedY / Length;
+
+		// Pi(2) / Wavelength
+		const double W = 2.0 * PI / Wavelength;
+
+		// Steepness / (numWaves * W * Amplitude)
+		const double Q = Amplitude > 0.0 ? Params.Steepness / (Params.NumWaves * W * Amplitude) : 0.0;
+
+		// DotProduct(Direction, WorldPosition.xy) * W + W * WaveSpeed * Time, into Sine and Cosine of period 2 pi
+		const double Theta = (DirX * Point.X + DirY * Point.Y) * W + W * WaveSpeed * Time;
+
+		// MakeFloat3(Q * Amplitude * Direction.x * Cosine, Q * Amplitude * Direction.y * Cosine, Sine * Amplitude)
+		Displacement.X += Q * Amplitude * DirX * FMath::Cos(Theta);
+		Displacement.Y += Q * Amplitude * DirY * FMath::Cos(Theta);
+		Displacement.Z += FMath::Sin(Theta) * Amplitude;
+	}
+	return Displacement;
+}
+
+void UFishingWaveSubsystem::GetDisplacement4(VectorRegister X, VectorRegister Y, VectorRegister& OutX, VectorRegister& OutY, VectorRegister& OutZ) const
+{
+	OutX = VectorZero();
+	OutY = VectorZero();
+	OutZ = VectorZero();
+
+	for (const FWaveLanes& Wave : WaveLanes)
+	{
+		const VectorRegister Theta = VectorAdd(VectorMultiplyAdd(Wave.KDirX, X, VectorMultiply(Wave.KDirY, Y)), Wave.PhaseShift);
+
+		VectorRegister Sin;
+		VectorRegister Cos;
+		VectorSinCos(&Sin, &Cos, &Theta);
+
+		OutX = VectorMultiplyAdd(Wave.QADirX, Cos, OutX);
+		OutY = VectorMultiplyAdd(Wave.QADirY, Cos, OutY);
+		OutZ = VectorMultiplyAdd(Wave.Amplitude, Sin, OutZ);
+	}
+}
+
+void UFishingWaveSubsystem::GetWaveHeights4(VectorRegister X, VectorRegister Y, VectorRegister& OutHeight) const
+{
+	// Find the rest position whose vertex ends up above (X, Y)
+	VectorRegister RestX = X;
+	VectorRegister RestY = Y;
+	VectorRegister DispX, DispY, DispZ;
+	for (int32 Iteration = 0; Iteration < HeightIterations; ++Iteration)
+	{
+		GetDisplacement4(RestX, RestY, DispX, DispY, DispZ);
+		RestX = VectorSubtract(X, DispX);
+		RestY = VectorSubtract(Y, DispY);
+	}
+
+	GetDisplacement4(RestX, RestY, DispX, DispY, OutHeight);
+}
+
+void UFishingWaveSubsystem::GetWaveHeights(TArrayView<const FVector2D> Points, TArrayView<float> OutHeights)
+{
+	check(OutHeights.Num() >= Points.Num());
+	Refresh();
+
+	const int32 NumPoints = Points.Num();
+	const int32 NumFull = NumPoints & ~3;
+
+	MS_ALIGN(16) float Xs[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float Ys[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float Heights[4] GCC_ALIGN(16);
+
+	for (int32 First = 0; First < NumPoints; First += 4)
+	{
+		const int32 Count = First < NumFull ? 4 : NumPoints - First;
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			// Pad the tail by repeating the last point
+			const FVector2D& Point = Points[First + FMath::Min(Lane, Count - 1)];
+			Xs[Lane] = Point.X;
+			Ys[Lane] = Point.Y;
+		}
+
+		VectorRegister Height;
+		GetWaveHeights4(VectorLoadAligned(Xs), VectorLoadAligned(Ys), Height);
+		VectorStoreAligned(Height, Heights);
+
+		FMemory::Memcpy(&OutHeights[First], Heights, Count * sizeof(float));
+	}
+}
+
+float UFishingWaveSubsystem::GetWaterSurfaceHeight(FVector Location, float RestHeight)
+{
+	const FVector2D Point(Location);
+	float Height = 0.f;
+	GetWaveHeights(MakeArrayView(&Point, 1), MakeArrayView(&Height, 1));
+	return RestHeight + Height;
+}
+
+void UFishingWaveSubsystem::AddFloater(USceneComponent* Component, float RestHeight, float Offset)
+{
+	if (!Component || Component->Mobility != EComponentMobility::Movable)
+	{
+		return;
+	}
+
+	RemoveFloater(Component);
+	Floaters.Add({ Component, FVector2D(Component->GetComponentLocation()), RestHeight, Offset });
+}
+
+void UFishingWaveSubsystem::RemoveFloater(USceneComponent* Component)
+{
+	Floaters.RemoveAllSwap([Component](const FFloater& Floater) { return Floater.Component == Component; });
+}
+
+void UFishingWaveSubsystem::Tick(float DeltaTime)
+{
+	Floaters.RemoveAllSwap([](const FFloater& Floater) { return !Floater.Component.IsValid(); });
+
+	FloaterPoints.Reset(Floaters.Num());
+	for (const FFloater& Floater : Floaters)
+	{
+		FloaterPoints.Add(Floater.Location);
+	}
+	FloaterHeights.SetNumUninitialized(Floaters.Num(), false);
+
+	GetWaveHeights(FloaterPoints, FloaterHeights);
+
+	for (int32 Index = 0; Index < Floaters.Num(); ++Index)
+	{
+		const FFloater& Floater = Floaters[Index];
+		Floater.Component->SetWorldLocation(FVector(Floater.Location, Floater.RestHeight + FloaterHeights[Index] + Floater.Offset));
+	}
+}
+
+TStatId UFishingWaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFishingWaveSubsystem, STATGROUP_Tickables);
+}
+
+namespace FishingWaves
+{
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.WaveBench"),
+		TEXT("Times a batch of wave height queries and checks them against MF_GerstnerWave evaluated node for node. Usage: Fishing.WaveBench [Queries=100000]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UFishingWaveSubsystem* WaveSubsystem = World ? World->GetSubsystem<UFishingWaveSubsystem>() : nullptr;
+			if (!WaveSubsystem)
+			{
+				return;
+			}
+
+			const int32 NumQueries = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000);
+
+			FRandomStream Random(0xB0B);
+			TArray<FVector2D> Points;
+			Points.Reserve(NumQueries);
+			for (int32 Index = 0; Index < NumQueries; ++Index)
+			{
+				Points.Emplace(Random.FRandRange(-50000.f, 50000.f), Random.FRandRange(-50000.f, 50000.f));
+			}
+
+			TArray<float> Heights;
+			Heights.SetNumUninitialized(NumQueries);
+			const double Start = FPlatformTime::Seconds();
+			WaveSubsystem->GetWaveHeights(Points, Heights);
+			const double BatchMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+			// The vertex displaced to each point must sit at the height the batch reported
+			const double Time = WaveSubsystem->GetWaveTime();
+			double MaxError = 0.0;
+			const int32 NumChecked = FMath::Min(NumQueries, 10000);
+			for (int32 Index = 0; Index < NumChecked; ++Index)
+			{
+				const FVector2D Target = Points[Index];
+				FVector2D Rest = Target;
+				FVector Displacement = FVector::ZeroVector;
+				for (int32 Iteration = 0; Iteration < 16; ++Iteration)
+				{
+					Displacement = WaveSubsystem->GetReferenceDisplacement(Rest, Time);
+					Rest = Target - FVector2D(Displacement);
+				}
+				Displacement = WaveSubsystem->GetReferenceDisplacement(Rest, Time);
+				MaxError = FMath::Max(MaxError, (double)FMath::Abs(Displacement.Z - Heights[Index]));
+			}
+
+			static constexpr double Tolerance = 0.5;
+			UE_LOG(LogFishingGame, Display, TEXT("Wave bench: %d queries in %.3f ms (%.1f ns each), max error %.4f cm over %d points: %s"),
+				NumQueries, BatchMs, BatchMs * 1e6 / NumQueries, MaxError, NumChecked, MaxError <= Tolerance ? TEXT("within tolerance") : TEXT("OUT OF TOLERANCE"));
+		}));
+}
@@ -3,36 +3,70 @@
 
 #include "FishingZone.h"
 #include "Components/BoxComponent.h"
-#include "FishingGameCharacter.h"
-#include "FishingGamePlayerController.h"
+#include "Engine/World.h"
+#include "FishingZoneSubsystem.h"
+#include "FishSchoolSubsystem.h"
+#include "FishingLootTable.h"
 
 AFishingZone::AFishingZone()
 {
 	PrimaryActorTick.bCanEverTick = false;
 
+	// Hooks find their zone through UFishingZoneSubsystem, the box only describes the zone's volume
 	BoxComp = CreateDefaultSubobject<UBoxComponent>(TEXT("Collision Zone"));
-	BoxComp->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	BoxComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	BoxComp->SetCollisionResponseToAllChannels(ECR_Ignore);
-	BoxComp->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECR_Overlap);
+	BoxComp->SetGenerateOverlapEvents(false);
+	BoxComp->bWantsOnUpdateTransform = true;
 }
 
-void AFishingZone::NotifyActorBeginOverlap(AActor* OtherActor)
+void AFishingZone::BeginPlay()
 {
-	Super::NotifyActorBeginOverlap(OtherActor);
+	Super::BeginPlay();
 
-	if (AFishingGameCharacter* PCharacter = Cast<AFishingGameCharacter>(OtherActor))
+	if (UFishingZoneSubsystem* ZoneSubsystem = GetWorld()->GetSubsystem<UFishingZoneSubsystem>())
 	{
-		if (AFishingGamePlayerController* PController = Cast<AFishingGamePlayerController>(PCharacter->GetController()))
-		{
-			if (!PController->GetIsFishing() && PController->GetInTransition())
-			{
-				if (UStaticMeshComponent* Hook = PCharacter->GetHookMesh())
-				{
-					Hook->SetSimulatePhysics(false);
-					Hook->SetMobility(EComponentMobility::Static);
-				}
-			}
-		}
+		ZoneSubsystem->RegisterZone(this);
+		BoxComp->TransformUpdated.AddUObject(this, &AFishingZone::OnZoneMoved);
+	}
+
+	if (UFishingLootSubsystem* Loot = GetWorld()->GetSubsystem<UFishingLootSubsystem>())
+	{
+		Loot->PrepareTable(LootTable);
+	}
+
+	if (UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>())
+	{
+		FishSchools->AddZone(this);
 	}
 }
 
+void AFishingZone::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	BoxComp->TransformUpdated.RemoveAll(this);
+
+	if (UFishSchoolSubsystem* FishSchools = GetWorld()->GetSubsystem<UFishSchoolSubsystem>())
+	{
+		FishSchools->RemoveZone(this);
+	}
+
+	if (UFishingZoneSubsystem* ZoneSubsystem = GetWorld()->GetSubsystem<UFishingZoneSubsystem>())
+	{
+		ZoneSubsystem->UnregisterZone(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float AFishingZone::GetWaterLevel() const
+{
+	return BoxComp->Bounds.GetBox().Max.Z;
+}
+
+void AFishingZone::OnZoneMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (UFishingZoneSubsystem* ZoneSubsystem = GetWorld()->GetSubsystem<UFishingZoneSubsystem>())
+	{
+		ZoneSubsystem->UpdateZone(this);
+	}
+}
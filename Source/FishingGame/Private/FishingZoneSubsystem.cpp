@@ -0,0 +1,370 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FishingZoneSubsystem.h"
+#include "FishingGame.h"
+#include "FishingZone.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace FishingZones
+{
+	static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+		TEXT("Fishing.ZoneBench"),
+		TEXT("Times point and segment queries and moving zones on a throwaway registry of synthetic zones spread over a large map, ")
+		TEXT("against testing every zone. Usage: Fishing.ZoneBench [Zones=5000] [Queries=100000]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World)
+			{
+				return;
+			}
+
+			const int32 NumZones = FMath::Max(1, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 5000);
+			const int32 NumQueries = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100000);
+
+			// Kept out of the world's own zones, which go on untouched
+			UFishingZoneSubsystem* Bench = NewObject<UFishingZoneSubsystem>(World);
+			Bench->RunBenchmark(NumZones, NumQueries);
+			Bench->MarkPendingKill();
+		}));
+}
+
+void UFishingZoneSubsystem::RegisterZone(AFishingZone* Zone)
+{
+	if (!Zone || EntryByZone.Contains(Zone))
+	{
+		return;
+	}
+
+	const int32 EntryIndex = FreeEntries.Num() > 0 ? FreeEntries.Pop(false) : Entries.AddDefaulted();
+	FZoneEntry& Entry = Entries[EntryIndex];
+	const UBoxComponent* Box = Zone->GetZoneBox();
+	SetEntryBox(Entry, Box->GetComponentTransform(), Box->GetUnscaledBoxExtent());
+	Entry.Zone = Zone;
+
+	EntryByZone.Add(Zone, EntryIndex);
+	AddToCells(EntryIndex, Entry.Cells);
+	++NumZones;
+}
+
+void UFishingZoneSubsystem::UnregisterZone(AFishingZone* Zone)
+{
+	int32 EntryIndex;
+	if (EntryByZone.RemoveAndCopyValue(Zone, EntryIndex))
+	{
+		FZoneEntry& Entry = Entries[EntryIndex];
+		RemoveFromCells(EntryIndex, Entry.Cells);
+		Entry = FZoneEntry();
+		FreeEntries.Add(EntryIndex);
+		--NumZones;
+	}
+}
+
+void UFishingZoneSubsystem::UpdateZone(AFishingZone* Zone)
+{
+	if (const int32* EntryIndex = EntryByZone.Find(Zone))
+	{
+		const UBoxComponent* Box = Zone->GetZoneBox();
+		MoveEntry(*EntryIndex, Box->GetComponentTransform(), Box->GetUnscaledBoxExtent());
+	}
+}
+
+void UFishingZoneSubsystem::MoveEntry(int32 EntryIndex, const FTransform& Transform, const FVector& Extent)
+{
+	FZoneEntry& Entry = Entries[EntryIndex];
+	const FIntRect OldCells = Entry.Cells;
+	SetEntryBox(Entry, Transform, Extent);
+
+	// Cells in both rects keep the entry as they are
+	if (Entry.Cells != OldCells)
+	{
+		RemoveFromCells(EntryIndex, OldCells, &Entry.Cells);
+		AddToCells(EntryIndex, Entry.Cells, &OldCells);
+	}
+}
+
+AFishingZone* UFishingZoneSubsystem::FindZoneAtPoint(const FVector& Point) const
+{
+	return GetZone(FindZoneIndexAtPoint(Point));
+}
+
+int32 UFishingZoneSubsystem::FindZoneIndexAtPoint(const FVector& Point) const
+{
+	if (const TArray<int32>* Cell = Grid.Find(GetCell(Point)))
+	{
+		for (int32 EntryIndex : *Cell)
+		{
+			if (ContainsPoint(Entries[EntryIndex], Point))
+			{
+				return EntryIndex;
+			}
+		}
+	}
+	return INDEX_NONE;
+}
+
+AFishingZone* UFishingZoneSubsystem::FindZoneAlongSegment(const FVector& Start, const FVector& End, FVector* OutEntryPoint) const
+{
+	// Walk the cells the segment crosses in order (Amanatides & Woo), stopping at the first cell holding a hit
+	const FVector2D Start2D(Start);
+	const FVector2D Delta2D = FVector2D(End) - Start2D;
+
+	FIntPoint Cell = GetCell(Start);
+	const FIntPoint LastCell = GetCell(End);
+	const FIntPoint Step(Delta2D.X >= 0.f ? 1 : -1, Delta2D.Y >= 0.f ? 1 : -1);
+
+	auto FirstCrossing = [](float Origin, float Direction, int32 CellCoord, int32 CellStep)
+	{
+		if (FMath::IsNearlyZero(Direction))
+		{
+			return BIG_NUMBER;
+		}
+		const float Boundary = (CellCoord + (CellStep > 0 ? 1 : 0)) * CellSize;
+		return (Boundary - Origin) / Direction;
+	};
+
+	float NextX = FirstCrossing(Start2D.X, Delta2D.X, Cell.X, Step.X);
+	float NextY = FirstCrossing(Start2D.Y, Delta2D.Y, Cell.Y, Step.Y);
+	const float StepX = FMath::IsNearlyZero(Delta2D.X) ? BIG_NUMBER : CellSize / FMath::Abs(Delta2D.X);
+	const float StepY = FMath::IsNearlyZero(Delta2D.Y) ? BIG_NUMBER : CellSize / FMath::Abs(Delta2D.Y);
+
+	while (true)
+	{
+		if (const TArray<int32>* Bucket = Grid.Find(Cell))
+		{
+			float BestTime = BIG_NUMBER;
+			int32 BestEntry = INDEX_NONE;
+			for (int32 EntryIndex : *Bucket)
+			{
+				const float EntryTime = GetSegmentEntryTime(Entries[EntryIndex], Start, End);
+				if (EntryTime >= 0.f && EntryTime < BestTime)
+				{
+					BestTime = EntryTime;
+					BestEntry = EntryIndex;
+				}
+			}
+
+			// A zone spanning several cells may be entered beyond this cell, only accept hits inside it
+			const float CellExit = FMath::Min(FMath::Min(NextX, NextY), 1.f);
+			if (BestEntry != INDEX_NONE && BestTime <= CellExit)
+			{
+				if (OutEntryPoint)
+				{
+					*OutEntryPoint = FMath::Lerp(Start, End, BestTime);
+				}
+				return Entries[BestEntry].Zone.Get();
+			}
+		}
+
+		if (Cell == LastCell || FMath::Min(NextX, NextY) > 1.f)
+		{
+			break;
+		}
+
+		if (NextX < NextY)
+		{
+			Cell.X += Step.X;
+			NextX += StepX;
+		}
+		else
+		{
+			Cell.Y += Step.Y;
+			NextY += StepY;
+		}
+	}
+	return nullptr;
+}
+
+void UFishingZoneSubsystem::SetEntryBox(FZoneEntry& Entry, const FTransform& Transform, const FVector& Extent)
+{
+	Entry.Transform = Transform;
+	Entry.Extent = Extent;
+
+	// Same bounds as the box component's own
+	const FBox Bounds = FBox(-Extent, Extent).TransformBy(Transform);
+	const FIntPoint Min = GetCell(Bounds.Min);
+	const FIntPoint Max = GetCell(Bounds.Max);
+	Entry.Cells = FIntRect(Min, Max);
+}
+
+void UFishingZoneSubsystem::AddToCells(int32 EntryIndex, const FIntRect& Cells, const FIntRect* Skip)
+{
+	for (int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+	{
+		for (int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+		{
+			if (!Skip || !IsCellIn(*Skip, X, Y))
+			{
+				Grid.FindOrAdd(FIntPoint(X, Y)).Add(EntryIndex);
+			}
+		}
+	}
+}
+
+void UFishingZoneSubsystem::RemoveFromCells(int32 EntryIndex, const FIntRect& Cells, const FIntRect* Skip)
+{
+	for (int32 X = Cells.Min.X; X <= Cells.Max.X; ++X)
+	{
+		for (int32 Y = Cells.Min.Y; Y <= Cells.Max.Y; ++Y)
+		{
+			if (Skip && IsCellIn(*Skip, X, Y))
+			{
+				continue;
+			}
+
+			const FIntPoint CellKey(X, Y);
+			if (TArray<int32>* Bucket = Grid.Find(CellKey))
+			{
+				Bucket->RemoveSingleSwap(EntryIndex, false);
+				if (Bucket->Num() == 0)
+				{
+					Grid.Remove(CellKey);
+				}
+			}
+		}
+	}
+}
+
+bool UFishingZoneSubsystem::ContainsPoint(const FZoneEntry& Entry, const FVector& Point) const
+{
+	const FVector Local = Entry.Transform.InverseTransformPosition(Point);
+	return FMath::Abs(Local.X) <= Entry.Extent.X && FMath::Abs(Local.Y) <= Entry.Extent.Y && FMath::Abs(Local.Z) <= Entry.Extent.Z;
+}
+
+float UFishingZoneSubsystem::GetSegmentEntryTime(const FZoneEntry& Entry, const FVector& Start, const FVector& End) const
+{
+	// Slab test in the box's local space
+	const FVector LocalStart = Entry.Transform.InverseTransformPosition(Start);
+	const FVector LocalDelta = Entry.Transform.InverseTransformPosition(End) - LocalStart;
+
+	float EnterTime = 0.f;
+	float ExitTime = 1.f;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		if (FMath::IsNearlyZero(LocalDelta[Axis]))
+		{
+			if (FMath::Abs(LocalStart[Axis]) > Entry.Extent[Axis])
+			{
+				return -1.f;
+			}
+			continue;
+		}
+
+		float Near = (-Entry.Extent[Axis] - LocalStart[Axis]) / LocalDelta[Axis];
+		float Far = (Entry.Extent[Axis] - LocalStart[Axis]) / LocalDelta[Axis];
+		if (Near > Far)
+		{
+			Swap(Near, Far);
+		}
+
+		EnterTime = FMath::Max(EnterTime, Near);
+		ExitTime = FMath::Min(ExitTime, Far);
+		if (EnterTime > ExitTime)
+		{
+			return -1.f;
+		}
+	}
+	return EnterTime;
+}
+
+FIntPoint UFishingZoneSubsystem::GetCell(const FVector& Location)
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+bool UFishingZoneSubsystem::IsCellIn(const FIntRect& Cells, int32 X, int32 Y)
+{
+	return X >= Cells.Min.X && X <= Cells.Max.X && Y >= Cells.Min.Y && Y <= Cells.Max.Y;
+}
+
+void UFishingZoneSubsystem::RunBenchmark(int32 InNumZones, int32 NumQueries)
+{
+	// 3 km square map with 5 to 50 m zones at any yaw, the kind of spread a tournament lake has
+	const float MapHalfSize = 150000.f;
+	FRandomStream Random(0x20E5);
+	auto RandomTransform = [&Random, MapHalfSize]()
+	{
+		return FTransform(FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f), FVector(Random.FRandRange(-MapHalfSize, MapHalfSize), Random.FRandRange(-MapHalfSize, MapHalfSize), 0.f));
+	};
+
+	for (int32 Index = 0; Index < InNumZones; ++Index)
+	{
+		const int32 EntryIndex = Entries.AddDefaulted();
+		SetEntryBox(Entries[EntryIndex], RandomTransform(), FVector(Random.FRandRange(250.f, 2500.f), Random.FRandRange(250.f, 2500.f), 200.f));
+		AddToCells(EntryIndex, Entries[EntryIndex].Cells);
+	}
+	NumZones = InNumZones;
+
+	TArray<FVector> Points;
+	Points.SetNum(NumQueries);
+	for (FVector& Point : Points)
+	{
+		Point = FVector(Random.FRandRange(-MapHalfSize, MapHalfSize), Random.FRandRange(-MapHalfSize, MapHalfSize), Random.FRandRange(-100.f, 100.f));
+	}
+
+	// Point queries against testing every zone, which is what an overlap without a broadphase comes down to
+	int32 GridHits = 0;
+	int32 Mismatches = 0;
+	double Start = FPlatformTime::Seconds();
+	for (const FVector& Point : Points)
+	{
+		GridHits += FindZoneIndexAtPoint(Point) != INDEX_NONE;
+	}
+	const double GridMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+	const int32 NumLinear = FMath::Min(NumQueries, 10000);
+	TBitArray<> LinearHits(false, NumLinear);
+	Start = FPlatformTime::Seconds();
+	for (int32 Query = 0; Query < NumLinear; ++Query)
+	{
+		for (const FZoneEntry& Entry : Entries)
+		{
+			if (ContainsPoint(Entry, Points[Query]))
+			{
+				LinearHits[Query] = true;
+				break;
+			}
+		}
+	}
+	const double LinearMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+	for (int32 Query = 0; Query < NumLinear; ++Query)
+	{
+		Mismatches += LinearHits[Query] != (FindZoneIndexAtPoint(Points[Query]) != INDEX_NONE);
+	}
+
+	// Segments the length of a long cast
+	int32 SegmentHits = 0;
+	Start = FPlatformTime::Seconds();
+	for (const FVector& Point : Points)
+	{
+		// The synthetic zones have no actor to return, a hit shows in the entry point
+		FVector EntryPoint(MAX_flt);
+		FindZoneAlongSegment(Point, Point + FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f).Vector() * 3000.f, &EntryPoint);
+		SegmentHits += EntryPoint.X != MAX_flt;
+	}
+	const double SegmentMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+	// Every zone drifting a few meters, most of them staying in their cells
+	Start = FPlatformTime::Seconds();
+	for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+	{
+		FTransform Transform = Entries[EntryIndex].Transform;
+		Transform.AddToTranslation(FVector(Random.FRandRange(-500.f, 500.f), Random.FRandRange(-500.f, 500.f), 0.f));
+		MoveEntry(EntryIndex, Transform, Entries[EntryIndex].Extent);
+	}
+	const double MoveMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+	UE_LOG(LogFishingGame, Display, TEXT("Fishing zone bench: %d zones over %.0f km2 in %d grid cells"),
+		NumZones, FMath::Square(2.f * MapHalfSize / 100000.f), Grid.Num());
+	UE_LOG(LogFishingGame, Display, TEXT("  point queries:   %.3f us each with the grid, %.3f us testing every zone, %d of %d in a zone%s"),
+		GridMs * 1000.0 / NumQueries, LinearMs * 1000.0 / NumLinear, GridHits, NumQueries, Mismatches == 0 ? TEXT("") : *FString::Printf(TEXT(", %d RESULTS DIFFER"), Mismatches));
+	UE_LOG(LogFishingGame, Display, TEXT("  segment queries: %.3f us each over 30 m, %d hits"), SegmentMs * 1000.0 / NumQueries, SegmentHits);
+	UE_LOG(LogFishingGame, Display, TEXT("  moving every zone: %.3f ms, %.3f us a zone"), MoveMs, MoveMs * 1000.0 / NumZones);
+
+	Entries.Empty();
+	Grid.Empty();
+	NumZones = 0;
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FishSchoolRenderer.generated.h"
+
+class AFishingGameCharacter;
+class UHierarchicalInstancedStaticMeshComponent;
+struct FStreamableHandle;
+
+/**
+ * Draws the simulated fish and the catches held by distant anglers as hierarchical instanced static meshes.
+ * Swimming is baked into the meshes as vertex animation, so no fish evaluates bones. The material extrapolates each fish from
+ * the per-instance custom data written with its transform:
+ *   0: swim cycle phase, 1-3: velocity, 4: world time it was written at (zero velocity for held fish)
+ * so when UFishSchoolSubsystem steps, only the fish that strayed from their extrapolation by RewriteDistance or turned by more
+ * than RewriteAngle are written again, in runs of consecutive instances. Held fish follow their hook socket every frame.
+ * Species meshes are streamed in the first time a zone puts that species in the water or an angler holds one.
+ */
+UCLASS()
+class FISHINGGAME_API AFishSchoolRenderer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AFishSchoolRenderer();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Draws the catch of Angler at Socket of Parent, turned by Rotation, until HideHeldFish. */
+	void ShowHeldFish(AFishingGameCharacter* Angler, USceneComponent* Parent, FName Socket, const FQuat& Rotation, uint16 Species);
+
+	void HideHeldFish(AFishingGameCharacter* Angler);
+
+protected:
+	/** Vertex-animated fish, indexed by species modulo the number of meshes. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish")
+	TArray<TSoftObjectPtr<class UStaticMesh>> SpeciesMeshes;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish")
+	float FishCullDistance = 8000.f;
+
+	/** How far, in cm, and how much, in degrees, a fish may stray from its extrapolated path before its instance is written again. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish")
+	float RewriteDistance = 20.f;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish")
+	float RewriteAngle = 15.f;
+
+	UPROPERTY(Transient)
+	TArray<UHierarchicalInstancedStaticMeshComponent*> SchoolInstances;
+
+	UPROPERTY(Transient)
+	TArray<UHierarchicalInstancedStaticMeshComponent*> HeldInstances;
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FHeldFish
+	{
+		TWeakObjectPtr<USceneComponent> Parent;
+		FName Socket;
+		FQuat Rotation = FQuat::Identity;
+		int32 Mesh = 0;
+		/** Index among the instances of HeldInstances[Mesh]. */
+		int32 Instance = INDEX_NONE;
+	};
+
+	UHierarchicalInstancedStaticMeshComponent* CreateInstances();
+
+	/** Starts streaming the mesh of slot Mesh unless it already was. Its instance components draw nothing until it arrives. */
+	void RequestMesh(int32 Mesh);
+
+	void OnMeshLoaded(int32 Mesh);
+
+	void UpdateSchools();
+
+	/** Writes the instances [First, First + Num) of Mesh from SpeciesTransforms and SpeciesCustomData. */
+	void WriteSchoolInstances(int32 Mesh, int32 First, int32 Num);
+
+	void RebuildHeldFish();
+
+	void UpdateHeldFish();
+
+	/** Transform and custom data last written to each school instance, per mesh. */
+	TArray<TArray<FTransform>> SpeciesTransforms;
+	TArray<TArray<float>> SpeciesCustomData;
+	TArray<int32> SpeciesCounts;
+	TBitArray<> DirtyInstances;
+	TArray<FTransform> RunTransforms;
+	TArray<FTransform> HeldTransforms;
+	TMap<TWeakObjectPtr<AFishingGameCharacter>, FHeldFish> HeldFish;
+	uint32 LastStep = MAX_uint32;
+
+	/** Keeps streamed species meshes resident, null for slots nothing asked for yet. */
+	TArray<TSharedPtr<FStreamableHandle>> MeshHandles;
+};
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishSchoolSubsystem.generated.h"
+
+class AFishingGameCharacter;
+class AFishingZone;
+class AFishSchoolRenderer;
+
+/**
+ * Fish population living in the fishing zones.
+ * Fish are stored as structure-of-arrays and steered boids-style towards their school, in 4-wide vector kernels spread over
+ * worker threads with ParallelFor at a fixed simulation rate. A hungry fish reaching a waiting hook makes the angler's fish bite.
+ * Everything derives from Seed, so the same seed on the same map replays the same bites.
+ */
+UCLASS(Config = Game)
+class FISHINGGAME_API UFishSchoolSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Seed of the whole population, overridden with -FishingSeed=. */
+	UPROPERTY(Config)
+	int32 Seed = 1337;
+
+	UPROPERTY(Config)
+	float SimulationRate = 20.f;
+
+	/** Hunger gained per second, a fish goes for a hook above HungerThreshold. */
+	UPROPERTY(Config)
+	float HungerRate = 0.02f;
+
+	UPROPERTY(Config)
+	float HungerThreshold = 0.7f;
+
+	UPROPERTY(Config)
+	float MaxSpeed = 120.f;
+
+	/** Distance at which hungry fish notice a hook, and at which they bite it. */
+	UPROPERTY(Config)
+	float AttractRadius = 800.f;
+
+	UPROPERTY(Config)
+	float BiteRadius = 25.f;
+
+	/** Spawns the zone's FishPopulation, in schools of SchoolSize fish. */
+	void AddZone(AFishingZone* Zone);
+
+	/** Removes the zone's fish. Anglers still waiting on them get a timed bite instead. */
+	void RemoveZone(AFishingZone* Zone);
+
+	/** True if fish live in Zone, i.e. bites there come from the simulation rather than a fixed wait. */
+	bool HasFish(const AFishingZone* Zone) const;
+
+	/** Lets the fish of Zone go for the hook of Angler. */
+	void AddHook(AFishingGameCharacter* Angler, const FVector& Location, AFishingZone* Zone);
+
+	void RemoveHook(AFishingGameCharacter* Angler);
+
+	FORCEINLINE int32 GetNumFish() const { return PosX.Num(); }
+
+	FORCEINLINE FVector GetFishLocation(int32 Index) const { return FVector(PosX[Index], PosY[Index], PosZ[Index]); }
+
+	FORCEINLINE FVector GetFishVelocity(int32 Index) const { return FVector(VelX[Index], VelY[Index], VelZ[Index]); }
+
+	FORCEINLINE uint16 GetFishSpecies(int32 Index) const { return Species[Index]; }
+
+	/** Number of fixed simulation steps run so far. */
+	FORCEINLINE uint32 GetStepCount() const { return StepCount; }
+
+	/** Instanced renderer drawing the fish of this world, if the level has one. */
+	FORCEINLINE AFishSchoolRenderer* GetRenderer() const { return Renderer.Get(); }
+
+	FORCEINLINE void SetRenderer(AFishSchoolRenderer* InRenderer) { Renderer = InRenderer; }
+
+	/** Fills this subsystem, which must be a throwaway one, with NumFish fish and times NumSteps steps, see "Fishing.FishBench". */
+	void RunBenchmark(int32 NumFish, int32 NumSteps, float BudgetMs);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return Schools.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FFishSchool
+	{
+		TWeakObjectPtr<AFishingZone> Zone;
+		FVector BoundsMin = FVector::ZeroVector;
+		FVector BoundsMax = FVector::ZeroVector;
+		int32 FirstFish = 0;
+		int32 NumFish = 0;
+		uint16 Species = 0;
+		FVector Centroid = FVector::ZeroVector;
+		FVector AverageVelocity = FVector::ZeroVector;
+		int32 TargetHook = INDEX_NONE;
+	};
+
+	struct FFishHook
+	{
+		TWeakObjectPtr<AFishingGameCharacter> Angler;
+		TWeakObjectPtr<AFishingZone> Zone;
+		FVector Location = FVector::ZeroVector;
+		bool bTaken = false;
+	};
+
+	void AddSchool(AFishingZone* Zone, const FBox& Bounds, int32 SchoolSize, uint16 SchoolSpecies, FRandomStream& Random);
+
+	void Step(float StepSeconds);
+
+	/** Steers, moves and feeds the 4-fish groups [FirstGroup, LastGroup), collecting fish that reached their hook. */
+	void StepGroups(int32 FirstGroup, int32 LastGroup, float StepSeconds, TArray<int32>& OutBiters);
+
+	void RebuildGroupSchools();
+
+	// Fish, structure-of-arrays. Each school owns a contiguous range padded to a multiple of 4
+	TArray<float> PosX, PosY, PosZ;
+	TArray<float> VelX, VelY, VelZ;
+	TArray<float> Hunger;
+	TArray<uint16> Species;
+
+	TArray<FFishSchool> Schools;
+	TArray<int32> GroupSchools;
+	TArray<FFishHook> Hooks;
+	TArray<TArray<int32>> TaskBiters;
+
+	TWeakObjectPtr<AFishSchoolRenderer> Renderer;
+
+	float Accumulator = 0.f;
+	uint32 StepCount = 0;
+};
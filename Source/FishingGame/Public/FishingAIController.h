@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "FishingAnglerController.h"
+#include "FishingAIController.generated.h"
+
+class AFishingGameCharacter;
+
+/**
+ * NPC angler. Runs the same cast -> bite -> reel cycle as the player on an AFishingGameCharacter, standing in for both the player's input
+ * and the animation notifies. The controller never ticks: UFishingSignificanceSubsystem steps every NPC angler's decisions in one batch,
+ * less often the less significant the angler is.
+ */
+UCLASS()
+class FISHINGGAME_API AFishingAIController : public AAIController, public IFishingAnglerController
+{
+	GENERATED_BODY()
+
+public:
+	AFishingAIController();
+
+	/** Advances the fishing cycle by DeltaTime, the time since this angler's last step. */
+	void StepFishing(float DeltaTime);
+
+	AFishingGameCharacter* GetAngler() const;
+
+	FORCEINLINE int32 GetNumCasts() const { return NumCasts; }
+
+	FORCEINLINE int32 GetNumCatches() const { return NumCatches; }
+
+	virtual float GetCastingProgress() const override;
+
+	virtual void SetCastingProgress(float Value) override { CastingProgress = Value; }
+
+	virtual bool GetIsFishing() const override { return bFishing; }
+
+	virtual bool GetInTransition() const override { return bTransition; }
+
+	virtual void SetIsFishing(bool bValue) override { bFishing = bValue; }
+
+	virtual void SetInTransition(bool bValue) override { bTransition = bValue; }
+
+protected:
+	/** Seconds between the hook being back and the next cast. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|AI")
+	FVector2D IdleTimeRange = FVector2D(1.f, 6.f);
+
+	/** Seconds the cast is charged for, the cast power follows from CastingSpeed like the player's. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|AI")
+	FVector2D ChargeTimeRange = FVector2D(0.5f, 2.f);
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|AI")
+	float CastingSpeed = 0.5f;
+
+	/** Wind-up between releasing the cast and the hook leaving the rod. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|AI")
+	float LaunchDelay = 0.5f;
+
+	/** A hook still not in the water after this long missed, and is reeled back in. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|AI")
+	float MaxHookFlightTime = 4.f;
+
+	/** Seconds from a bite to reeling in. The upper end is past the escape window, so NPCs lose some fish too. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|AI")
+	FVector2D ReactionTimeRange = FVector2D(0.3f, 2.5f);
+
+	virtual void OnPossess(APawn* InPawn) override;
+
+private:
+	enum class EFishingStep : uint8
+	{
+		Idle,
+		Charging,
+		Launching,
+		HookInFlight,
+		WaitingForBite,
+		Reacting
+	};
+
+	void NextStep(EFishingStep InStep, float Duration);
+
+	void ReadyCast(AFishingGameCharacter* Angler);
+
+	void ThrowCast(AFishingGameCharacter* Angler);
+
+	void Reel(AFishingGameCharacter* Angler);
+
+	EFishingStep Step = EFishingStep::Idle;
+	float StepTime = 0.f;
+	float StepDuration = 0.f;
+
+	bool bFishing = false;
+	bool bTransition = false;
+	bool bReadyToFish = false;
+	float CastingProgress = 0.f;
+
+	int32 NumCasts = 0;
+	int32 NumCatches = 0;
+};
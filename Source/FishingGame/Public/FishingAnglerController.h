@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "FishingAnglerController.generated.h"
+
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class UFishingAnglerController : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Cast state of whoever drives an AFishingGameCharacter through the fishing loop, the player's controller or an NPC angler's AI.
+ * The character only talks to its controller through this.
+ */
+class FISHINGGAME_API IFishingAnglerController
+{
+	GENERATED_BODY()
+
+public:
+	/** Cast power in [0, 1]. */
+	virtual float GetCastingProgress() const = 0;
+
+	virtual void SetCastingProgress(float Value) = 0;
+
+	/** The hook is in the water. */
+	virtual bool GetIsFishing() const = 0;
+
+	/** Between casting and the hook landing, or between reeling and the hook being back. */
+	virtual bool GetInTransition() const = 0;
+
+	virtual void SetIsFishing(bool bValue) = 0;
+
+	virtual void SetInTransition(bool bValue) = 0;
+
+	/** The hook left the rod, anything showing the charge can go. */
+	virtual void RemoveCastingWidget() {}
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingCastTrajectory.h"
+#include "FishingAnglerUpdateSubsystem.generated.h"
+
+class AFishingGameCharacter;
+class UFishingZoneSubsystem;
+
+/**
+ * Runs the per-frame fishing update of every angler with a hook out, flying along its cast or simulating physics, on task graph
+ * worker threads. Once a frame the game thread copies what the update reads into a snapshot, jobs turn the snapshot into a
+ * result buffer without touching a UObject, and the game thread then applies the results in one batched pass: hook locations,
+ * landings and hooks entering a zone. Anglers never see each other's results, so how the work is split never changes them.
+ * The update is split into jobs of AnglersPerJob anglers, so up to AnglersPerJob hooks out it stays on the game thread.
+ * "Fishing.AnglerUpdateBench" times it on synthetic anglers for each thread count up to the task graph's workers, and the
+ * batch size from which handing half of it to a worker pays off, which is what AnglersPerJob should be set to.
+ */
+UCLASS(Config = Game)
+class FISHINGGAME_API UFishingAnglerUpdateSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	enum class EHookMode : uint8
+	{
+		None,
+		/** Kinematic cast along a trajectory, landing when it comes down. */
+		Flight,
+		/** Physics cast, pinned once it enters a fishing zone. */
+		Physics
+	};
+
+	/** What one angler's update reads, copied on the game thread. */
+	struct FHookSnapshot
+	{
+		FFishingCastTrajectory Trajectory;
+		FVector Location = FVector::ZeroVector;
+		float FlightTime = 0.f;
+		EHookMode Mode = EHookMode::None;
+	};
+
+	/** What one angler's update decided, applied on the game thread. */
+	struct FHookResult
+	{
+		FVector Location = FVector::ZeroVector;
+		float FlightTime = 0.f;
+		int32 ZoneIndex = INDEX_NONE;
+		bool bLanded = false;
+	};
+
+	/** Anglers updated by each job. Smaller batches than this aren't worth handing to a worker and run inline. */
+	UPROPERTY(Config)
+	int32 AnglersPerJob = 64;
+
+	/** Updates Snapshots[First, Last) into the same range of Results. Safe on any thread while the game thread leaves Zones alone. */
+	static void UpdateHooks(const TArray<FHookSnapshot>& Snapshots, TArray<FHookResult>& Results, int32 First, int32 Last, float DeltaTime, const UFishingZoneSubsystem& Zones);
+
+	/** Runs UpdateHooks over Snapshots split into NumJobs task graph jobs, or inline for a single job. */
+	static void RunJobs(const TArray<FHookSnapshot>& Snapshots, TArray<FHookResult>& Results, int32 NumJobs, float DeltaTime, const UFishingZoneSubsystem& Zones);
+
+	int32 RegisterAngler(AFishingGameCharacter* Angler);
+
+	void UnregisterAngler(int32 AnglerIndex);
+
+	/** Flies the angler's hook along Trajectory from ElapsedTime in, until AFishingGameCharacter::LandHook. */
+	void BeginFlight(int32 AnglerIndex, const FFishingCastTrajectory& Trajectory, float ElapsedTime);
+
+	/** Watches the angler's simulating hook, while its cast is in transition, until AFishingGameCharacter::PinHook. */
+	void BeginPhysicsCast(int32 AnglerIndex);
+
+	void StopHook(int32 AnglerIndex);
+
+	FORCEINLINE int32 GetNumActive() const { return ActiveAnglers.Num(); }
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return ActiveAnglers.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	void SetMode(int32 AnglerIndex, EHookMode Mode);
+
+	TArray<TWeakObjectPtr<AFishingGameCharacter>> Owners;
+	TArray<EHookMode> Modes;
+	TArray<FFishingCastTrajectory> Trajectories;
+	TArray<float> FlightTimes;
+	TBitArray<> Registered;
+	TArray<int32> FreeIndices;
+
+	/** Anglers with a hook out, in no particular order. */
+	TArray<int32> ActiveAnglers;
+
+	/** Front and back buffer of the jobs, and the angler each entry belongs to. */
+	TArray<FHookSnapshot> Snapshots;
+	TArray<FHookResult> Results;
+	TArray<int32> SnapshotAnglers;
+
+	TArray<TPair<int32, int32>> Landed;
+	TArray<TPair<int32, int32>> Pinned;
+};
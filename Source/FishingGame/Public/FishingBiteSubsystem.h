@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingBiteWheel.h"
+#include "FishingBiteSubsystem.generated.h"
+
+class AFishingGameCharacter;
+
+/**
+ * Owns the bite wait and escape window of every angler in the world.
+ * Deadlines are advanced by an FFishingBiteWheel in one batched tick,
+ * so (re)arming a bite is a bucket insert instead of a timer heap operation plus a delegate per angler.
+ * "Fishing.BiteBench" times the wheel against an FTimerManager doing the same work.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingBiteSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	int32 RegisterAngler(AFishingGameCharacter* Angler);
+
+	void UnregisterAngler(int32 AnglerIndex);
+
+	/** Fires FishBite on the angler after WaitTime. Replaces any pending deadline of the angler. */
+	void ArmBite(int32 AnglerIndex, float WaitTime);
+
+	/** Fires StartFishing on the angler after Window unless cancelled, i.e. the fish swims away. */
+	void ArmEscape(int32 AnglerIndex, float Window);
+
+	void Cancel(int32 AnglerIndex);
+
+	/** World time the angler's last wait or window was armed to end at, exact rather than rounded to the wheel. Still valid in the callback it fires. */
+	FORCEINLINE double GetDeadlineTime(int32 AnglerIndex) const { return Wheel.GetDeadlineTime(AnglerIndex); }
+
+	FORCEINLINE int32 GetNumPending() const { return Wheel.GetNumPending(); }
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return Wheel.GetNumPending() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	FFishingBiteWheel Wheel;
+
+	/** Indexed like the wheel's anglers. */
+	TArray<TWeakObjectPtr<AFishingGameCharacter>> Owners;
+};
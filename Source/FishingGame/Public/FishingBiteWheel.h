@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Bite wait and escape window deadlines of a set of anglers, advanced by a two-level timing wheel.
+ * State lives in flat per-angler arrays, so (re)arming a deadline is a bucket insert and cancelling never has to search a bucket.
+ * Driven by whatever clock it is handed, UFishingBiteSubsystem's is the world's.
+ */
+struct FISHINGGAME_API FFishingBiteWheel
+{
+	enum class EState : uint8
+	{
+		Free,
+		Idle,
+		Waiting,
+		Biting
+	};
+
+	/** Resolution of the wheel, a deadline fires on the first wheel tick at or after it. */
+	static constexpr float TickInterval = 1.f / 60.f;
+
+	int32 AddAngler();
+
+	void RemoveAngler(int32 AnglerIndex);
+
+	/** Ends the angler's wait (Waiting) or window (Biting) Delay after Now. Replaces any pending deadline of the angler. */
+	void Schedule(int32 AnglerIndex, EState State, float Delay, double Now);
+
+	void Cancel(int32 AnglerIndex);
+
+	/** Walks the wheel up to Now and settles the deadlines it passes into the expired lists, which stay until ResetExpired. */
+	void Advance(double Now);
+
+	FORCEINLINE const TArray<int32>& GetExpiredWaits() const { return ExpiredWaits; }
+
+	FORCEINLINE const TArray<int32>& GetExpiredBites() const { return ExpiredBites; }
+
+	void ResetExpired();
+
+	/** Drops every pending deadline. */
+	void Empty();
+
+	/** Time the angler's last wait or window was scheduled to end at, exact rather than rounded to the wheel. */
+	FORCEINLINE double GetDeadlineTime(int32 AnglerIndex) const { return DeadlineTimes.IsValidIndex(AnglerIndex) ? DeadlineTimes[AnglerIndex] : 0.0; }
+
+	FORCEINLINE int32 GetNumPending() const { return NumPending; }
+
+private:
+	/** Wheel entries are validated against the angler generation, cancelling leaves them behind. */
+	struct FEntry
+	{
+		int32 AnglerIndex;
+		uint32 Generation;
+	};
+
+	static constexpr uint64 InnerSlots = 256;	// ~4.3 seconds of wheel ticks
+	static constexpr uint64 OuterSlots = 64;	// ~4.5 minutes, anything further waits in Overflow
+
+	void Insert(const FEntry& Entry);
+
+	bool IsCurrent(const FEntry& Entry) const;
+
+	static uint64 GetWheelTick(double Time);
+
+	TArray<uint64> DeadlineTicks;
+	TArray<double> DeadlineTimes;
+	TArray<uint32> Generations;
+	TArray<EState> States;
+	TArray<int32> FreeIndices;
+
+	TArray<FEntry> InnerWheel[InnerSlots];
+	TArray<FEntry> OuterWheel[OuterSlots];
+	TArray<FEntry> Overflow;
+
+	uint64 CurrentTick = 0;
+	int32 NumPending = 0;
+
+	TArray<int32> ExpiredWaits;
+	TArray<int32> ExpiredBites;
+};
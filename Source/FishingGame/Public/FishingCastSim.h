@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Casting charge and bite window of one angler, simulated on a fixed step and fed timestamped input.
+ * Every outcome is decided by the timestamps of the inputs and deadlines involved, in the order they happened, never by which
+ * frame got to see them: a cast's power comes from its press and release times and a reel beats the escape if it was pressed
+ * before the escape deadline. Continuous state, the charge meter today and line tension later, is integrated in whole steps of
+ * 1 / StepRate, so how the simulation is chunked into Advance calls, i.e. the frame rate, changes nothing.
+ *
+ * Times are world seconds. Inputs must arrive in time order; one stamped before what was already simulated counts as happening
+ * at the simulation time.
+ */
+struct FISHINGGAME_API FFishingCastSim
+{
+	enum class EInput : uint8
+	{
+		CastPressed,
+		CastReleased,
+		ReelPressed
+	};
+
+	enum class EEventType : uint8
+	{
+		/** Value is the cast power in [0, 1]. */
+		Thrown,
+		Bite,
+		/** The fish swam away before the reel. */
+		Escaped,
+		/** Value is the reaction time from the bite to the reel. */
+		Hooked,
+		/** Reeled in without a fish on. */
+		ReeledEmpty
+	};
+
+	struct FEvent
+	{
+		EEventType Type;
+		double Time;
+		float Value;
+
+		bool operator==(const FEvent& Other) const { return Type == Other.Type && Time == Other.Time && Value == Other.Value; }
+	};
+
+	struct FSettings
+	{
+		float StepRate = 120.f;
+
+		/** Cast power gained per second of charge. */
+		float ChargeRate = 0.5f;
+	};
+
+	/** Starts over idle at InStartTime. */
+	void Reset(const FSettings& InSettings, double InStartTime);
+
+	/** Applies Input at InputTime, after everything up to InputTime has been simulated. */
+	void AddInput(EInput Input, double InputTime);
+
+	/** A fish bites at InBiteTime and escapes InEscapeWindow seconds later unless reeled. Replaces any pending bite. */
+	void ArmBite(double InBiteTime, float InEscapeWindow);
+
+	/** Drops the charge and any pending bite. */
+	void Cancel();
+
+	/** Simulates up to ToTime, resolving every deadline before it. */
+	void Advance(double ToTime);
+
+	/** Oldest outcome not popped yet. */
+	bool PopEvent(FEvent& OutEvent);
+
+	/** Charge meter as of the last whole step. */
+	FORCEINLINE float GetCharge() const { return Charge; }
+
+	FORCEINLINE bool IsCharging() const { return Phase == EPhase::Charging; }
+
+	FORCEINLINE bool IsBiting() const { return Phase == EPhase::Biting; }
+
+	FORCEINLINE double GetEscapeTime() const { return EscapeTime; }
+
+	FORCEINLINE double GetTime() const { return Time; }
+
+	FORCEINLINE uint64 GetStepCount() const { return StepCount; }
+
+private:
+	enum class EPhase : uint8
+	{
+		Idle,
+		Charging,
+		Waiting,
+		Biting
+	};
+
+	/** Next bite or escape deadline, or MAX_dbl. */
+	double GetNextDeadline() const;
+
+	void ResolveDeadline();
+
+	void Step();
+
+	void Emit(EEventType Type, double EventTime, float Value = 0.f);
+
+	FSettings Settings;
+	double StepSeconds = 1.0 / 120.0;
+
+	EPhase Phase = EPhase::Idle;
+
+	double StartTime = 0.0;
+
+	/** Everything up to Time is resolved; continuous state is integrated up to StepTime, the last whole step at or before it. */
+	double Time = 0.0;
+	double StepTime = 0.0;
+	uint64 StepCount = 0;
+
+	double PressTime = 0.0;
+	float Charge = 0.f;
+
+	double BiteTime = 0.0;
+	double EscapeTime = 0.0;
+	float EscapeWindow = 0.f;
+
+	TArray<FEvent> Events;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+
+class UFishingZoneSubsystem;
+
+/**
+ * Closed-form ballistic path of a cast hook.
+ * Backs the kinematic cast, which animates the hook along the curve without a rigid body, and the aiming preview.
+ */
+struct FISHINGGAME_API FFishingCastTrajectory
+{
+	FVector Origin = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float GravityZ = -980.f;
+
+	/** Where and when the hook comes down, valid once SolveLanding or SolvePlaneLanding succeeded. */
+	FVector LandingLocation = FVector::ZeroVector;
+	float LandingTime = 0.f;
+	bool bHasLanding = false;
+
+	FFishingCastTrajectory() = default;
+
+	FFishingCastTrajectory(const FVector& InOrigin, const FVector& InVelocity, float InGravityZ)
+		: Origin(InOrigin)
+		, Velocity(InVelocity)
+		, GravityZ(InGravityZ)
+	{
+	}
+
+	FORCEINLINE FVector GetLocationAtTime(float Time) const
+	{
+		return Origin + Velocity * Time + FVector(0.f, 0.f, 0.5f * GravityZ * Time * Time);
+	}
+
+	FORCEINLINE FVector GetVelocityAtTime(float Time) const
+	{
+		return Velocity + FVector(0.f, 0.f, GravityZ * Time);
+	}
+
+	/** Highest point of the path. */
+	float GetApexHeight() const;
+
+	/** Time at which the descending part of the path crosses Z, or a negative value if it never does. */
+	float GetTimeAtHeight(float Z) const;
+
+	/** Lands the path on the horizontal plane at PlaneZ without any scene query. */
+	bool SolvePlaneLanding(float PlaneZ);
+
+	/**
+	 * Traces the path as at most 8 chords and lands it at the first blocking hit on TraceChannel (water, shore, rocks, docks),
+	 * or on the plane well below ReferenceZ if it meets nothing. One zone query over the last chord then moves the landing to
+	 * where the hook enters one of Zones' fishing zones, if it does before that.
+	 */
+	bool SolveLanding(const UWorld* World, float ReferenceZ, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, const UFishingZoneSubsystem* Zones);
+
+	/** Evenly spaced points from the origin to the landing point, for drawing the aiming arc. */
+	void GetPreviewPoints(int32 NumPoints, TArray<FVector>& OutPoints) const;
+};
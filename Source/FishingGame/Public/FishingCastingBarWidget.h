@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "FishingCastingBarWidget.generated.h"
+
+class UImage;
+class UMaterialInstanceDynamic;
+
+/**
+ * Casting power bar whose fill is animated entirely by its material.
+ * Charging writes a start time, charge and fill rate, and the material derives the fill from its Time input, so nothing is bound per frame
+ * and the bar sits in an invalidation box that never has to repaint. The controller creates it once and collapses it between casts.
+ *
+ * FillMaterial must be a user interface material with StartTimeParameter, StartChargeParameter and FillRateParameter scalars,
+ * masking U against saturate(StartCharge + (Time - StartTime) * FillRate).
+ */
+UCLASS()
+class FISHINGGAME_API UFishingCastingBarWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	/** Shows the bar, empty until the first SyncCharge. */
+	void StartCharging();
+
+	/**
+	 * Lets the bar fill on from Charge at FillRate per second of application time. The material's Time keeps running through pauses,
+	 * time dilation and hitches the world's clock leaves out, so the owner passes the charge it measured every frame; the parameters
+	 * are only rewritten when the rate changed or the shown fill drifted more than ResyncTolerance from Charge.
+	 */
+	void SyncCharge(float Charge, float FillRate);
+
+	/** Collapses the bar. */
+	void StopCharging();
+
+protected:
+	virtual void NativeOnInitialized() override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	UMaterialInterface* FillMaterial;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	FName StartTimeParameter = "StartTime";
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	FName StartChargeParameter = "StartCharge";
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	FName FillRateParameter = "FillRate";
+
+	/** How far the shown fill may drift from the charge before the material is given a new start. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	float ResyncTolerance = 0.01f;
+
+	/** Size and screen anchor of the bar when the widget builds its own tree instead of using a designer layout. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	FVector2D BarSize = FVector2D(300.f, 24.f);
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
+	FVector2D BarAnchor = FVector2D(0.5f, 0.85f);
+
+	/** Optional designer image to draw the fill with. Without one the widget builds an invalidation box around a single image itself. */
+	UPROPERTY(meta = (BindWidgetOptional))
+	UImage* FillImage;
+
+private:
+	UPROPERTY(Transient)
+	UMaterialInstanceDynamic* FillMID;
+
+	/** What the material was last given. */
+	float SyncedTime = 0.f;
+	float SyncedCharge = 0.f;
+	float SyncedFillRate = 0.f;
+};
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "FishingCatchJournal.generated.h"
+
+class AFishingZone;
+
+/** One catch as stored on disk. Plain old data written as is, so keep the layout and size stable and bump JournalVersion when it changes. */
+struct FFishingCatchRecord
+{
+	/** UTC FDateTime ticks of the reel. */
+	int64 Timestamp = 0;
+
+	/** See UFishingCatchJournalSubsystem::GetZoneId. 0 when the hook wasn't in a zone. */
+	uint32 ZoneId = 0;
+
+	/** Player id of the angler, 0 for anglers without a player state. */
+	uint32 AnglerId = 0;
+
+	/** Length of the fish in cm. */
+	float Size = 0.f;
+
+	float CastPower = 0.f;
+
+	/** Horizontal distance the hook flew, cm. */
+	float CastDistance = 0.f;
+
+	/** Seconds from the hook settling to the bite. */
+	float WaitSeconds = 0.f;
+
+	/** Seconds from the bite to the reel. */
+	float ReactionSeconds = 0.f;
+
+	/** FFishSpeciesRow::SpeciesId, or UnknownSpecies when the zone has no loot table. */
+	uint16 Species = 0;
+
+	uint16 Flags = 0;
+
+	static constexpr uint16 UnknownSpecies = 0xFFFF;
+};
+
+static_assert(sizeof(FFishingCatchRecord) == 40, "FFishingCatchRecord is written to disk as is");
+
+/**
+ * Append-only binary journal of catches, stored as a directory of fixed-size segment files.
+ * Appends are handed to a background writer that flushes in batches, so the game thread never touches the disk.
+ * Segments sealed by the writer are read back through memory-mapped files, and an in-memory index answers best catch queries without scanning.
+ * Every session starts a new segment; the one being written is mirrored in memory until the writer seals it.
+ */
+class FISHINGGAME_API FFishingCatchJournal
+{
+public:
+	/** Pass as Species or ZoneId to FindBestCatch to match any. */
+	static constexpr int32 AnySpecies = INDEX_NONE;
+	static constexpr int64 AnyZone = INDEX_NONE;
+
+	FFishingCatchJournal(const FString& InDirectory, int32 InSegmentCapacity = 16384);
+	~FFishingCatchJournal();
+
+	void Append(const FFishingCatchRecord& Record);
+
+	/** Largest catch of Species in ZoneId so far, across every session in the journal. */
+	bool FindBestCatch(int32 Species, int64 ZoneId, FFishingCatchRecord& OutRecord);
+
+	FORCEINLINE int64 GetNumRecords() const { return NumRecords; }
+
+	/** Stops the writer after it has flushed everything appended so far. Blocks until it has. */
+	void Close();
+
+private:
+	struct FSegment
+	{
+		FString Path;
+		TUniquePtr<IMappedFileHandle> MappedFile;
+		TUniquePtr<IMappedFileRegion> MappedRegion;
+		int32 NumRecords = 0;
+
+		/** Records of a segment the writer hasn't sealed yet, or couldn't write and that is kept for the session. */
+		TArray<FFishingCatchRecord> Pending;
+	};
+
+	struct FBestCatch
+	{
+		int64 RecordId = 0;
+		float Size = 0.f;
+	};
+
+	using FCatchKey = TPair<int32, int64>;
+
+	bool MapSegment(FSegment& Segment);
+	void MapSealedSegments();
+	void IndexRecord(const FFishingCatchRecord& Record, int64 RecordId);
+	bool ReadRecord(int64 RecordId, FFishingCatchRecord& OutRecord) const;
+
+	FString Directory;
+	int32 SegmentCapacity;
+	TArray<FSegment> Segments;
+
+	/** First segment this session writes to. */
+	int32 FirstSessionSegment = 0;
+	int32 NumMappedSessionSegments = 0;
+
+	/** Segment file number minus index in Segments. */
+	int32 FileNumberOffset = 0;
+	int64 NumRecords = 0;
+
+	TMap<FCatchKey, FBestCatch> BestCatches;
+
+	TUniquePtr<class FFishingCatchJournalWriter> Writer;
+};
+
+/** Owns the game's catch journal in Saved/FishingJournal. Opened on first use, so clients that never record anything don't start a writer. */
+UCLASS()
+class FISHINGGAME_API UFishingCatchJournalSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	FFishingCatchJournal& GetJournal();
+
+	/** Stable id of a zone across sessions of the same level. */
+	static uint32 GetZoneId(const AFishingZone* Zone);
+
+private:
+	TUniquePtr<FFishingCatchJournal> Journal;
+};
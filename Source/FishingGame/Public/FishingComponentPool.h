@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FishingComponentPool.generated.h"
+
+/**
+ * World-level pool of the fishing components only some anglers need at a time: bite VFX, caught-fish meshes and cursor decals.
+ * Components are created on first demand, attached to whoever acquires them and parked hidden on a pool actor when released,
+ * so characters that never fish or aren't locally controlled never create or register them.
+ * "Fishing.PoolReport" logs how many of each were created against how many the anglers in the world would have had without it.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingComponentPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Null where nothing can be pooled, outside game worlds; callers go without the component then. */
+	template<typename T>
+	T* Acquire(USceneComponent* Parent, FName Socket = NAME_None)
+	{
+		return Cast<T>(Acquire(T::StaticClass(), Parent, Socket));
+	}
+
+	USceneComponent* Acquire(TSubclassOf<USceneComponent> ComponentClass, USceneComponent* Parent, FName Socket);
+
+	/** Hides, deactivates and detaches Component and hands it back to the pool. Clears the caller's pointer. */
+	template<typename T>
+	void Release(T*& Component)
+	{
+		if (Component)
+		{
+			ReleaseComponent(Component);
+			Component = nullptr;
+		}
+	}
+
+	void ReleaseComponent(USceneComponent* Component);
+
+	/** Logs, per class, the components created, in use and free and their memory. */
+	void LogReport() const;
+
+	virtual void Deinitialize() override;
+
+private:
+	AActor* GetPoolOwner();
+
+	UPROPERTY(Transient)
+	AActor* PoolOwner = nullptr;
+
+	/** Free components by class. Every pooled component is also referenced by PoolOwner, which keeps it alive. */
+	TMap<UClass*, TArray<USceneComponent*>> FreeComponents;
+
+	TMap<UClass*, int32> NumCreated;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "FishingEquipmentData.generated.h"
+
+class UMaterialInterface;
+class UParticleSystem;
+class USkeletalMesh;
+
+/**
+ * Cosmetic assets of an angler, registered with the asset manager as the "FishingEquipmentData" primary asset type.
+ * Everything is a soft reference grouped in bundles, so nothing is loaded with the map:
+ *   Cursor:  streamed when a local player takes control of the angler
+ *   Fishing: streamed on the angler's first cast
+ */
+UCLASS(BlueprintType)
+class FISHINGGAME_API UFishingEquipmentData : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FName CursorBundle;
+	static const FName FishingBundle;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Cursor", meta = (AssetBundles = "Cursor"))
+	TSoftObjectPtr<UMaterialInterface> CursorDecalMaterial;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Model", meta = (AssetBundles = "Fishing"))
+	TSoftObjectPtr<USkeletalMesh> FishSkeletalMesh;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Particle", meta = (AssetBundles = "Fishing"))
+	TSoftObjectPtr<UParticleSystem> FishBiteFX;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Picks a quality tier from frame times so the chosen percentile of recent frames stays within a budget.
+ * Fed one frame at a time, its measured cost and the real time it took, so a list of synthetic frames drives it the same way
+ * a running game does, without a world or a GPU. The two differ in a running game: the cost is that of the slowest of the game
+ * thread, render thread and GPU, while the frame's length also holds the wait on the other two and any frame rate cap.
+ *
+ * Tiers run from 0 (cheapest) to NumTiers - 1. Going down takes the percentile being over budget for DowngradeDelay; going up
+ * takes it being well under budget, below UpgradeThreshold, for UpgradeDelay, which is longer. Between the two thresholds
+ * nothing changes. After any change a whole new window of frames must be seen, and ChangeCooldown must pass, before the next one.
+ * An upgrade undone within UpgradeProbation doubles the wait before the next upgrade, up to MaxUpgradeBackoff times, so a
+ * scene sitting right on a tier's cost doesn't bounce between two tiers.
+ */
+struct FISHINGGAME_API FFishingFrameGovernor
+{
+	struct FSettings
+	{
+		float TargetFrameMs = 16.67f;
+
+		/** Percentile of the window held to the budget, in [0, 1]. */
+		float Percentile = 0.9f;
+
+		int32 WindowFrames = 90;
+
+		/** Fractions of TargetFrameMs the percentile must be above to step down, respectively below to step up. */
+		float DowngradeThreshold = 1.05f;
+		float UpgradeThreshold = 0.75f;
+
+		/** Seconds the percentile must stay past a threshold for the tier to change. */
+		float DowngradeDelay = 1.f;
+		float UpgradeDelay = 5.f;
+
+		float ChangeCooldown = 2.f;
+		float UpgradeProbation = 15.f;
+		int32 MaxUpgradeBackoff = 3;
+	};
+
+	/** Starts over at Tier with an empty window. */
+	void Reset(const FSettings& InSettings, int32 InNumTiers, int32 InTier);
+
+	/** Adds a frame whose bottleneck cost FrameMs and that lasted DeltaTime seconds of real time. True if the tier changed. */
+	bool AddFrame(float FrameMs, float DeltaTime);
+
+	FORCEINLINE int32 GetTier() const { return Tier; }
+
+	FORCEINLINE int32 GetNumTiers() const { return NumTiers; }
+
+	/** Percentile of the last full window, 0 before the first. */
+	FORCEINLINE float GetPercentileMs() const { return PercentileMs; }
+
+	FORCEINLINE int32 GetUpgradeBackoff() const { return UpgradeBackoff; }
+
+private:
+	void ChangeTier(int32 NewTier);
+
+	float ComputePercentile();
+
+	FSettings Settings;
+	int32 NumTiers = 1;
+	int32 Tier = 0;
+
+	/** Ring buffer of the last WindowFrames frame times, emptied at every tier change. */
+	TArray<float> Window;
+	int32 WindowNext = 0;
+	TArray<float> Sorted;
+	float PercentileMs = 0.f;
+
+	float OverBudgetTime = 0.f;
+	float UnderBudgetTime = 0.f;
+	float CooldownTime = 0.f;
+	float ProbationTime = 0.f;
+	int32 UpgradeBackoff = 0;
+};
@@ -4,8 +4,16 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "FishingCastSim.h"
+#include "FishingCastTrajectory.h"
+#include "FishingNetTypes.h"
+#include "UObject/PrimaryAssetId.h"
 #include "FishingGameCharacter.generated.h"
 
+class UMaterialInterface;
+class UParticleSystem;
+class USkeletalMesh;
+
 UCLASS(Blueprintable)
 class AFishingGameCharacter : public ACharacter
 {
@@ -14,7 +22,13 @@ class AFishingGameCharacter : public ACharacter
 public:
 	AFishingGameCharacter();
 
-	virtual void Tick(float DeltaSeconds) override;
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void NotifyControllerChanged() override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	FORCEINLINE class UCameraComponent* GetTopDownCameraComponent() const { return TopDownCameraComponent; }
 
@@ -26,6 +40,42 @@ public:
 
 	FORCEINLINE USkeletalMeshComponent* GetFishMesh() { return FishMesh; }
 
+	FORCEINLINE bool IsFishBiting() const { return bFishBiting; }
+
+	UFUNCTION(BlueprintPure, Category = "FishingGame|Hook")
+	FORCEINLINE bool IsHookInFlight() const { return bHookInFlight; }
+
+	/** The hook came down in a zone and rests on its water, what fishing waits for. The hook never changes mobility. */
+	UFUNCTION(BlueprintPure, Category = "FishingGame|Hook")
+	FORCEINLINE bool IsHookLanded() const { return HookZone.IsValid() && !bHookInFlight; }
+
+	/** Replicated phase of the fishing loop, the same on the server, the owner and every other client. */
+	UFUNCTION(BlueprintPure, Category = "FishingGame|Net")
+	FORCEINLINE EFishingPhase GetFishingPhase() const { return FishingState.Phase; }
+
+	/** Seconds since the current phase began on the server. */
+	UFUNCTION(BlueprintPure, Category = "FishingGame|Net")
+	float GetFishingPhaseTime() const;
+
+	/** Server only. Moves the replicated state to Phase, stamped with the server time. */
+	void SetFishingPhase(EFishingPhase Phase, float CastProgress = 0.f);
+
+	/** Zone the cast hook landed in, if any. */
+	FORCEINLINE class AFishingZone* GetHookZone() const { return HookZone.Get(); }
+
+	/** Brings the flying hook down at Location, in Zone if it came down in one. Called by UFishingAnglerUpdateSubsystem. */
+	void LandHook(const FVector& Location, class AFishingZone* Zone);
+
+	/** Pins the simulating hook on the water surface where it entered Zone. Called by UFishingAnglerUpdateSubsystem. */
+	void PinHook(class AFishingZone* Zone);
+
+	/** Ballistic path the hook would follow if released at CastingProgress, landed on the ground plane without scene queries. */
+	FFishingCastTrajectory PredictCast(float CastingProgress) const;
+
+	/** Points of the aiming arc for the current charge, cheap enough to call every frame while the casting bar fills. */
+	UFUNCTION(BlueprintCallable, Category = "FishingGame|Hook")
+	void GetCastPreview(int32 NumPoints, TArray<FVector>& OutPoints, FVector& OutLanding) const;
+
 	UFUNCTION(BlueprintCallable)
 	void LaunchHook();
 
@@ -38,28 +88,196 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void StartFishing();
 
-	void FishBite();
+	/** Shows the caught fish on the hook: skeletal when a local player is close enough to see it, instanced otherwise. */
+	void ShowCaughtFish();
+
+	void HideCaughtFish();
+
+	/** Server only. Leaves the bite to the zone's fish if it has any, otherwise arms the fixed wait. */
+	void WaitForBite();
+
+	/** Species is the simulated fish that bit, or INDEX_NONE for a timed bite, whose fish was rolled from the zone's loot table when the hook landed. */
+	void FishBite(int32 Species = INDEX_NONE);
+
+	/**
+	 * Server only. Settles the bite on the hook against a reel pressed at PressTime, by timestamp rather than by whether the escape
+	 * has been seen yet: the fish is caught if the reel came before the escape deadline. Call before switching to the reeling phase.
+	 */
+	void ReelIn(double PressTime);
+
+	/** Moves the cursor decal to Hit. Pushed by the controller whenever its cursor trace completes. */
+	void UpdateCursorDecal(const FHitResult& Hit);
+
+	/** Starts streaming a bundle of the angler's equipment, see UFishingEquipmentData. Does nothing on dedicated servers or if already requested. */
+	void LoadEquipmentBundle(FName Bundle);
+
+	/** Shows or hides the fishing line and bite VFX, and stops the line from ticking while hidden. Driven by NPC significance. */
+	void SetCosmeticsEnabled(bool bEnabled);
 
 protected:
-	UPROPERTY(EditAnywhere, Category = "FishingGame|Model")
+	/** Pooled caught-fish mesh, only set while a nearby catch is shown. */
+	UPROPERTY(Transient)
 	USkeletalMeshComponent* FishMesh;
 
-	UPROPERTY(EditAnywhere, Category = "FishingGame|Particle")
+	/** Pooled bite VFX, only set while a fish is biting. */
+	UPROPERTY(Transient)
 	class UParticleSystemComponent* FishBiteFXComp;
 
+	/** Off for NPC anglers too insignificant to be worth their line and VFX, see UFishingSignificanceSubsystem. */
+	bool bCosmeticsEnabled = true;
+
+	/** Fish mesh, bite VFX and cursor material. Streamed in bundles, nothing is loaded with the angler. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Model", meta = (AllowedTypes = "FishingEquipmentData"))
+	FPrimaryAssetId EquipmentId;
+
+	/** Streamed with the Cursor, respectively Fishing, bundle instead of the equipment's while EquipmentId names no asset. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Model")
+	TSoftObjectPtr<UMaterialInterface> DefaultCursorDecalMaterial;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Model")
+	TSoftObjectPtr<USkeletalMesh> DefaultFishSkeletalMesh;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Particle")
+	TSoftObjectPtr<UParticleSystem> DefaultFishBiteFX;
+
+	UPROPERTY(Transient)
+	class UFishingEquipmentData* Equipment;
+
+	/** Keeps the default assets streamed in for the bundles requested so far. */
+	TArray<TSharedPtr<struct FStreamableHandle>> DefaultAssetHandles;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Model")
+	FRotator FishMeshRotation = FRotator(0.f, 90.f, 0.f);
+
+	TArray<FName, TInlineAllocator<2>> RequestedBundles;
+
+	/** Hands the assets that just streamed in to the cursor decal, bite VFX and fish mesh already showing. */
+	void OnEquipmentLoaded();
+
+	/** Whether the asset manager knows an asset for EquipmentId; if not, the Default* assets stand in for it. */
+	bool HasEquipmentAsset() const;
+
+	/** Default assets belonging to Bundle. */
+	void GetDefaultBundleAssets(FName Bundle, TArray<FSoftObjectPath>& OutPaths) const;
+
+	/** The equipment's assets, or the defaults. Never loads: null until their bundle has streamed in, OnEquipmentLoaded fills them in then. */
+	UMaterialInterface* GetCursorDecalMaterial() const;
+	USkeletalMesh* GetFishSkeletalMesh() const;
+	UParticleSystem* GetFishBiteFX() const;
+
 	UPROPERTY(EditAnywhere, Category = "FishingGame|Hook")
 	float LaunchStrength = 1000.f;
 
 	UPROPERTY(EditAnywhere, Category = "FishingGame|Hook")
 	float PitchAngle = 35.f;;
 
+	/** Fly the hook along the analytic cast path instead of simulating it as a rigid body. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Hook")
+	bool bKinematicCast = true;
+
+	FFishingCastTrajectory HookTrajectory;
+	bool bHookInFlight = false;
+
+	UPROPERTY(ReplicatedUsing = OnRep_FishingState)
+	FFishingNetState FishingState;
+
+	UPROPERTY(ReplicatedUsing = OnRep_HookLaunch)
+	FFishingHookLaunch HookLaunch;
+
+	/** Anglers nobody remote controls go dormant after standing idle this long. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Net")
+	float IdleDormancyDelay = 2.f;
+
+	FTimerHandle DormancyTimer;
+
+	UFUNCTION()
+	void OnRep_FishingState(const FFishingNetState& PreviousState);
+
+	UFUNCTION()
+	void OnRep_HookLaunch();
+
+	/** Detaches the hook and starts flying it along HookTrajectory, ElapsedTime seconds in. */
+	void BeginHookFlight(float ElapsedTime);
+
+	/** Starts or stops the bite VFX and the fish's pull on the line. */
+	void SetBiteFXActive(bool bActive);
+
+	float GetServerWorldTime() const;
+
+	/** Applies what a phase needs from this machine: on a server an angler going idle arms its dormancy timer. */
+	void OnFishingPhaseChanged(EFishingPhase PreviousPhase);
+
+	/**
+	 * Server only. Moves a remote player's angler from HookInFlight to Fishing once its hook settled in a zone.
+	 * The server can't count on their anim blueprint's notifies, which drive the cast on their own machine, so it takes each step
+	 * itself: AFishingGamePlayerController launches the hook and finishes the reel, and this starts fishing in between.
+	 */
+	void StartFishingOnServer();
+
+	/** Puts the landed hook on the water surface of HookZone. */
+	void FloatHook();
+
+	/** Lets the floating hook ride the waves of HookZone until reeled in, off dedicated servers. */
+	void BobHook();
+
+	/** Server only. Lets an angler that stood idle for IdleDormancyDelay fall dormant. */
+	void CheckNetDormancy();
+
+	/** Bound only while dormant, wakes the angler as soon as it moves. */
+	UFUNCTION()
+	void OnDormantMovementUpdated(float DeltaSeconds, FVector OldLocation, FVector OldVelocity);
+
+	TWeakObjectPtr<class AFishingZone> HookZone;
+
 	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Settings")
 	float FishingWaitTime = 3.f;
 
+	/** Caught fish further than this from every local view are drawn by the instanced fish renderer instead of FishMesh. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Model")
+	float SkeletalFishDistance = 2500.f;
+
+	/** How long a biting fish waits to be reeled in before it swims away. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Settings")
+	float FishEscapeTime = 2.f;
+
+	/** Pull a biting fish puts on the rod line while it is hooked. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Settings")
+	FVector FishLineTension = FVector(0.f, 0.f, -1500.f);
+
 	bool bFishBiting = false;
 
-	FTimerHandle FishBiteTimerHandle;
-	FTimerHandle FailTimerHandle;
+	/** Length range in cm of fish caught in zones without a loot table. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Settings")
+	FVector2D CatchSizeRange = FVector2D(20.f, 80.f);
+
+	/** Server only. The bite on the hook, written to the catch journal if it is reeled in. */
+	bool bCatchPending = false;
+	int32 PendingCatchSpecies = INDEX_NONE;
+	float PendingCatchSize = 0.f;
+	float PendingReactionSeconds = 0.f;
+	float PendingWaitSeconds = 0.f;
+	uint32 PendingZoneId = 0;
+
+	void RecordCatch();
+
+	/** Slot of this angler in the world's UFishingBiteSubsystem. */
+	int32 BiteIndex = INDEX_NONE;
+
+	/** Slot of this angler in the world's UFishingAnglerUpdateSubsystem, which moves its hook while it is out. */
+	int32 HookUpdateIndex = INDEX_NONE;
+
+	/** Server only. Bite window of the fish on the hook, the bite subsystem only wakes the angler up when it ends. */
+	FFishingCastSim BiteSim;
+
+	class UFishingBiteSubsystem* GetBiteSubsystem() const;
+
+	class UFishingZoneSubsystem* GetZoneSubsystem() const;
+
+	class UFishingComponentPool* GetComponentPool() const;
+
+	float GetFishingWaitTime() const;
+
+	bool IsNearLocalView(float Distance) const;
 
 private:
 	/** Top down camera */
@@ -70,8 +288,8 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
 
-	/** A decal that projects to the cursor location. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+	/** A decal that projects to the cursor location. Pooled, and only set on the local player's own character. */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UDecalComponent* CursorToWorld;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Model", meta = (AllowPrivateAccess = "true"))
@@ -81,6 +299,6 @@ private:
 	UStaticMeshComponent* Hook;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Model", meta = (AllowPrivateAccess = "true"))
-	class UCableComponent* RodLine;
+	class UFishingLineComponent* RodLine;
 };
 
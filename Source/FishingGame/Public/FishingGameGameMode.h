@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "FishingGameGameMode.generated.h"
 
+struct FStreamableHandle;
+
 UCLASS(minimalapi)
 class AFishingGameGameMode : public AGameModeBase
 {
@@ -13,6 +15,26 @@ class AFishingGameGameMode : public AGameModeBase
 
 public:
 	AFishingGameGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	/** DefaultPawnSoftClass once it has streamed in. Never waits for it. */
+	virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+
+	/** Holds back players that join while DefaultPawnSoftClass is still streaming and restarts them once it has. */
+	virtual void RestartPlayer(AController* NewPlayer) override;
+
+protected:
+	/** Blueprinted pawn for players. Streamed in from InitGame rather than loaded with the game mode, DefaultPawnClass is used if it is unset. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Classes")
+	TSoftClassPtr<APawn> DefaultPawnSoftClass;
+
+private:
+	void OnPawnClassLoaded();
+
+	TSharedPtr<FStreamableHandle> PawnClassHandle;
+
+	TArray<TWeakObjectPtr<AController>> PendingRestarts;
 };
 
 
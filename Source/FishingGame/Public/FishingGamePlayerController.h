@@ -4,25 +4,56 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "FishingAnglerController.h"
+#include "FishingCastSim.h"
+#include "FishingInputReplay.h"
 #include "FishingGamePlayerController.generated.h"
 
+class FFishingInputTimestamps;
+class UFishingMoveToComponent;
+class UPathFollowingComponent;
+
 UCLASS()
-class AFishingGamePlayerController : public APlayerController
+class AFishingGamePlayerController : public APlayerController, public IFishingAnglerController
 {
 	GENERATED_BODY()
 
 public:
 	AFishingGamePlayerController();
 
-	void RemoveCastingWidget();
+	virtual void RemoveCastingWidget() override;
+
+	void ReadyThrowCast();
+
+	void ThrowCast();
+
+	/** Releases the cast at Progress. Clients forward the release to the server, which keeps the authoritative cast power. */
+	void ThrowCastAt(float Progress);
+
+	/** Cast power in [0, 1]. The charge meter of CastSim while the cast is held, frozen once it is thrown. */
+	virtual float GetCastingProgress() const override;
+
+	virtual bool GetIsFishing() const override { return bFishing; }
+
+	virtual bool GetInTransition() const override { return bTransition; }
+
+	virtual void SetCastingProgress(float Value) override { CastingProgress = Value; }
 
-	FORCEINLINE float GetCastingProgress() const { return CastingProgress; }
+	virtual void SetIsFishing(bool bValue) override { bFishing = bValue; }
 
-	FORCEINLINE bool GetIsFishing() const { return bFishing; }
+	virtual void SetInTransition(bool bValue) override { bTransition = bValue; }
 
-	FORCEINLINE bool GetInTransition() const { return bTransition; }
+	/** Runs Input as if the player gave it. Everything SetupInputComponent binds but the pause menu goes through here, see UFishingInputReplaySubsystem. */
+	void ApplyInput(EFishingInput Input, float Value = 0.f);
 
-	FORCEINLINE void SetCastingProgress(float Value) { CastingProgress = Value; }
+	/** Latest hit under the mouse cursor, shared by the cursor decal, click-to-move and hover logic. */
+	FORCEINLINE const FHitResult& GetCursorHit() const { return CursorHit; }
+
+	/** Frame number (GFrameCounter) at which CursorHit was last refreshed. */
+	FORCEINLINE uint64 GetCursorHitFrame() const { return CursorHitFrame; }
+
+	/** Also drops a click-to-move whose path is still being found. */
+	virtual void StopMovement() override;
 
 protected:
 	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Camera Controls")
@@ -46,9 +77,37 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Settings")
 	float CastingSpeed = 0.5f;
 
+	/** How far a client's cast power may differ from the charge time the server measured between the two RPCs. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Net")
+	float CastProgressTolerance = 0.15f;
+
+	/**
+	 * Seconds from a remote player's release to their hook leaving the rod, and from their reel to the hook being back, on the
+	 * server. Should match the launch notify of the cast animation and the length of the reel animation.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Net")
+	float RemoteLaunchDelay = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Net")
+	float RemoteReelDuration = 1.f;
+
+	/** Pending launch or end of reel of a remote player's cast. */
+	FTimerHandle RemoteCastTimer;
+
+	/** Trace against complex collision when resolving the cursor hit. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Cursor")
+	bool bTraceCursorComplex = true;
+
 	UPROPERTY(BlueprintReadOnly)
 	float CastingProgress = 0.f;
 
+	/** Charge of the current cast, timed by when the button went down and up rather than by the frames that saw it. */
+	FFishingCastSim CastSim;
+
+	/** Registered with Slate while this controller has a local player, see GetCastInputTime. */
+	TSharedPtr<FFishingInputTimestamps> InputTimestamps;
+
+	/** UFishingCastingBarWidget stays in the viewport and fills itself. Any other widget is added per cast and reads CastingProgress. */
 	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
 	TSubclassOf<UUserWidget> CastingBarWidgetClass;
 	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
@@ -56,6 +115,15 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|UI")
 	TSubclassOf<UUserWidget> PauseWidgetClass;
 
+	/** Follows the click-to-move paths, created here rather than on first use by SimpleMoveToLocation. */
+	UPROPERTY(VisibleAnywhere, Category = "FishingGame|Movement")
+	UPathFollowingComponent* PathFollowingComponent;
+
+	/** Finds the click-to-move paths, throttled while the mouse button is held. */
+	UPROPERTY(VisibleAnywhere, Category = "FishingGame|Movement")
+	UFishingMoveToComponent* MoveToComponent;
+
+	UPROPERTY(Transient)
 	UUserWidget* CastingBarWidget;
 	UUserWidget* ControlsWidget;
 	UUserWidget* PauseWidget;
@@ -63,9 +131,37 @@ protected:
 	/** True if the controlled character should navigate to the mouse cursor. */
 	uint32 bMoveToMouseCursor : 1;
 
+	/** Cached cursor query, refreshed by a single async trace per frame. */
+	FHitResult CursorHit;
+	uint64 CursorHitFrame = 0;
+
+	FTraceHandle CursorTraceHandle;
+	FTraceDelegate CursorTraceDelegate;
+
+	/** Cursor and view the last trace was issued from, used to skip redundant traces. */
+	FVector2D LastCursorPosition = FVector2D(-1.f, -1.f);
+	FVector LastCursorViewLocation = FVector::ZeroVector;
+	FRotator LastCursorViewRotation = FRotator::ZeroRotator;
+
 	virtual void PlayerTick(float DeltaSeconds) override;
 	virtual void SetupInputComponent() override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	template<EFishingInput Input>
+	void OnInputAction() { OnInput(Input, 0.f); }
+
+	template<EFishingInput Input>
+	void OnInputAxis(float Value) { OnInput(Input, Value); }
+
+	/** Records the player's input, or drops it while a recording replays, then applies it. */
+	void OnInput(EFishingInput Input, float Value);
+
+	/** Input recorder or replayer of this world, if this controller's input is being recorded or replayed. */
+	UFishingInputReplaySubsystem* GetInputReplay() const;
+
+	/** Mouse position in viewport pixels, or the replayed one. */
+	bool GetCursorPosition(FVector2D& OutPosition) const;
 
 	void MoveForward(float Value);
 
@@ -73,6 +169,13 @@ protected:
 
 	void MoveToMouseCursor();
 
+	/** Walking or about to: following a click-to-move path, or waiting for one. */
+	bool IsMovingToDestination() const;
+
+	void UpdateCursorHit();
+
+	void OnCursorTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
 	void RotateCamera(float Value);
 	
 	void ZoomCamera(float Value);
@@ -82,13 +185,34 @@ protected:
 	void OnSetDestinationPressed();
 	void OnSetDestinationReleased();
 
-	void ReadyThrowCast();
+	void TogglePauseMenu();
 
-	void ThrowCast();
+	UFUNCTION(Server, Reliable)
+	void ServerReadyThrowCast();
 
-	void TogglePauseMenu();
+	UFUNCTION(Server, Reliable)
+	void ServerThrowCast(uint8 ClientCastPower);
 
 	bool CheckIsFishing() const;
+
+	/**
+	 * Server only, for remote players: the steps their anim blueprint's notifies take on their own machine. Either does nothing
+	 * if the step already happened, so a notify getting there first on the server changes nothing.
+	 */
+	void LaunchRemoteHook();
+	void FinishRemoteReel();
+
+	/**
+	 * World time the cast button last went down, respectively up: when Slate saw it for the local player's own input, now for
+	 * replayed input and on the server, which only learns of a remote player's input from its RPC.
+	 */
+	double GetCastInputTime(bool bPressed) const;
+
+	/** Releases the charge of CastSim at the release's input time and returns the cast power it reached, CastingProgress if nothing was charging. */
+	float ReleaseCharge();
+
+	/** Keeps CastingProgress and a native casting bar in step with the charge of CastSim, on the world's clock. */
+	void UpdateCharge();
 };
 
 
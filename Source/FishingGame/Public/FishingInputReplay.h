@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FishingInputReplay.generated.h"
+
+class AFishingGamePlayerController;
+
+/** What AFishingGamePlayerController binds in SetupInputComponent, except the pause menu, plus the cursor position. */
+UENUM()
+enum class EFishingInput : uint8
+{
+	SetDestinationPressed,
+	SetDestinationReleased,
+	ThrowCastPressed,
+	ThrowCastReleased,
+	MoveForward,
+	MoveRight,
+	RotateCamera,
+	ZoomCamera,
+	Cursor,
+
+	Num UMETA(Hidden)
+};
+
+namespace FishingInput
+{
+	constexpr uint8 FirstAxis = (uint8)EFishingInput::MoveForward;
+	constexpr uint8 NumAxes = (uint8)EFishingInput::Cursor - FirstAxis;
+
+	FORCEINLINE bool IsAxis(EFishingInput Input) { return (uint8)Input >= FirstAxis && (uint8)Input < FirstAxis + NumAxes; }
+}
+
+/**
+ * Records the local player's input to Saved/FishingInput/<Name>.fir and replays it, so a session played once by hand can be rerun
+ * headless in perf runs and produce comparable frame time traces.
+ *
+ * Record with -FishingRecordInput=<Name> (or "Fishing.RecordInput <Name>", again without a name to stop), replay with
+ *   FishingGame FishingLake -game -nullrhi -unattended -ResX=1920 -ResY=1080 -FishingReplayInput=<Name>
+ * A replay runs at a fixed time step using the recorded frame times and reseeds the global, loot and fish school random streams
+ * with the recorded seeds, so fishing timers, bites and casts land on the same frames every replay. The whole replay is captured
+ * by the CSV profiler, and unattended runs quit once it is over. Cursor positions are stored relative to the viewport, so replay
+ * at the resolution the session was recorded at.
+ *
+ * The file is a header (magic, version, seeds, map, frame count) followed by one record per frame:
+ *   packed (NumEvents << 1 | bDeltaTimeChanged), [zigzag packed change of the frame time in microseconds], events
+ * Each event is its EFishingInput byte, then for axes, which are only written when they change, a packed zigzag value in
+ * 1/AxisScale steps (or 1 and the raw float when the value isn't on that grid), and for the cursor the zigzag packed move
+ * in 1/65535ths of the viewport. A frame without input that took as long as the one before costs one byte.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingInputReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr uint32 FileMagic = 0x50524946;	// "FIRP"
+	static constexpr uint32 FileVersion = 1;
+	static constexpr float AxisScale = 4096.f;
+
+	static FString GetRecordingPath(const FString& Name);
+
+	bool StartRecording(const FString& Name);
+
+	/** Writes the recording out. */
+	void StopRecording();
+
+	bool StartReplay(const FString& Name);
+
+	void StopReplay();
+
+	FORCEINLINE bool IsRecording() const { return !RecordingName.IsEmpty(); }
+
+	FORCEINLINE bool IsReplaying() const { return !ReplayName.IsEmpty(); }
+
+	/** The first local player controller asking records or replays, any other is left alone. */
+	bool IsInputOwner(const AFishingGamePlayerController* Controller);
+
+	/** Recording only. Adds an input Controller just ran to the current frame. Axes that didn't change are skipped. */
+	void RecordInput(EFishingInput Input, float Value);
+
+	/** Recording only. Cursor position in [0, 1] of the viewport. */
+	void RecordCursor(const FVector2D& Position);
+
+	/** Recording only. Closes the current frame, DeltaTime is its undilated frame time. */
+	void EndFrame(float DeltaTime);
+
+	/** Replaying only. Runs the next recorded frame's input on Controller. Stops the replay once the recording ran out. */
+	void ReplayFrame(AFishingGamePlayerController* Controller);
+
+	/** Replaying only. Cursor position in [0, 1] of the viewport. */
+	FORCEINLINE const FVector2D& GetReplayCursor() const { return Cursor; }
+
+	FORCEINLINE int32 GetNumFrames() const { return NumFrames; }
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+private:
+	struct FHeader
+	{
+		uint32 Magic = FileMagic;
+		uint32 Version = FileVersion;
+		int32 RandomSeed = 0;
+		int32 FishSeed = 0;
+		FString MapName;
+		uint32 NumFrames = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FHeader& Header)
+		{
+			return Ar << Header.Magic << Header.Version << Header.RandomSeed << Header.FishSeed << Header.MapName << Header.NumFrames;
+		}
+	};
+
+	/** Seeds every random stream the fishing loop draws from. */
+	void ApplySeeds(int32 RandomSeed, int32 FishSeed);
+
+	/** Reads the next frame's header and puts its frame time on the engine's fixed time step. False at the end of the recording. */
+	bool ReadFrameHeader();
+
+	void EndCsvCapture();
+
+	TWeakObjectPtr<const AFishingGamePlayerController> InputOwner;
+
+	FString RecordingName;
+	FString ReplayName;
+
+	/** Frames recorded or replayed so far. */
+	int32 NumFrames = 0;
+
+	FHeader Header;
+	TArray<uint8> Data;
+	int64 ReadOffset = 0;
+
+	/** Events of the frame being recorded. */
+	TArray<uint8> FrameEvents;
+	int32 NumFrameEvents = 0;
+
+	/** Events in the next frame to replay. */
+	int32 PendingEvents = 0;
+
+	/** Last frame time, axis values and cursor written or read, everything is stored as changes from them. */
+	uint32 DeltaMicros = 0;
+	float Axes[FishingInput::NumAxes] = {};
+	FIntPoint CursorSteps = FIntPoint::ZeroValue;
+	FVector2D Cursor = FVector2D::ZeroVector;
+
+	bool bUsedFixedTimeStep = false;
+	double FixedDeltaTimeBefore = 0.0;
+	bool bCapturingCsv = false;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "InputCoreTypes.h"
+
+class UWorld;
+
+/**
+ * Slate input preprocessor that stamps every key and mouse button press and release with the platform time it was pumped at.
+ * Input bindings only run in the player controller's tick, as much as a frame after the button moved; the stamps let the fishing
+ * simulation take the moment the player pressed instead of the frame that got to see it.
+ */
+class FISHINGGAME_API FFishingInputTimestamps : public IInputProcessor
+{
+public:
+	virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override {}
+	virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override;
+	virtual bool HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override;
+	virtual bool HandleMouseButtonDownEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override;
+	virtual bool HandleMouseButtonUpEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override;
+	virtual bool HandleMouseButtonDoubleClickEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override;
+
+	/** Platform seconds of the latest press, respectively release, of Key, 0 if none was seen. */
+	double GetEventTime(const FKey& Key, bool bPressed) const;
+
+	/**
+	 * World seconds of PlatformTime in World, by how long before the current frame's time it was. Clamped to the span since the
+	 * previous frame, the only one the stamp of an input handled this frame can fall in.
+	 */
+	static double ToWorldTime(const UWorld* World, double PlatformTime);
+
+private:
+	void Stamp(const FKey& Key, bool bPressed);
+
+	TMap<FKey, double> PressTimes;
+	TMap<FKey, double> ReleaseTimes;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CableComponent.h"
+#include "FishingLineComponent.generated.h"
+
+/** Cable resolution used while the line covers at least MinScreenSize of the screen. */
+USTRUCT(BlueprintType)
+struct FFishingLineLOD
+{
+	GENERATED_BODY()
+
+	FFishingLineLOD() = default;
+
+	FFishingLineLOD(float InMinScreenSize, int32 InNumSegments, int32 InSolverIterations)
+		: MinScreenSize(InMinScreenSize), NumSegments(InNumSegments), SolverIterations(InSolverIterations)
+	{
+	}
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line", meta = (ClampMin = "0.0"))
+	float MinScreenSize = 0.f;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line", meta = (ClampMin = "1", ClampMax = "20"))
+	int32 NumSegments = 10;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line", meta = (ClampMin = "1", ClampMax = "16"))
+	int32 SolverIterations = 1;
+};
+
+/**
+ * Fishing line built on the cable component that only runs the Verlet solver while it has something to solve.
+ * The line sleeps once both ends have been still for SleepDelay, stops simulating off-screen or beyond MaxSimulationDistance
+ * (its bounds then come from the analytic catenary between its end points), and picks segment count and solver iterations from LODs by screen size.
+ */
+UCLASS(ClassGroup = Rendering, meta = (BlueprintSpawnableComponent))
+class FISHINGGAME_API UFishingLineComponent : public UCableComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFishingLineComponent();
+
+	/** Pull from a hooked fish, applied as cable force while the line simulates. Non-zero tension keeps the line awake. */
+	UFUNCTION(BlueprintCallable, Category = "FishingGame|Line")
+	void SetLineTension(const FVector& Force);
+
+	UFUNCTION(BlueprintCallable, Category = "FishingGame|Line")
+	void WakeLine();
+
+	FORCEINLINE bool IsLineSleeping() const { return bSleeping; }
+
+	FORCEINLINE int32 GetCurrentLOD() const { return CurrentLOD; }
+
+	/** Evaluates the catenary the line would rest in between its current end points. Alpha runs from start (0) to end (1). */
+	FVector GetCatenaryLocation(float Alpha) const;
+
+	/** Solver time and number of simulated lines since the last call, summed over every fishing line. */
+	static void ConsumeSolveStats(double& OutSolveMs, int32& OutSimulatedLines);
+
+	/** Makes every fishing line pick a LOD this many steps coarser than its screen size asks for. Set by the scalability governor. */
+	static void SetLODBias(int32 Bias) { LODBias = FMath::Max(Bias, 0); }
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+protected:
+	virtual void OnRegister() override;
+
+	/** End points move less than this (cm) per tick to count as still. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line", meta = (ClampMin = "0.0"))
+	float SleepDistance = 0.5f;
+
+	/** Seconds both ends must stay still before the line sleeps. Long enough for the cable to settle. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line", meta = (ClampMin = "0.0"))
+	float SleepDelay = 1.f;
+
+	/** Lines further than this from every local view never simulate. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line", meta = (ClampMin = "0.0"))
+	float MaxSimulationDistance = 6000.f;
+
+	/** Sorted from highest to lowest MinScreenSize. The first LOD the line is big enough for wins. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Line")
+	TArray<FFishingLineLOD> LODs;
+
+private:
+	void GetLineEndPoints(FVector& OutStart, FVector& OutEnd) const;
+	float GetScreenSize(const FVector& Start, const FVector& End, float& OutDistance) const;
+	int32 SelectLOD(float ScreenSize) const;
+	void ApplyPendingLOD();
+
+	FVector LastStart = FVector::ZeroVector;
+	FVector LastEnd = FVector::ZeroVector;
+	FVector Tension = FVector::ZeroVector;
+	float StillTime = 0.f;
+	int32 CurrentLOD = INDEX_NONE;
+	int32 PendingLOD = INDEX_NONE;
+	bool bSleeping = false;
+	bool bLastAttachEnd = false;
+
+	static double SolveSeconds;
+	static int32 SimulatedLines;
+	static int32 LODBias;
+};
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataTable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "FishingLootTable.generated.h"
+
+class AFishingZone;
+
+/** Hours of the day in which a species' weight is scaled. Wraps past midnight when StartHour > EndHour. */
+USTRUCT(BlueprintType)
+struct FISHINGGAME_API FFishSpeciesTimeWindow
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0", ClampMax = "24"))
+	float StartHour = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0", ClampMax = "24"))
+	float EndHour = 24.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0"))
+	float WeightScale = 1.f;
+
+	FORCEINLINE bool Contains(float Hour) const
+	{
+		return StartHour <= EndHour ? (Hour >= StartHour && Hour < EndHour) : (Hour >= StartHour || Hour < EndHour);
+	}
+};
+
+/** One species of a zone's loot table. */
+USTRUCT(BlueprintType)
+struct FISHINGGAME_API FFishSpeciesRow : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	/** Written to the catch journal and used to pick the fish mesh. Keep it unique across every loot table. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0", ClampMax = "65534"))
+	int32 SpeciesId = 0;
+
+	/** Relative chance of this species biting. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0"))
+	float Weight = 1.f;
+
+	/** Length in cm is MinSize + (MaxSize - MinSize) * U^SizeExponent for uniform U, so exponents above 1 favour small fish. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0"))
+	float MinSize = 20.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0"))
+	float MaxSize = 80.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0.01"))
+	float SizeExponent = 1.f;
+
+	/** Scales the zone's wait before this species bites. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot", meta = (ClampMin = "0"))
+	float BiteWaitScale = 1.f;
+
+	/** Weight is multiplied by every window containing the time of day. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "FishingGame|Loot")
+	TArray<FFishSpeciesTimeWindow> TimeWindows;
+
+	float GetWeightAt(float Hour) const;
+
+	FORCEINLINE float SampleSize(float U) const
+	{
+		return MinSize + (MaxSize - MinSize) * FMath::Pow(U, SizeExponent);
+	}
+};
+
+/**
+ * Walker's alias method (Vose's construction): built in O(n) from a list of weights,
+ * then samples an index with probability proportional to its weight in O(1) however many entries there are.
+ */
+struct FISHINGGAME_API FFishingAliasTable
+{
+	void Build(TArrayView<const float> Weights);
+
+	/** INDEX_NONE if every weight was zero. */
+	FORCEINLINE int32 Sample(FRandomStream& Random) const
+	{
+		if (Probability.Num() == 0)
+		{
+			return INDEX_NONE;
+		}
+		const int32 Index = Random.RandHelper(Probability.Num());
+		return Random.GetFraction() < Probability[Index] ? Index : Alias[Index];
+	}
+
+	FORCEINLINE int32 Num() const { return Probability.Num(); }
+
+private:
+	/** Chance of keeping column i rather than taking Alias[i]. */
+	TArray<float> Probability;
+	TArray<int32> Alias;
+};
+
+/** What bites next: a species from a loot table and the size it was rolled at. */
+struct FFishingLootRoll
+{
+	int32 SpeciesId = INDEX_NONE;
+	float Size = 0.f;
+	float BiteWaitScale = 1.f;
+};
+
+/**
+ * Compiles the loot tables of the world's fishing zones into alias tables and rolls bites from them.
+ * A table is compiled once however many zones share it. Changing the time of day only recompiles
+ * the tables in which some time window opened or closed.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingLootSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Compiles Table if it isn't yet. Called as zones begin play so no bite pays for it. */
+	void PrepareTable(const UDataTable* Table);
+
+	/** Species, size and wait scale of the next bite in Zone. False if the zone has no loot table or nothing can bite right now. */
+	bool Roll(const AFishingZone* Zone, FFishingLootRoll& OutRoll);
+
+	bool Roll(const AFishingZone* Zone, FRandomStream& Random, FFishingLootRoll& OutRoll);
+
+	/** Size of a fish whose species is already known, e.g. a simulated fish that took the hook. */
+	bool RollSize(const AFishingZone* Zone, int32 SpeciesId, FFishingLootRoll& OutRoll);
+
+	FORCEINLINE float GetTimeOfDay() const { return TimeOfDay; }
+
+	void SetTimeOfDay(float Hours);
+
+	/** Reseeds the rolls, e.g. so a replayed session catches the same fish. Randomly seeded otherwise. */
+	FORCEINLINE void SetSeed(int32 Seed) { Random.Initialize(Seed); }
+
+	/** Tables compiled since the world started, including recompiles for the time of day. */
+	FORCEINLINE int32 GetNumCompiles() const { return NumCompiles; }
+
+private:
+	struct FCompiledTable
+	{
+		TArray<FFishSpeciesRow> Rows;
+		TMap<int32, int32> RowBySpecies;
+		FFishingAliasTable Alias;
+
+		/** Open state of every time window of every row, in row order, when the table was last compiled. */
+		TBitArray<> OpenWindows;
+	};
+
+	const FCompiledTable* FindTable(const AFishingZone* Zone);
+
+	/** Rebuilds the alias table from the rows' weights at the current time of day. */
+	void BuildAlias(FCompiledTable& Compiled);
+
+	void GetOpenWindows(const FCompiledTable& Compiled, TBitArray<>& OutOpen) const;
+
+	TMap<TObjectKey<UDataTable>, FCompiledTable> Tables;
+	FRandomStream Random;
+	float TimeOfDay = 12.f;
+	int32 NumCompiles = 0;
+};
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "NavigationData.h"
+#include "FishingMoveToComponent.generated.h"
+
+class UPathFollowingComponent;
+
+/**
+ * Click-to-move for a controller, cheap enough to be fed a new goal every frame while the mouse button is held.
+ * Paths are found asynchronously, one query in flight at a time and no more often than MinQueryInterval; goals arriving meanwhile
+ * are coalesced into the next query. A goal that barely moved keeps the current path, and one that moved a little bends the
+ * path's last leg towards it when the navmesh is clear in between, without any query.
+ * The path is followed by the controller's UPathFollowingComponent, like UAIBlueprintHelperLibrary::SimpleMoveToLocation does.
+ */
+UCLASS(ClassGroup = Navigation)
+class FISHINGGAME_API UFishingMoveToComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFishingMoveToComponent();
+
+	/** Moves the owning controller's pawn to Goal. */
+	void MoveTo(const FVector& Goal);
+
+	/** Drops the goal, any query in flight and any goal waiting for one. The path being followed is AController::StopMovement's to abort. */
+	void StopMove();
+
+	/** A move was asked for and its path hasn't arrived yet. */
+	FORCEINLINE bool IsMovePending() const { return QueryId != INVALID_NAVQUERYID || bHasPendingGoal; }
+
+	/**
+	 * Feeds HeldSeconds of goals sweeping around the pawn at 60 frames per second, first through a synchronous query per frame as
+	 * SimpleMoveToLocation did, then through the throttled path updates, and logs the pathfinding time per second held of each.
+	 */
+	void RunBenchmark(float HeldSeconds, float Radius);
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	/** Goals closer than this to the current one keep the path. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Movement")
+	float KeepDistance = 30.f;
+
+	/** Goals closer than this to the current one bend the path's last leg instead of querying a new path, if the navmesh allows. */
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Movement")
+	float PatchDistance = 300.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "FishingGame|Movement")
+	float MinQueryInterval = 0.1f;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	enum class EGoalUpdate : uint8
+	{
+		Keep,
+		Patch,
+		Query,
+		Defer
+	};
+
+	EGoalUpdate ClassifyGoal(const FVector& Goal, const FVector& CurrentGoal, bool bMoving, bool bCanQuery) const;
+
+	/** Ends Path at Goal if the navmesh is clear between its last corner and Goal. */
+	bool PatchPath(FNavigationPath& Path, const FVector& Goal) const;
+
+	void StartQuery(const FVector& Goal);
+
+	void OnQueryDone(uint32 InQueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** Finds the navmesh and builds a query from the pawn to Goal. False if the owner has no pawn or the pawn no navmesh. */
+	bool MakeQuery(const FVector& Goal, FPathFindingQuery& OutQuery) const;
+
+	APawn* GetPawn() const;
+
+	UPathFollowingComponent* GetPathFollowing() const;
+
+	FNavPathQueryDelegate QueryDelegate;
+	uint32 QueryId = INVALID_NAVQUERYID;
+	float LastQueryTime = -BIG_NUMBER;
+
+	/** Goal of the path being followed or queried. */
+	FVector MoveGoal = FVector::ZeroVector;
+	bool bHasMoveGoal = false;
+
+	/** Latest goal that had to wait for the query in flight or the interval. */
+	FVector PendingGoal = FVector::ZeroVector;
+	bool bHasPendingGoal = false;
+};
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "FishingNetTypes.generated.h"
+
+/** Where an angler is in the cast -> wait -> bite -> reel loop. Replicated as three bits, so keep it under eight entries. */
+UENUM(BlueprintType)
+enum class EFishingPhase : uint8
+{
+	Idle,
+	Charging,
+	Casting,
+	HookInFlight,
+	Fishing,
+	Biting,
+	Reeling
+};
+
+namespace FishingNet
+{
+	/** True for the phases in which the hook is away from the rod. */
+	FORCEINLINE bool IsHookOut(EFishingPhase Phase)
+	{
+		return Phase >= EFishingPhase::HookInFlight && Phase <= EFishingPhase::Reeling;
+	}
+
+	FORCEINLINE uint8 QuantizeProgress(float Progress)
+	{
+		return (uint8)FMath::RoundToInt(FMath::Clamp(Progress, 0.f, 1.f) * 255.f);
+	}
+
+	FORCEINLINE float DequantizeProgress(uint8 Progress)
+	{
+		return Progress / 255.f;
+	}
+
+	/** Static name of Phase for logs, CSV events and trace bookmarks. */
+	FISHINGGAME_API const TCHAR* GetPhaseName(EFishingPhase Phase);
+}
+
+/**
+ * Server-authoritative fishing state of one angler, packed to a few bytes:
+ * 3 bits of phase, 1 bit for a fish on the hook, a cast power byte, the server time the phase began in centiseconds and,
+ * only while a fish is on, its species.
+ */
+USTRUCT(BlueprintType)
+struct FISHINGGAME_API FFishingNetState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FishingGame|Net")
+	EFishingPhase Phase = EFishingPhase::Idle;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FishingGame|Net")
+	bool bFishOnHook = false;
+
+	/** Cast power the hook was thrown with, quantized to a byte. */
+	UPROPERTY(BlueprintReadOnly, Category = "FishingGame|Net")
+	uint8 CastPower = 0;
+
+	/** Server world time the phase started at. */
+	UPROPERTY(BlueprintReadOnly, Category = "FishingGame|Net")
+	float PhaseStartTime = 0.f;
+
+	/** Species of the fish on the hook, so every machine shows the one the server rolled. 0 without a fish. */
+	UPROPERTY(BlueprintReadOnly, Category = "FishingGame|Net")
+	uint16 Species = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FFishingNetState& Other) const
+	{
+		return Phase == Other.Phase && bFishOnHook == Other.bFishOnHook && CastPower == Other.CastPower && PhaseStartTime == Other.PhaseStartTime && Species == Other.Species;
+	}
+
+	bool operator!=(const FFishingNetState& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FFishingNetState> : public TStructOpsTypeTraitsBase2<FFishingNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+/**
+ * Parameters of a kinematic cast. Sent once per cast; every client flies the hook along the same FFishingCastTrajectory locally
+ * instead of receiving its transform each frame.
+ */
+USTRUCT()
+struct FISHINGGAME_API FFishingHookLaunch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Velocity;
+
+	UPROPERTY()
+	FVector_NetQuantize10 LandingLocation;
+
+	UPROPERTY()
+	float LandingTime = 0.f;
+
+	/** Server world time the hook left the rod, so late receivers can catch up along the path. */
+	UPROPERTY()
+	float LaunchTime = 0.f;
+
+	UPROPERTY()
+	bool bHasLanding = false;
+
+	/** Bumped on every cast so two identical casts in a row still replicate. */
+	UPROPERTY()
+	uint8 LaunchCount = 0;
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BasicReplicationGraph.h"
+#include "FishingReplicationGraph.generated.h"
+
+/** How often an angler within Distance of a connection's viewer replicates to it. */
+USTRUCT()
+struct FFishingReplicationBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Net")
+	float Distance = 0.f;
+
+	/** Net frames between two replications, 1 is every frame. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Net", meta = (ClampMin = "1"))
+	int32 ReplicationPeriodFrame = 1;
+};
+
+/**
+ * Lowers how often an angler replicates to this connection the further it is from the connection's viewers, through the
+ * connection's own replication period of the angler. Adds no actors itself; which anglers are relevant at all is left to the grid,
+ * and only the anglers it gathered for the connection are bucketed; global nodes gather before connection nodes.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingReplicationGraphNode_AnglerFrequency : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	/** Distance buckets, closest first. Set by UFishingReplicationGraph. */
+	const TArray<FFishingReplicationBucket>* Buckets = nullptr;
+
+	/** Net frames between two passes over the gathered anglers, staggered between connections by Offset. */
+	uint32 RefreshPeriod = 4;
+	uint32 Offset = 0;
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+/**
+ * Replication graph for tournament servers with a hundred or more anglers on one lake, enabled through ReplicationDriverClassName
+ * in DefaultEngine.ini. On top of UBasicReplicationGraph (a spatial grid for anglers and everything else that moves, an
+ * always-relevant node, and the owner-only actors of each connection) fishing zones are relevant to everyone, anglers are culled
+ * at AnglerCullDistance, and each connection gets anglers less often the further away they are, per Buckets.
+ * "Fishing.NetReport [Seconds]" logs the server time spent per net tick and the outgoing bandwidth. There is no bot client to
+ * load a dedicated server with yet, so comparing it against the default replication path takes real clients connected to both.
+ */
+UCLASS(Transient, Config = Engine)
+class FISHINGGAME_API UFishingReplicationGraph : public UBasicReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UFishingReplicationGraph();
+
+	UPROPERTY(Config)
+	float GridCellSize = 10000.f;
+
+	/** Lowest X and Y of the grid, anything below lands in its first cells. */
+	UPROPERTY(Config)
+	FVector2D GridSpatialBias = FVector2D(-150000.f, -150000.f);
+
+	UPROPERTY(Config)
+	float AnglerCullDistance = 15000.f;
+
+	/** Closest first. Anglers past the last bucket, still within AnglerCullDistance, use its period. */
+	UPROPERTY(Config)
+	TArray<FFishingReplicationBucket> Buckets;
+
+	UPROPERTY(Config)
+	int32 BucketRefreshPeriod = 4;
+
+	/** Logs the net tick time and outgoing bandwidth averaged over the next Seconds. */
+	void StartReport(float Seconds);
+
+	virtual void InitGlobalActorClassSettings() override;
+
+	virtual void InitGlobalGraphNodes() override;
+
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+private:
+	struct FReport
+	{
+		double EndTime = 0.0;
+		double StartTime = 0.0;
+		uint32 StartOutBytes = 0;
+		int32 NetTicks = 0;
+		double TotalMs = 0.0;
+		double PeakMs = 0.0;
+	};
+
+	void FinishReport();
+
+	int32 NumAnglers = 0;
+	uint32 NumConnectionNodes = 0;
+
+	TOptional<FReport> Report;
+};
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingFrameGovernor.h"
+#include "FishingScalabilitySubsystem.generated.h"
+
+class UMaterialInterface;
+class UMeshComponent;
+struct FStreamableHandle;
+
+/** What one quality tier of the governor costs. */
+USTRUCT()
+struct FFishingScalabilityTier
+{
+	GENERATED_BODY()
+
+	/** Added to the LOD every fishing line picks by screen size. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Scalability", meta = (ClampMin = "0"))
+	int32 LineLODBias = 0;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Scalability")
+	bool bBiteFX = true;
+
+	/** Scales the foliage.DensityScale and grass.DensityScale the scalability settings chose, picked up as foliage and grass are rebuilt. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Scalability", meta = (ClampMin = "0", ClampMax = "1"))
+	float FoliageDensity = 1.f;
+};
+
+/** Variants of one water surface material, from the cheapest tier to the best; tiers past the last reuse it. */
+USTRUCT()
+struct FFishingWaterMaterialTiers
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Scalability")
+	TArray<TSoftObjectPtr<UMaterialInterface>> Materials;
+};
+
+/**
+ * Holds the frame time to a budget by stepping the water surfaces, bite VFX, fishing line detail and foliage density through
+ * Tiers, from 0 (cheapest) up. The frame time is the slowest of the game thread, render thread and GPU, and FFishingFrameGovernor
+ * decides the tier from it. The game starts on the top tier, the authored look, and nothing is touched until the governor steps down.
+ * Water surfaces are the mesh components using any material of WaterMaterials; every variant is loaded up front so a change
+ * never waits on a load. Pin a tier with "Fishing.Governor <Tier>" for benchmarks, -1 hands it back to the governor.
+ */
+UCLASS(Config = Game)
+class FISHINGGAME_API UFishingScalabilitySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UFishingScalabilitySubsystem();
+
+	UPROPERTY(Config)
+	float TargetFrameMs = 16.67f;
+
+	UPROPERTY(Config)
+	float Percentile = 0.9f;
+
+	UPROPERTY(Config)
+	int32 WindowFrames = 90;
+
+	UPROPERTY(Config)
+	float DowngradeThreshold = 1.05f;
+
+	UPROPERTY(Config)
+	float UpgradeThreshold = 0.75f;
+
+	UPROPERTY(Config)
+	float DowngradeDelay = 1.f;
+
+	UPROPERTY(Config)
+	float UpgradeDelay = 5.f;
+
+	UPROPERTY(Config)
+	float ChangeCooldown = 2.f;
+
+	UPROPERTY(Config)
+	float UpgradeProbation = 15.f;
+
+	UPROPERTY(Config)
+	int32 MaxUpgradeBackoff = 3;
+
+	/** Cheapest first. */
+	UPROPERTY(Config)
+	TArray<FFishingScalabilityTier> Tiers;
+
+	UPROPERTY(Config)
+	TArray<FFishingWaterMaterialTiers> WaterMaterials;
+
+	FFishingFrameGovernor::FSettings GetGovernorSettings() const;
+
+	FORCEINLINE int32 GetTier() const { return Governor.GetTier(); }
+
+	/** Pins Tier, or hands the tier back to the governor with INDEX_NONE. */
+	void ForceTier(int32 Tier);
+
+	FORCEINLINE bool AllowsBiteFX() const { return !Tiers.IsValidIndex(AppliedTier) || Tiers[AppliedTier].bBiteFX; }
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return Tiers.Num() > 1; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FWaterSlot
+	{
+		TWeakObjectPtr<UMeshComponent> Component;
+		int32 Slot = 0;
+		int32 Family = 0;
+	};
+
+	void ApplyTier(int32 Tier);
+
+	void ApplyWaterTier(int32 Tier);
+
+	/** Sets foliage.DensityScale and grass.DensityScale to Density times their values at Initialize. */
+	void SetFoliageDensity(float Density);
+
+	/** Finds the mesh slots using a water material. */
+	void CollectWaterSlots();
+
+	/** Index into WaterMaterials of the family Material, or of the material it was made from, belongs to. */
+	int32 FindWaterFamily(const UMaterialInterface* Material) const;
+
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	FFishingFrameGovernor Governor;
+	int32 ForcedTier = INDEX_NONE;
+
+	/** Tier the world currently looks like. */
+	int32 AppliedTier = INDEX_NONE;
+
+	/** foliage.DensityScale and grass.DensityScale as the FoliageQuality scalability group left them. */
+	float BaseFoliageDensityScale = 1.f;
+	float BaseGrassDensityScale = 1.f;
+
+	TMap<FSoftObjectPath, int32> WaterFamilyByMaterial;
+	TArray<FWaterSlot> WaterSlots;
+	bool bWaterSlotsDirty = true;
+	TSharedPtr<FStreamableHandle> WaterMaterialsHandle;
+	FDelegateHandle LevelAddedHandle;
+};
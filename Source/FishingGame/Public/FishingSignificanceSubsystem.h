@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingSignificanceSubsystem.generated.h"
+
+class AFishingGameCharacter;
+enum class EVisibilityBasedAnimTickOption : uint8;
+
+/** How much an NPC angler matters to the players, from most to least. */
+UENUM()
+enum class EFishingSignificance : uint8
+{
+	/** Close and on screen: full tick rate and cosmetics. Player anglers always stay here. */
+	Full,
+	/** On screen: throttled ticks, cosmetics kept. */
+	Reduced,
+	/** Far or off screen but nearby: slow ticks, no line or bite VFX. */
+	Low,
+	/** Off screen and far, or nobody is watching: barely ticks. */
+	Culled,
+
+	Num UMETA(Hidden)
+};
+
+/**
+ * Significance manager of the NPC anglers, run on every machine for the anglers it has.
+ * A few times a second every angler is scored by its distance to the closest player view and whether it was rendered lately, and the best
+ * ones are handed out the Full and Reduced levels up to a budget. Servers count the views of their remote players too, and since they
+ * can't tell what those players see, take anglers close to them as on screen. The level sets the angler's actor, movement and mesh tick intervals and
+ * switches its fishing line and bite VFX off when nobody would see them; skeletal meshes always run with update rate optimizations.
+ * Below Full, NPC meshes on clients and listen servers stop ticking their pose when not rendered.
+ * Fishing decisions of all anglers are stepped here in one batch on the server, each angler as often as its level's interval.
+ */
+UCLASS(Config = Game)
+class FISHINGGAME_API UFishingSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Seconds between two scoring passes. */
+	UPROPERTY(Config)
+	float ScoreInterval = 0.25f;
+
+	/** Anglers beyond these distances from every player view can't be Full, respectively Reduced. */
+	UPROPERTY(Config)
+	float FullDistance = 2500.f;
+
+	UPROPERTY(Config)
+	float ReducedDistance = 8000.f;
+
+	/** Most anglers at Full and Reduced, the rest of the crowd drops a level even when close. */
+	UPROPERTY(Config)
+	int32 MaxFullAnglers = 16;
+
+	UPROPERTY(Config)
+	int32 MaxReducedAnglers = 64;
+
+	/** Scales the score of anglers that weren't rendered within VisibilityTimeout, so visible ones win the budget. */
+	UPROPERTY(Config)
+	float HiddenScoreScale = 0.25f;
+
+	UPROPERTY(Config)
+	float VisibilityTimeout = 0.5f;
+
+	/** Tick and decision interval per level. Full always ticks every frame. */
+	UPROPERTY(Config)
+	float ReducedInterval = 0.066f;
+
+	UPROPERTY(Config)
+	float LowInterval = 0.25f;
+
+	UPROPERTY(Config)
+	float CulledInterval = 1.f;
+
+	/** Every angler registers itself; the ones a player controls are just kept at Full. */
+	void RegisterAngler(AFishingGameCharacter* Character);
+
+	void UnregisterAngler(AFishingGameCharacter* Character);
+
+	FORCEINLINE int32 GetNumAnglers() const { return Anglers.Num(); }
+
+	FORCEINLINE int32 GetNumAnglersAt(EFishingSignificance Level) const { return NumAtLevel[(uint8)Level]; }
+
+	/** Puts every angler at Level regardless of its score, or back to scoring with EFishingSignificance::Num. Used to benchmark each level. */
+	void ForceSignificance(EFishingSignificance Level);
+
+	float GetInterval(EFishingSignificance Level) const;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return Anglers.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FSignificantAngler
+	{
+		TWeakObjectPtr<AFishingGameCharacter> Character;
+		EFishingSignificance Level = EFishingSignificance::Num;
+		float Score = 0.f;
+		/** Time since the angler's last fishing decision. */
+		float DecisionTime = 0.f;
+		/** The mesh's own option, put back at Full. */
+		EVisibilityBasedAnimTickOption AnimTickOption = (EVisibilityBasedAnimTickOption)0;
+	};
+
+	void UpdateSignificance();
+
+	void StepDecisions(float DeltaTime);
+
+	void ApplySignificance(const FSignificantAngler& Angler, EFishingSignificance Level) const;
+
+	TArray<FSignificantAngler> Anglers;
+	TArray<int32> SortedAnglers;
+	TArray<FVector> ViewLocations;
+	/** Per entry of ViewLocations, whether it's a remote player's, whose rendering this machine can't see. */
+	TBitArray<> RemoteViews;
+	int32 NumAtLevel[(uint8)EFishingSignificance::Num] = {};
+	EFishingSignificance ForcedLevel = EFishingSignificance::Num;
+	float ScoreTime = 0.f;
+};
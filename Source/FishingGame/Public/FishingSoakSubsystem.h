@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingSoakSubsystem.generated.h"
+
+class AController;
+class AFishingGameCharacter;
+class UFishingSoakSubsystem;
+
+/** Marks the start or end of the physics tick groups so the soak run can time the physics window. */
+USTRUCT()
+struct FFishingSoakPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UFishingSoakSubsystem* Target = nullptr;
+	bool bStart = true;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override { return TEXT("FFishingSoakPhysicsTickFunction"); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FFishingSoakPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FFishingSoakPhysicsTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * Headless soak test of the fishing loop.
+ * Spawns N anglers driven by scripted input through the full ReadyThrowCast -> ThrowCast -> LaunchHook -> StartFishing -> FishBite -> ReelHook cycle
+ * and writes game thread, physics and memory figures per angler count to Saved/Profiling/FishingSoak as CSV and JSON.
+ *
+ * Start it with "Fishing.Soak 1,16,128,512 [Seconds]" or from the command line:
+ *   FishingGame FishingLake -game -nullrhi -unattended -FishingSoak=1,16,128,512 -FishingSoakSeconds=30
+ * Unattended runs quit when the last angler count is done.
+ *
+ * To measure replication, run it on a dedicated server and connect a few headless clients before it starts:
+ *   FishingGameServer FishingLake -log -unattended -FishingSoak=16,128 -FishingSoakDelay=20
+ *   FishingGame 127.0.0.1 -game -nullrhi -unattended (once per client)
+ * The report then includes the server's outgoing bytes per second per angler and client.
+ *
+ * Crowd runs ("Fishing.CrowdSoak 16,128,512" or -FishingCrowd next to -FishingSoak=) spawn NPC anglers driven by AFishingAIController instead,
+ * so the report shows the game thread cost of the crowd under UFishingSignificanceSubsystem per angler count. Pin every angler to one
+ * significance level with "Fishing.Significance <Level>" first to measure that level alone.
+ *
+ * The whole soak is also captured by the CSV profiler next to the report, with the Fishing category timing every step of the cast loop
+ * and an event marking the start of each run.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingSoakSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** bInCrowd runs NPC anglers instead of scripted player controllers. */
+	void StartSoak(const TArray<int32>& InAnglerCounts, float InSecondsPerRun, bool bInCrowd = false);
+
+	FORCEINLINE bool IsRunning() const { return AnglerCounts.IsValidIndex(RunIndex); }
+
+	void OnPhysicsTick(bool bStart);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	enum class EAnglerStep : uint8
+	{
+		Idle,
+		Charging,
+		Launching,
+		HookInFlight,
+		WaitingForBite,
+		Reacting
+	};
+
+	struct FSoakAngler
+	{
+		TWeakObjectPtr<AFishingGameCharacter> Character;
+		TWeakObjectPtr<AController> Controller;
+		EAnglerStep Step = EAnglerStep::Idle;
+		float StepTime = 0.f;
+		float StepDuration = 0.f;
+	};
+
+	struct FSoakRunResult
+	{
+		int32 Anglers = 0;
+		bool bCrowd = false;
+		int32 Frames = 0;
+		double SpawnMsPerAngler = 0.0;
+		double MemoryKBPerAngler = 0.0;
+		double AvgFrameMs = 0.0;
+		double AvgGameThreadMs = 0.0;
+		double P95GameThreadMs = 0.0;
+		double AvgPhysicsMs = 0.0;
+		double AvgLineSolveMs = 0.0;
+		double AvgSimulatedLines = 0.0;
+		double AvgActorsTicked = 0.0;
+		double AvgSignificantAnglers = 0.0;
+		int32 NetClients = 0;
+		double NetBytesPerSecPerAngler = 0.0;
+		int32 Casts = 0;
+		int32 Catches = 0;
+		double UsedMBPerCast = 0.0;
+		double PeakUsedMB = 0.0;
+	};
+
+	void BeginRun();
+	void EndRun();
+	void SpawnAnglers(int32 Count);
+	void DestroyAnglers();
+	void StepAngler(FSoakAngler& Angler, float DeltaTime);
+	void WriteReport() const;
+	void EndCsvCapture();
+
+	TArray<int32> AnglerCounts;
+	int32 RunIndex = INDEX_NONE;
+	float SecondsPerRun = 30.f;
+	float RunTime = 0.f;
+	bool bCheckedCommandLine = false;
+	bool bCrowd = false;
+
+	/** The running CSV profile was started by the soak and has to be ended by it. */
+	bool bCapturingCsv = false;
+
+	/** Command line soak waiting for StartDelay to run out. */
+	TArray<int32> PendingCounts;
+	float PendingSeconds = 30.f;
+	bool bPendingCrowd = false;
+	float StartDelay = 0.f;
+
+	TArray<FSoakAngler> Anglers;
+	TArray<float> GameThreadMs;
+	double PhysicsMsTotal = 0.0;
+	double PhysicsStartTime = 0.0;
+	double LineSolveMsTotal = 0.0;
+	int64 SimulatedLinesTotal = 0;
+	int64 ActorsTickedTotal = 0;
+	int64 SignificantAnglersTotal = 0;
+	uint32 NetOutBytesAtStart = 0;
+	double NetMeasureStartTime = 0.0;
+	double FrameMsTotal = 0.0;
+	uint64 UsedPhysicalAtStart = 0;
+	FSoakRunResult CurrentRun;
+	TArray<FSoakRunResult> Results;
+	FRandomStream Random;
+
+	FFishingSoakPhysicsTickFunction StartPhysicsTick;
+	FFishingSoakPhysicsTickFunction EndPhysicsTick;
+};
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingStreamingSubsystem.generated.h"
+
+class ULevelStreamingDynamic;
+
+/**
+ * Streams the grid-cell sublevels of a large lake around the player pawns.
+ * The persistent level keeps what is always needed (sky, water body, gameplay actors) and lists its sublevels, named
+ * <Map>_Cell_<X>_<Y> for the cell spanning [X, X + 1) * CellSize by [Y, Y + 1) * CellSize, with the Blueprint streaming method
+ * and nothing initially loaded. A few times a second cells closer than LoadRadius to a pawn start loading asynchronously, at
+ * most MaxPendingLoads at a time and closest first, and cells farther than UnloadRadius from every pawn are unloaded, so
+ * walking back and forth on a cell border doesn't thrash. Cells around the spot a hook is about to land on load before any other.
+ * NPCs and props belonging to a cell should live in its sublevel, so they stream with the ground under them.
+ *
+ * A locally controlled pawn standing on a cell that isn't visible yet blocks the game until it is; a server only streams for
+ * remote pawns. These stalls are what the walking speed, LoadRadius and MaxPendingLoads should be tuned against;
+ * Fishing.StreamingLap walks a lap of the map and reports them together with the memory resident along the way.
+ *
+ * None of the project's maps is split into cells yet, so until one is this finds no cells and stays idle.
+ */
+UCLASS(Config = Game)
+class FISHINGGAME_API UFishingStreamingSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Side of a cell, in cm. */
+	UPROPERTY(Config)
+	float CellSize = 10000.f;
+
+	/** Cells closer than this to a pawn are loaded. */
+	UPROPERTY(Config)
+	float LoadRadius = 15000.f;
+
+	/** Loaded cells are kept until they are farther than this from every pawn. */
+	UPROPERTY(Config)
+	float UnloadRadius = 22000.f;
+
+	/** Cells loading at once, more queue behind them. */
+	UPROPERTY(Config)
+	int32 MaxPendingLoads = 2;
+
+	/** Seconds between two streaming updates. */
+	UPROPERTY(Config)
+	float UpdateInterval = 0.1f;
+
+	/** Cells closer than this to a predicted hook landing load first, for HintDuration seconds. */
+	UPROPERTY(Config)
+	float HintRadius = 2000.f;
+
+	UPROPERTY(Config)
+	float HintDuration = 5.f;
+
+	/** Loads the cells around Location ahead of every other, e.g. where a cast is about to land. */
+	void PrioritizeLocation(const FVector& Location);
+
+	/** Walks the first local player's pawn a lap of Radius around the middle of the cell grid and logs memory and stalls. */
+	void StartLap(float Radius, float MaxSeconds);
+
+	FORCEINLINE int32 GetNumCells() const { return Cells.Num(); }
+
+	FORCEINLINE int32 GetNumLoadedCells() const { return NumLoaded; }
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return !bDiscovered || Cells.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FStreamingCell
+	{
+		TWeakObjectPtr<ULevelStreamingDynamic> Level;
+		FBox2D Bounds;
+		/** Squared distance to the closest pawn as of the last update. */
+		float DistanceSq = 0.f;
+		bool bHinted = false;
+	};
+
+	struct FHint
+	{
+		FVector2D Location;
+		float ExpireTime = 0.f;
+	};
+
+	struct FLap
+	{
+		FVector2D Center = FVector2D::ZeroVector;
+		float Radius = 0.f;
+		float Angle = 0.f;
+		float Travelled = 0.f;
+		float Time = 0.f;
+		float MaxTime = 0.f;
+		TWeakObjectPtr<APawn> Pawn;
+		int32 Frames = 0;
+		int32 CellLoads = 0;
+		int32 CellUnloads = 0;
+		int32 Stalls = 0;
+		double StallSeconds = 0.0;
+		double MaxStallSeconds = 0.0;
+		double SumUsedMB = 0.0;
+		double PeakUsedMB = 0.0;
+		int32 SumLoadedCells = 0;
+		int32 PeakLoadedCells = 0;
+	};
+
+	/** Collects the world's sublevels named after a grid cell. */
+	void DiscoverCells();
+
+	void UpdateStreaming();
+
+	/** Blocks until the cell under every locally controlled pawn is visible. */
+	void FlushCellsUnderPawns();
+
+	/** Locations of the player pawns, the OutNumLocal locally controlled ones first. */
+	void GetPawnLocations(TArray<FVector2D>& OutLocations, int32& OutNumLocal) const;
+
+	const FStreamingCell* FindCellAt(const FVector2D& Location) const;
+
+	void StepLap(float DeltaTime);
+
+	void EndLap();
+
+	TMap<FIntPoint, FStreamingCell> Cells;
+	TArray<FHint> Hints;
+	TArray<FVector2D> PawnLocations;
+	int32 NumLocalPawns = 0;
+	TArray<FStreamingCell*> LoadQueue;
+	int32 NumLoaded = 0;
+	float UpdateTime = 0.f;
+	bool bDiscovered = false;
+
+	/** The local pawns' first cells are in, from now on waiting for one is a stall. */
+	bool bStartCellsLoaded = false;
+
+	TOptional<FLap> Lap;
+	bool bCapturingCsv = false;
+};
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FishingWaveSubsystem.generated.h"
+
+class UMaterialParameterCollection;
+
+/**
+ * One of the MF_GerstnerWave calls summed by MF_GerstnerWave_Combined: the Direction constant it passes in, rotated by the
+ * collection's wind direction, and the constants it multiplies the collection's wave length, speed and amplitude by.
+ */
+USTRUCT()
+struct FFishingWaveComponent
+{
+	GENERATED_BODY()
+
+	/** Not normalized, the material normalizes it after the wind rotation. */
+	UPROPERTY()
+	FVector2D Direction = FVector2D(1.f, 0.f);
+
+	UPROPERTY()
+	float WaveLengthScale = 1.f;
+
+	UPROPERTY()
+	float SpeedScale = 1.f;
+
+	UPROPERTY()
+	float AmplitudeScale = 1.f;
+};
+
+/**
+ * CPU mirror of the water material's Gerstner waves, read from the same material parameter collection every frame,
+ * so the hook and anything floating sit on the surface the player sees. The per-wave constants of MF_GerstnerWave_Combined
+ * only exist in the material graph, which cooked builds don't keep, so Waves defaults to a copy of them.
+ *
+ * Queries are evaluated four points at a time in vector registers. The material displaces vertices sideways as well as up,
+ * so the height above a point is found by walking back the horizontal displacement a few times first.
+ * Components added as floaters are moved to the surface in one batch per frame.
+ */
+UCLASS(Config = Game)
+class FISHINGGAME_API UFishingWaveSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UFishingWaveSubsystem();
+
+	/** Collection driving the water material. */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UMaterialParameterCollection> WaveCollection;
+
+	/** Has to match MF_GerstnerWave_Combined, update both together. */
+	UPROPERTY(Config)
+	TArray<FFishingWaveComponent> Waves;
+
+	/** Rounds of undoing the horizontal displacement before reading the height. More converge better on steep waves. */
+	UPROPERTY(Config)
+	int32 HeightIterations = 3;
+
+	/** Wave height at each Points[i], relative to the water's rest level. */
+	void GetWaveHeights(TArrayView<const FVector2D> Points, TArrayView<float> OutHeights);
+
+	/** Water surface above or below Location for water resting at RestHeight. */
+	UFUNCTION(BlueprintCallable, Category = "FishingGame|Water")
+	float GetWaterSurfaceHeight(FVector Location, float RestHeight);
+
+	/** Keeps Component on the surface of water resting at RestHeight until removed. It must be movable. */
+	UFUNCTION(BlueprintCallable, Category = "FishingGame|Water")
+	void AddFloater(USceneComponent* Component, float RestHeight, float Offset = 0.f);
+
+	UFUNCTION(BlueprintCallable, Category = "FishingGame|Water")
+	void RemoveFloater(USceneComponent* Component);
+
+	/**
+	 * MF_GerstnerWave transcribed node for node at Point, in double precision and sharing nothing with the batched path.
+	 * Reference for the benchmark.
+	 */
+	FVector GetReferenceDisplacement(const FVector2D& Point, double Time);
+
+	FORCEINLINE double GetWaveTime() const { return WaveTime; }
+
+	virtual void Initialize(FSubsystemCollectionBase& SubsystemCollection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override { return Floaters.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+
+private:
+	/** Per-wave constants for the current frame, splatted across the four lanes. */
+	struct FWaveLanes
+	{
+		VectorRegister KDirX;
+		VectorRegister KDirY;
+		VectorRegister PhaseShift;
+		VectorRegister QADirX;
+		VectorRegister QADirY;
+		VectorRegister Amplitude;
+	};
+
+	struct FFloater
+	{
+		TWeakObjectPtr<USceneComponent> Component;
+		FVector2D Location;
+		float RestHeight;
+		float Offset;
+	};
+
+	/** Collection values, read once per frame. */
+	struct FWaveParams
+	{
+		float Amplitude = 0.f;
+		float Steepness = 0.f;
+		float WaveLength = 1000.f;
+		float Speed = 1.f;
+		/** Wind direction as a fraction of a turn, what CustomRotator takes. */
+		float WindDirection = 0.f;
+		float NumWaves = 1.f;
+	};
+
+	/** Reads the collection and rebuilds WaveLanes, at most once per frame. */
+	void Refresh();
+
+	void GetWaveHeights4(VectorRegister X, VectorRegister Y, VectorRegister& OutHeight) const;
+
+	void GetDisplacement4(VectorRegister X, VectorRegister Y, VectorRegister& OutX, VectorRegister& OutY, VectorRegister& OutZ) const;
+
+	TArray<FWaveLanes, TAlignedHeapAllocator<16>> WaveLanes;
+	TArray<FFloater> Floaters;
+	FWaveParams Params;
+	double WaveTime = 0.0;
+	uint64 RefreshFrame = MAX_uint64;
+
+	UPROPERTY(Transient)
+	UMaterialParameterCollection* Collection;
+
+	// Floater batch scratch
+	TArray<FVector2D> FloaterPoints;
+	TArray<float> FloaterHeights;
+};
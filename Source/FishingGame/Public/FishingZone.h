@@ -14,11 +14,45 @@ class FISHINGGAME_API AFishingZone : public AActor
 public:	
 	AFishingZone();
 
+	FORCEINLINE class UBoxComponent* GetZoneBox() const { return BoxComp; }
+
+	/** Wait before a bite in this zone, or DefaultWaitTime when the zone doesn't override it. */
+	FORCEINLINE float GetFishingWaitTime(float DefaultWaitTime) const { return bOverrideFishingWaitTime ? FishingWaitTime : DefaultWaitTime; }
+
+	FORCEINLINE int32 GetFishPopulation() const { return FishPopulation; }
+
+	FORCEINLINE int32 GetSchoolSize() const { return SchoolSize; }
+
+	FORCEINLINE const class UDataTable* GetLootTable() const { return LootTable; }
+
+	/** Height of the water at rest, the top of the zone's box. */
+	float GetWaterLevel() const;
+
 protected:
 
 	UPROPERTY(VisibleAnywhere, Category = "Component")
 	class UBoxComponent* BoxComp;
 
-public:
-	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Settings", meta = (InlineEditConditionToggle))
+	bool bOverrideFishingWaitTime = false;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Settings", meta = (EditCondition = "bOverrideFishingWaitTime"))
+	float FishingWaitTime = 3.f;
+
+	/** Fish simulated in this zone. With fish, bites happen when a hungry fish reaches the hook instead of after FishingWaitTime. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish", meta = (ClampMin = "0"))
+	int32 FishPopulation = 0;
+
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish", meta = (ClampMin = "4"))
+	int32 SchoolSize = 32;
+
+	/** FishSpeciesRow table deciding what bites here and how big it is. Without one every bite is the same unknown fish. */
+	UPROPERTY(EditAnywhere, Category = "FishingGame|Fish", meta = (RequiredAssetDataTags = "RowStructure=FishSpeciesRow"))
+	class UDataTable* LootTable;
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void OnZoneMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
 };
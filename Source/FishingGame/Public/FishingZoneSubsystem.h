@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FishingZoneSubsystem.generated.h"
+
+class AFishingZone;
+
+/**
+ * Registry of every fishing zone in the world.
+ * Zone boxes are bucketed into a uniform 2D hash grid so "which zone is this point in" is a single cell lookup,
+ * answered without any physics overlap or query. "Fishing.ZoneBench" times it on thousands of synthetic zones.
+ */
+UCLASS()
+class FISHINGGAME_API UFishingZoneSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Edge length of a grid cell. Zones larger than a cell are referenced from every cell they touch. */
+	static constexpr float CellSize = 2000.f;
+
+	void RegisterZone(AFishingZone* Zone);
+
+	void UnregisterZone(AFishingZone* Zone);
+
+	/** Re-buckets a zone after it moved, only the cells it left or entered are touched. */
+	void UpdateZone(AFishingZone* Zone);
+
+	AFishingZone* FindZoneAtPoint(const FVector& Point) const;
+
+	/** FindZoneAtPoint for worker threads: never touches a UObject, resolve the index with GetZone on the game thread. INDEX_NONE if none. */
+	int32 FindZoneIndexAtPoint(const FVector& Point) const;
+
+	FORCEINLINE AFishingZone* GetZone(int32 ZoneIndex) const { return Entries.IsValidIndex(ZoneIndex) ? Entries[ZoneIndex].Zone.Get() : nullptr; }
+
+	/** First zone the segment enters, walking the grid cells along it. */
+	AFishingZone* FindZoneAlongSegment(const FVector& Start, const FVector& End, FVector* OutEntryPoint = nullptr) const;
+
+	FORCEINLINE int32 GetNumZones() const { return NumZones; }
+
+	/** Fills this subsystem, which must be a throwaway one, with InNumZones zones without actors and times queries and moves. */
+	void RunBenchmark(int32 InNumZones, int32 NumQueries);
+
+private:
+	struct FZoneEntry
+	{
+		TWeakObjectPtr<AFishingZone> Zone;
+		FTransform Transform;
+		FVector Extent = FVector::ZeroVector;
+		/** Inclusive on both ends. */
+		FIntRect Cells;
+	};
+
+	static void SetEntryBox(FZoneEntry& Entry, const FTransform& Transform, const FVector& Extent);
+
+	/** Re-buckets the entry for its new box, only in the cells it left or entered. */
+	void MoveEntry(int32 EntryIndex, const FTransform& Transform, const FVector& Extent);
+
+	/** Cells in Skip are left alone. */
+	void AddToCells(int32 EntryIndex, const FIntRect& Cells, const FIntRect* Skip = nullptr);
+	void RemoveFromCells(int32 EntryIndex, const FIntRect& Cells, const FIntRect* Skip = nullptr);
+
+	bool ContainsPoint(const FZoneEntry& Entry, const FVector& Point) const;
+
+	/** Fraction along Start-End where the segment enters the zone box, negative if it misses. */
+	float GetSegmentEntryTime(const FZoneEntry& Entry, const FVector& Start, const FVector& End) const;
+
+	static FIntPoint GetCell(const FVector& Location);
+
+	static bool IsCellIn(const FIntRect& Cells, int32 X, int32 Y);
+
+	TArray<FZoneEntry> Entries;
+	TArray<int32> FreeEntries;
+	TMap<TWeakObjectPtr<AFishingZone>, int32> EntryByZone;
+	TMap<FIntPoint, TArray<int32>> Grid;
+	int32 NumZones = 0;
+};